@@ -0,0 +1,117 @@
+/**
+ * @file BinaryProtocol.h
+ * @brief Compact binary framing for the serial protocol (MODE BINARY)
+ *
+ * ASCII v2 stays the default. After MODE BINARY both directions switch to
+ * frames of the form (before encoding):
+ *
+ *   [0]    opcode    - CommandAction (Pi -> Arduino) or EventType
+ *                      (Arduino -> Pi) value; bit 7 set if an ID follows
+ *   [1]    position  - Position letter 'A'-'Y', or 0 if none
+ *   [..]   id        - Command ID, unsigned LEB128 varint (if bit 7 set)
+ *   [..]   payload   - Commands: optional varint argument (MODE), for
+ *                      FRAME followed by raw RGB pixel bytes
+ *                      Events: type-specific, see docs
+ *   [n-1]  crc       - CRC-8 (poly 0x07, init 0) over bytes [0..n-2]
+ *
+ * Each frame is COBS encoded and terminated by a single 0x00, so the
+ * receiver can resynchronise on the next delimiter after any corruption.
+ * A TOUCHED_DOWN with an ID is 6 bytes on the wire instead of ~30.
+ */
+
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// Frame Layout
+// ============================================================================
+
+// Opcode bit 7: command ID varint follows the position byte
+constexpr uint8_t BINARY_FLAG_HAS_ID = 0x80;
+constexpr uint8_t BINARY_OPCODE_MASK = 0x7F;
+
+// Frame terminator (never appears inside a COBS encoded frame)
+constexpr uint8_t BINARY_FRAME_DELIMITER = 0x00;
+
+// Largest unencoded frame, including CRC (fits an INFO text payload)
+constexpr size_t BINARY_MAX_FRAME_LEN = 96;
+
+// Largest encoded frame, including COBS overhead and delimiter
+constexpr size_t BINARY_MAX_ENCODED_LEN = BINARY_MAX_FRAME_LEN + BINARY_MAX_FRAME_LEN / 254 + 2;
+
+// ============================================================================
+// BinaryProtocol Helpers
+// ============================================================================
+
+class BinaryProtocol {
+public:
+    /**
+     * @brief Compute CRC-8 (poly 0x07, init 0)
+     * @param data Input bytes
+     * @param len Number of bytes
+     * @return CRC
+     */
+    static uint8_t crc8(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Write an unsigned LEB128 varint
+     * @param out Output (room for 5 bytes)
+     * @param value Value to write
+     * @return Number of bytes written (1-5)
+     */
+    static size_t putVarint(uint8_t* out, uint32_t value);
+
+    /**
+     * @brief Read an unsigned LEB128 varint
+     * @param in Input bytes
+     * @param len Bytes available
+     * @param value Output value
+     * @return Number of bytes consumed, 0 if truncated or too long
+     */
+    static size_t getVarint(const uint8_t* in, size_t len, uint32_t& value);
+
+    /**
+     * @brief Append the CRC, COBS encode and terminate a frame
+     * @param frame Frame bytes, with one spare byte at the end for the CRC
+     * @param len Frame length without CRC
+     * @param out Output (BINARY_MAX_ENCODED_LEN bytes for a full frame)
+     * @return Number of bytes to send, including the delimiter
+     */
+    static size_t finishFrame(uint8_t* frame, size_t len, uint8_t* out);
+
+    /**
+     * @brief Decode a received frame (delimiter already stripped) and check its CRC
+     * @param in Encoded bytes
+     * @param len Encoded length
+     * @param out Decoded frame (at least len bytes)
+     * @return Frame length without CRC, 0 if malformed or CRC mismatch
+     */
+    static size_t openFrame(const uint8_t* in, size_t len, uint8_t* out);
+
+    /**
+     * @brief Decode standard base64 (ASCII FRAME pixel data)
+     * @param in Base64 text, padding optional
+     * @param len Text length
+     * @param out Output bytes
+     * @param size Output capacity
+     * @return Number of bytes decoded, 0 if malformed or too long
+     */
+    static size_t base64Decode(const char* in, size_t len, uint8_t* out, size_t size);
+
+private:
+    /**
+     * @brief COBS encode (no delimiter)
+     * @return Encoded length
+     */
+    static size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+
+    /**
+     * @brief COBS decode
+     * @return Decoded length, 0 if malformed
+     */
+    static size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out);
+};
+
+#endif // BINARY_PROTOCOL_H
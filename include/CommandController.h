@@ -13,12 +13,34 @@
  *   STOP_BLINK <pos> [#id]     - Stop blinking LED at position
  *   EXPECT_DOWN <pos> [#id]    - Wait for touch, then emit TOUCHED_DOWN
  *   EXPECT_UP <pos> [#id]      - Wait for release, then emit TOUCHED_UP
- *   RECALIBRATE <pos> [#id]    - Recalibrate single touch sensor
- *   RECALIBRATE_ALL [#id]      - Recalibrate all touch sensors
+ *   RECALIBRATE <pos> [#id]    - Recalibrate single touch sensor, RECALIBRATED
+ *                                once the chip reports it finished
+ *   RECALIBRATE_ALL [#id]      - Recalibrate all touch sensors (all chips at once)
+ *   SENSITIVITY <pos> <0-7> [#id] - Set the sensitivity of the position's
+ *                                chip (0 = most sensitive), stored
+ *   THRESHOLD <pos> <0-127> [#id] - Set the position's touch threshold, stored
  *   SCAN [#id]                 - Scan I2C, return SCANNED[A,B,C,...]
  *   SEQUENCE_COMPLETED [#id]   - Play celebration animation on all LEDs
  *   INFO [#id]                 - Return firmware info
  *   PING [#id]                 - Respond with ACK
+ *   MODE <BINARY|ASCII> [#id]  - Switch serial framing (see BinaryProtocol.h)
+ *   BAUD <rate> [#id]          - Switch UART rate; DONE once a command
+ *                                arrives at the new rate
+ *   STATS [#id]                - Report event queue statistics (and the
+ *                                loop profile with ENABLE_PROFILER)
+ *   BATCH [#id] ... END        - Apply the enclosed LED commands in one frame,
+ *                                with a single ACK BATCH on END
+ *   FRAME <offset> <base64> [#id] - Write raw RGB pixels into the stream
+ *                                layer, starting at framebuffer offset
+ *                                (no pixels: clear it from the offset on)
+ *   PLAY <effect> [pos] [#id]  - Play a keyframed effect by ID (see
+ *                                Effects.h); DONE when it finishes
+ *   LATENCY <ON|OFF> [#id]     - Timestamp touch-downs and answer the next
+ *                                LED command on that position with LATENCY
+ *   MEM [#id]                  - Report free stack/heap and RAM per component
+ *
+ * SHOW, HIDE, BLINK and STOP_BLINK also accept a position list (A,C,F),
+ * applied in the same frame and acknowledged once.
  */
 
 #ifndef COMMAND_CONTROLLER_H
@@ -31,11 +53,13 @@
 class LedController;
 class TouchController;
 class EventQueue;
+enum class EventSource : uint8_t;
 
 // ============================================================================
 // Command Types
 // ============================================================================
 
+// Values double as binary protocol opcodes - append new actions at the end
 enum class CommandAction : uint8_t {
     INVALID = 0,
     SHOW,
@@ -50,9 +74,23 @@ enum class CommandAction : uint8_t {
     SCAN,
     SEQUENCE_COMPLETED,
     INFO,
-    PING
+    PING,
+    MODE,
+    BAUD,
+    STATS,
+    BATCH,
+    END,
+    FRAME,
+    PLAY,
+    LATENCY,
+    SENSITIVITY,
+    THRESHOLD,
+    MEM
 };
 
+// Number of opcodes (keep in sync with the last CommandAction)
+constexpr uint8_t COMMAND_ACTION_COUNT = static_cast<uint8_t>(CommandAction::MEM) + 1;
+
 // ============================================================================
 // Parsed Command Structure
 // ============================================================================
@@ -60,10 +98,16 @@ enum class CommandAction : uint8_t {
 struct ParsedCommand {
     CommandAction action;
     bool hasPosition;
-    char position;          // 'A'-'Y'
-    uint8_t positionIndex;  // 0-24
+    char position;          // 'A'-'Y', or 0 for a position list
+    uint8_t positionIndex;  // 0-24, or 255 for a position list
+    uint32_t positionMask;  // All positions (bit 0 = A)
     bool hasId;
     uint32_t id;
+    bool hasArg;
+    uint32_t arg;           // MODE: 1 = BINARY, 0 = ASCII; BAUD: rate; FRAME: offset;
+                            // SENSITIVITY: level; THRESHOLD: threshold
+    const uint8_t* pixels;  // FRAME: RGB bytes (valid until the command executes)
+    uint16_t pixelCount;    // FRAME: number of pixels
     bool valid;
 };
 
@@ -71,10 +115,41 @@ struct ParsedCommand {
 // Command Queue Entry (for long-running commands)
 // ============================================================================
 
+// Scheduler lanes, ticked in this order. Animation bookkeeping only runs
+// while the event queue still has room for replies to new commands.
+enum class CommandLane : uint8_t {
+    CONTROL = 0,    // BAUD, SCAN, RECALIBRATE, RECALIBRATE_ALL
+    ANIMATION       // SUCCESS, SEQUENCE_COMPLETED
+};
+
+constexpr uint8_t COMMAND_LANE_COUNT = 2;
+
+// End of a slot list
+constexpr uint8_t NO_COMMAND_SLOT = 0xFF;
+static_assert(COMMAND_QUEUE_SIZE < NO_COMMAND_SLOT, "COMMAND_QUEUE_SIZE too large");
+
+#if COMPACT_COMMAND_QUEUE
+// The fields of ParsedCommand a long-running command still reads after
+// queueCommand() (same names, so both layouts share the tick code)
+struct QueuedArguments {
+    CommandAction action;
+    char position;          // 'A'-'Y', or 0 for none
+    uint8_t positionIndex;  // 0-24, or 255 for none
+    bool hasId;
+    uint32_t id;
+    uint32_t arg;           // BAUD: rate
+};
+#else
+typedef ParsedCommand QueuedArguments;
+#endif
+
 struct QueuedCommand {
-    ParsedCommand command;
+    QueuedArguments command;
     bool active;
+    CommandLane lane;
+    uint8_t next;           // Next slot in the lane or free list
     uint32_t startTime;
+    uint32_t dueTime;       // Next time the command needs a tick
     uint8_t state;          // Command-specific state machine state
     uint8_t scanAddress;    // For SCAN: current address being scanned
 };
@@ -108,6 +183,7 @@ public:
 
     /**
      * @brief Process any complete lines in the buffer
+     * Stops early while the event queue has no room for the replies
      */
     void processCompletedLines();
 
@@ -129,25 +205,86 @@ public:
      */
     void injectCommand(const char* line);
 
+    /**
+     * @brief Check if incoming data is parsed as binary frames
+     * @return true after MODE BINARY
+     */
+    bool isBinaryMode() const;
+
+    /**
+     * @brief Choose the event source for animation DONE events
+     * SUCCESS, SEQUENCE_COMPLETED and PLAY completions go there; ACKs stay
+     * on LOOP and are still sent first.
+     * @param source Event source (default LOOP)
+     */
+    void setAnimationEventSource(EventSource source);
+
+    /**
+     * @brief Parse action string to enum
+     * @param str Action string
+     * @param len Length of string
+     * @return CommandAction enum value
+     */
+    static CommandAction parseAction(const char* str, size_t len);
+
+    /**
+     * @brief Get action name string
+     * @param action Action enum
+     * @return Action name
+     */
+    static const char* actionToString(CommandAction action);
+
 private:
     // References
     LedController& m_ledController;
     TouchController* m_touchController;
     EventQueue& m_eventQueue;
 
+    // Source for animation DONE events
+    EventSource m_animationSource;
+
     // Ring buffer for incoming serial data
-    char m_rxBuffer[MAX_LINE_LEN * 2];
-    uint8_t m_rxHead;
-    uint8_t m_rxTail;
+    char m_rxBuffer[RX_BUFFER_SIZE];
+    uint16_t m_rxHead;
+    uint16_t m_rxTail;
+
+    // Delimiter search position (bytes from tail to here have none)
+    uint16_t m_rxScan;
+
+    // Skipping incoming bytes up to the next delimiter after an overflow
+    bool m_rxDiscarding;
 
     // Line buffer for parsing
     char m_lineBuffer[MAX_LINE_LEN];
-    uint8_t m_lineIndex;
+    uint16_t m_lineIndex;
     bool m_lineOverflow;
 
+    // Decoded FRAME pixels of an ASCII line
+    uint8_t m_pixelData[FRAME_MAX_PIXELS * 3];
+
+    // Incoming framing: false = ASCII lines, true = COBS frames
+    bool m_binaryMode;
+
+    // UART rate, and the rate to fall back to if a BAUD switch is not confirmed
+    uint32_t m_baudRate;
+    uint32_t m_fallbackBaudRate;
+
+    // Set by every command parsed from the serial port (not by
+    // injectCommand()); confirms a BAUD switch
+    bool m_linkConfirmed;
+
+    // Open BATCH block
+    bool m_batchActive;
+    uint32_t m_batchId;
+    uint32_t m_batchStart;
+
     // Command queue for long-running commands
     QueuedCommand m_commandQueue[COMMAND_QUEUE_SIZE];
 
+    // Free slots, and active slots per lane sorted by due time
+    uint8_t m_freeHead;
+    uint8_t m_laneHead[COMMAND_LANE_COUNT];
+
     // === Serial/Parsing Methods ===
 
     /**
@@ -165,19 +302,69 @@ private:
     bool parseLine(const char* line, ParsedCommand& cmd);
 
     /**
-     * @brief Parse action string to enum
-     * @param str Action string
-     * @param len Length of string
-     * @return CommandAction enum value
+     * @brief Extract next complete binary frame from ring buffer
+     * Encoded bytes are left in the line buffer
+     * @return true if a frame (or an overflow) was extracted
      */
-    static CommandAction parseAction(const char* str, size_t len);
+    bool extractFrame();
 
     /**
-     * @brief Get action name string
-     * @param action Action enum
-     * @return Action name
+     * @brief Advance m_rxScan to the next delimiter for the current framing
+     * @return true if m_rxScan points at a delimiter
      */
-    static const char* actionToString(CommandAction action);
+    bool scanForDelimiter();
+
+    /**
+     * @brief Get number of bytes in the ring buffer
+     * @return Pending bytes
+     */
+    uint16_t rxPending() const;
+
+    /**
+     * @brief Get distance between two ring buffer positions
+     * @param from Start position
+     * @param to End position
+     * @return Bytes from start to end
+     */
+    uint16_t rxDistance(uint16_t from, uint16_t to) const;
+
+    /**
+     * @brief Drop bytes from the ring buffer tail
+     * @param count Number of bytes (at most rxPending())
+     */
+    void discardRx(uint16_t count);
+
+    /**
+     * @brief Remove the incomplete message at the ring buffer head
+     * @return Number of bytes removed
+     */
+    uint16_t dropPartialMessage();
+
+    /**
+     * @brief Check if a byte ends a message in the current framing
+     * @param c Received byte
+     * @return true for '\n'/'\r' (ASCII) or 0x00 (binary)
+     */
+    bool isDelimiter(char c) const;
+
+    /**
+     * @brief Empty the ring buffer
+     */
+    void resetRx();
+
+    /**
+     * @brief Decode and execute the frame in the line buffer
+     */
+    void processFrame();
+
+    /**
+     * @brief Parse a decoded binary frame into a ParsedCommand struct
+     * @param frame Frame bytes (CRC already checked and removed)
+     * @param len Frame length
+     * @param cmd Output parsed command
+     * @return true if parsing succeeded
+     */
+    bool parseFrame(const uint8_t* frame, size_t len, ParsedCommand& cmd);
 
     /**
      * @brief Check if action requires a position argument
@@ -186,6 +373,47 @@ private:
      */
     static bool actionRequiresPosition(CommandAction action);
 
+    /**
+     * @brief Check if action requires an argument (MODE, BAUD)
+     * @param action Action enum
+     * @return true if an argument is required
+     */
+    static bool actionRequiresArgument(CommandAction action);
+
+    /**
+     * @brief Check if action accepts a position list (A,C,F)
+     * @param action Action enum
+     * @return true for the instant LED commands
+     */
+    static bool actionAcceptsPositionList(CommandAction action);
+
+    /**
+     * @brief Parse a comma-separated position list
+     * @param str Token string
+     * @param len Token length
+     * @param mask Output position mask (bit 0 = A)
+     * @return true if every entry is a valid position
+     */
+    static bool parsePositionList(const char* str, size_t len, uint32_t& mask);
+
+    /**
+     * @brief Parse an ASCII argument token
+     * @param action Action enum
+     * @param str Token string
+     * @param len Token length
+     * @param arg Output argument value
+     * @return true if the token is an argument of this action
+     */
+    static bool parseArgument(CommandAction action, const char* str, size_t len, uint32_t& arg);
+
+    /**
+     * @brief Check an argument value against what the action accepts
+     * @param action Action enum
+     * @param arg Argument value
+     * @return true if supported
+     */
+    static bool argumentIsValid(CommandAction action, uint32_t arg);
+
     /**
      * @brief Check if action is long-running (needs DONE event)
      * @param action Action enum
@@ -216,9 +444,66 @@ private:
 
     /**
      * @brief Tick a single queued command
+     * Clear qc.active when done, or move qc.dueTime to defer the next tick
+     * (defaults to the next millisecond).
      * @param qc Queued command entry
+     * @param now Current time from millis()
+     */
+    void tickCommand(QueuedCommand& qc, uint32_t now);
+
+    /**
+     * @brief Tick the due commands of one lane
+     * @param lane Lane to tick
+     * @param now Current time from millis()
+     * @param reserveSlots Event slots to leave free for other replies
+     */
+    void tickLane(CommandLane lane, uint32_t now, uint8_t reserveSlots);
+
+    /**
+     * @brief Insert an active slot into its lane by due time
+     * @param slot Slot index
+     */
+    void schedule(uint8_t slot);
+
+    /**
+     * @brief Check if a command with this action is in flight
+     * @param action Action enum
+     * @return true if queued
+     */
+    bool isQueued(CommandAction action) const;
+
+    /**
+     * @brief Get the scheduler lane of a long-running action
+     * @param action Action enum
+     * @return Lane
+     */
+    static CommandLane laneFor(CommandAction action);
+
+    /**
+     * @brief Apply SHOW/HIDE/BLINK/STOP_BLINK to every position in the mask
+     * @param cmd Parsed command
+     * @return true if all positions succeeded
+     */
+    bool applyLedCommand(const ParsedCommand& cmd);
+
+    /**
+     * @brief Answer waiting touch-downs on the command's positions (latency mode)
+     * @param cmd Executed LED command (SHOW/HIDE/BLINK/STOP_BLINK/SUCCESS/PLAY)
+     * @param rxUs micros() when execution started
+     */
+    void echoLatency(const ParsedCommand& cmd, uint32_t rxUs);
+
+    /**
+     * @brief Close the open BATCH block and release the held LED frame
+     */
+    void endBatch();
+
+    /**
+     * @brief Reopen the UART at a new rate
+     * Waits for pending TX at the old rate; drops buffered RX bytes.
+     * @param baud New baud rate
      */
-    void tickCommand(QueuedCommand& qc);
+    void setBaudRate(uint32_t baud);
 
     // === Utility Methods ===
 
@@ -24,22 +24,117 @@
 // ============================================================================
 
 // Maximum length of a command line (including null terminator)
-// Increased from 32 to support command IDs
-constexpr size_t MAX_LINE_LEN = 64;
+// Increased from 64 to fit a FRAME line with a full base64 pixel chunk
+constexpr size_t MAX_LINE_LEN = 256;
+
+// Serial receive ring buffer. Absorbs command bursts that pile up while a
+// blocking LED push runs. Bytes arriving while it is full are dropped and
+// reported with ERR rx_overflow. Override via build flag: -D RX_BUFFER_SIZE=2048
+#ifndef RX_BUFFER_SIZE
+#define RX_BUFFER_SIZE 1024
+#endif
+static_assert(RX_BUFFER_SIZE >= MAX_LINE_LEN * 2 && RX_BUFFER_SIZE <= 32768, "RX_BUFFER_SIZE out of range");
 
-// Serial baud rate
+// Serial baud rate at boot (the BAUD command can raise it at runtime)
 constexpr uint32_t SERIAL_BAUD_RATE = 115200;
 
+// Rates accepted by the BAUD command
+constexpr uint32_t SERIAL_BAUD_RATES[] = {
+    115200, 230400, 460800, 921600, 1000000, 2000000
+};
+constexpr uint8_t SERIAL_BAUD_RATE_COUNT = sizeof(SERIAL_BAUD_RATES) / sizeof(SERIAL_BAUD_RATES[0]);
+
+// A BATCH block is abandoned if END does not arrive within this time (ms)
+constexpr uint16_t BATCH_TIMEOUT_MS = 250;
+
+// After BAUD switches rate, a command must arrive at the new rate within
+// this time (ms), otherwise the previous rate is restored
+constexpr uint16_t BAUD_CONFIRM_TIMEOUT_MS = 1000;
+
+// Talk to the Pi over the RA4M1's native USB CDC port instead of the UART
+// (USB bridge). Baud rate does not apply there. Enable via build flag:
+// -D SERIAL_USB_CDC=1
+#ifndef SERIAL_USB_CDC
+#define SERIAL_USB_CDC 0
+#endif
+
+#if SERIAL_USB_CDC
+#define PI_SERIAL SerialUSB
+#else
+#define PI_SERIAL Serial
+#endif
+
+// ============================================================================
+// Boot Configuration
+// ============================================================================
+
+// Fast boot: skip the fixed start-up waits and bring the sensors up from
+// the map stored at the previous boot (which chips answered, bus speed).
+// Boot then only verifies that map; a full probe and bus speed search
+// runs when nothing is stored or a stored sensor stopped answering.
+// Disable via build flag: -D FAST_BOOT_ENABLED=0
+#ifndef FAST_BOOT_ENABLED
+#define FAST_BOOT_ENABLED 1
+#endif
+
+// Longest wait at boot for the host to open the serial port (ms). Output
+// sent before that is lost on USB CDC, so the Pi should ask for INFO.
+constexpr uint16_t SERIAL_CONNECT_WAIT_MS = FAST_BOOT_ENABLED ? 0 : 3000;
+
+// Offset of the stored settings in EEPROM (data flash on the UNO R4)
+constexpr uint16_t SETTINGS_EEPROM_ADDRESS = 0;
+
+// Quiet time after the last SENSITIVITY / THRESHOLD change before the
+// settings are written (ms). A flash write blocks the loop, so a burst of
+// changes is written once, between sweeps, while no sensor is touched.
+constexpr uint16_t SETTINGS_COMMIT_DELAY_MS = 2000;
+
 // ============================================================================
 // Queue Sizes
 // ============================================================================
 
-// Maximum number of commands that can be queued
-constexpr uint8_t COMMAND_QUEUE_SIZE = 8;
+// Maximum number of long-running commands in flight (SUCCESS, SCAN, ...).
+// Slots come from a free list, so the size does not affect tick cost.
+constexpr uint8_t COMMAND_QUEUE_SIZE = 16;
 
 // Maximum number of outgoing events that can be queued
 constexpr uint8_t EVENT_QUEUE_SIZE = 16;
 
+// Events waiting per non-loop source ring (touch, animation). These rings
+// can be filled from interrupt context (power of two).
+constexpr uint8_t EVENT_RING_SIZE = 8;
+static_assert((EVENT_RING_SIZE & (EVENT_RING_SIZE - 1)) == 0, "EVENT_RING_SIZE must be a power of two");
+
+// Formatted bytes waiting for the serial port (must hold the longest event)
+constexpr uint16_t EVENT_TX_BUFFER_SIZE = 256;
+
+// Bytes handed to the port at once when it can't report its free TX room
+// (availableForWrite() returns 0 on the UNO R4 UART). Writes are then paced
+// by the link rate so the core's TX buffer never fills and blocks.
+constexpr uint16_t SERIAL_TX_FALLBACK_CHUNK = 64;
+
+// Free event slots needed before the next command line is parsed (ACK plus
+// a follow-up event). Commands wait in the RX buffer until then.
+constexpr uint8_t EVENT_SLOTS_PER_COMMAND = 2;
+
+// Queue long-running commands as the few fields they still need after
+// queueing instead of a full ParsedCommand copy (see QueuedCommand)
+#ifndef COMPACT_COMMAND_QUEUE
+#define COMPACT_COMMAND_QUEUE 1
+#endif
+
+// ============================================================================
+// Memory Budget
+// ============================================================================
+
+// RAM the controllers may take (objects plus LED pixel buffers), checked at
+// build time in main.cpp. The rest of the 32 KB is left to the Arduino core,
+// heap and stack; MEM reports what is actually free at run time.
+constexpr uint32_t RAM_BUDGET_BYTES = 20480;
+
+// Bytes below the current stack pointer left unpainted by MemoryReport::begin()
+constexpr uint16_t STACK_PAINT_MARGIN = 64;
+
 // ============================================================================
 // Touch Sensing Configuration
 // ============================================================================
@@ -47,12 +142,64 @@ constexpr uint8_t EVENT_QUEUE_SIZE = 16;
 // Time between touch sensor polls (ms)
 constexpr uint16_t TOUCH_POLL_INTERVAL_MS = 10;
 
-// Debounce time - sensor must be stable for this duration (ms)
-constexpr uint16_t DEBOUNCE_MS = 30;
+// Hot polling: positions with an active EXPECT_DOWN/EXPECT_UP, touched or
+// still debouncing are read every TOUCH_HOT_POLL_INTERVAL_MS. Each poll
+// reads as many chips as a full sweep per TOUCH_POLL_INTERVAL_MS averages
+// to (at least 2), hot chips first; the rest go round-robin to idle chips,
+// so bus load stays the same. Set equal to TOUCH_POLL_INTERVAL_MS to read
+// every chip on every poll.
+constexpr uint16_t TOUCH_HOT_POLL_INTERVAL_MS = 2;
+static_assert(TOUCH_HOT_POLL_INTERVAL_MS <= TOUCH_POLL_INTERVAL_MS, "Hot polls can't be slower than idle polls");
+
+// Debounce - a raw change must be seen on this many consecutive reads of
+// its sensor (4 x TOUCH_POLL_INTERVAL_MS = 30-40ms when read once per
+// sweep; a changing sensor is hot, so about 3 x TOUCH_HOT_POLL_INTERVAL_MS
+// after the first read that saw it)
+constexpr uint8_t DEBOUNCE_SAMPLES = 4;
+
+// Adaptive debounce: a change on a settled sensor is reported on the first
+// poll that sees it, then the sensor holds its state for a lockout window
+// that grows with its learned noise. Sensors that keep bouncing need
+// DEBOUNCE_SAMPLES polls again. Enable via build flag: -D TOUCH_DEBOUNCE_ADAPTIVE=1
+#ifndef TOUCH_DEBOUNCE_ADAPTIVE
+#define TOUCH_DEBOUNCE_ADAPTIVE 0
+#endif
+
+// Lockout after an accepted change, in reads of the sensor (clean .. noisiest)
+constexpr uint8_t DEBOUNCE_LOCKOUT_MIN_SAMPLES = 2;
+constexpr uint8_t DEBOUNCE_LOCKOUT_MAX_SAMPLES = 6;
+
+// Per-sensor noise estimate: +DEBOUNCE_NOISE_STEP per bounce, -1 per
+// lockout without one, at most DEBOUNCE_NOISE_MAX
+constexpr uint8_t DEBOUNCE_NOISE_STEP = 4;
+constexpr uint8_t DEBOUNCE_NOISE_MAX = 16;
+
+// Noise estimate from which a sensor needs DEBOUNCE_SAMPLES polls again
+constexpr uint8_t DEBOUNCE_NOISY_LEVEL = 8;
 
 // Number of touch sensors (A-Y = 25 sensors)
 constexpr uint8_t NUM_TOUCH_SENSORS = 25;
 
+// ALERT-driven sensing: CAP1188 ALERT outputs (open-drain, active low) are
+// wired-OR into groups, one interrupt pin per group. Only sensors in a group
+// that signalled are read each poll; everything else is covered by a slow
+// background sweep. Enable via build flag: -D TOUCH_ALERT_ENABLED=1
+#ifndef TOUCH_ALERT_ENABLED
+#define TOUCH_ALERT_ENABLED 0
+#endif
+
+// Number of ALERT groups (max 4)
+constexpr uint8_t TOUCH_ALERT_GROUP_COUNT = 2;
+
+// Interrupt pin per ALERT group
+constexpr uint8_t TOUCH_ALERT_PINS[TOUCH_ALERT_GROUP_COUNT] = {
+    2,   // D2 - group 0
+    3    // D3 - group 1
+};
+
+// Time between full sweeps of all sensors in ALERT mode (ms)
+constexpr uint16_t TOUCH_BACKGROUND_SWEEP_MS = 250;
+
 // ============================================================================
 // LED Configuration
 // ============================================================================
@@ -73,12 +220,72 @@ constexpr uint8_t STRIP2_PIN = 10;  // D10
 #define NUM_LEDS_STRIP2 190
 #endif
 
+// Output backend per strip (can be overridden via build flags):
+//   LED_OUTPUT_NEOPIXEL - Adafruit_NeoPixel bit-bang on STRIPx_PIN (blocking,
+//                         interrupts off for the whole push)
+//   LED_OUTPUT_SPI_DTC  - SPI0 + DTC, non-blocking and double-buffered. Data
+//                         line must be on LED_SPI_MOSI_PIN instead of
+//                         STRIPx_PIN; only one strip can use it (one SPI).
+#define LED_OUTPUT_NEOPIXEL 0
+#define LED_OUTPUT_SPI_DTC  1
+
+#ifndef STRIP1_OUTPUT
+#define STRIP1_OUTPUT LED_OUTPUT_NEOPIXEL
+#endif
+
+#ifndef STRIP2_OUTPUT
+#define STRIP2_OUTPUT LED_OUTPUT_NEOPIXEL
+#endif
+
+// SPI backend settings: 3 SPI bits per WS2812 bit at 2.4 MHz (417ns each)
+constexpr uint8_t LED_SPI_MOSI_PIN = 11;    // D11 (SPI0 MOSI)
+constexpr uint32_t LED_SPI_CLOCK_HZ = 2400000;
+
 // Overall brightness (0-255)
 constexpr uint8_t LED_BRIGHTNESS = 128;
 
+// LED frame clock (Hz). All animations advance on this tick, and changes
+// made between two ticks are pushed together, once per changed strip.
+constexpr uint16_t LED_FRAME_RATE_HZ = 60;
+
+// Drive the frame clock from a hardware timer (FspTimer, GPT preferred)
+// instead of deriving it from millis(). Disable via build flag:
+// -D LED_FRAME_TIMER=0
+#ifndef LED_FRAME_TIMER
+#define LED_FRAME_TIMER 1
+#endif
+
+// Convert a duration (ms) to frame ticks, rounded, at least one
+constexpr uint16_t ledFrames(uint32_t ms) {
+    uint32_t frames = (ms * LED_FRAME_RATE_HZ + 500) / 1000;
+    return frames > 0 ? frames : 1;
+}
+
+// Convert frame ticks to a duration (ms)
+constexpr uint32_t ledFramesToMs(uint32_t frames) {
+    return frames * 1000 / LED_FRAME_RATE_HZ;
+}
+
 // Animation settings
 constexpr uint8_t SUCCESS_EXPANSION_RADIUS = 5;    // Max LEDs on each side
 constexpr uint16_t ANIMATION_STEP_MS = 80;         // Time between expansion steps
+constexpr uint8_t SEQUENCE_ANIM_STEPS = 8;         // SEQUENCE_COMPLETED pulses
+constexpr uint16_t SEQUENCE_ANIM_STEP_MS = 150;    // Time between pulses
+constexpr uint16_t BLINK_INTERVAL_MS = 150;        // BLINK on/off half period
+
+// The same settings in frame ticks
+constexpr uint16_t SUCCESS_STEP_FRAMES = ledFrames(ANIMATION_STEP_MS);
+constexpr uint16_t SEQUENCE_STEP_FRAMES = ledFrames(SEQUENCE_ANIM_STEP_MS);
+constexpr uint16_t BLINK_FRAMES = ledFrames(BLINK_INTERVAL_MS);
+
+// Animation lengths, for scheduling the DONE checks
+constexpr uint32_t SUCCESS_ANIMATION_MS = ledFramesToMs((uint32_t)SUCCESS_EXPANSION_RADIUS * SUCCESS_STEP_FRAMES);
+constexpr uint32_t SEQUENCE_ANIMATION_MS = ledFramesToMs((uint32_t)SEQUENCE_ANIM_STEPS * SEQUENCE_STEP_FRAMES);
+
+// Most pixels one FRAME command may carry. Its base64 text (4 chars per
+// pixel) plus "FRAME <offset> " and "#<id>" must fit MAX_LINE_LEN.
+constexpr uint16_t FRAME_MAX_PIXELS = 48;
+static_assert(FRAME_MAX_PIXELS * 4 + 32 <= MAX_LINE_LEN, "FRAME chunk does not fit a command line");
 
 // ============================================================================
 // Colors (RGB format)
@@ -108,21 +315,95 @@ constexpr uint8_t COLOR_OFF_B = 0;
 // I2C Configuration
 // ============================================================================
 
-// I2C clock speed (Hz)
+// I2C clock speed used for sensor probing and bus recovery at boot (Hz)
 constexpr uint32_t I2C_CLOCK_SPEED = 100000;
 
+// Bus clock steps (Hz), fastest first. After init the fastest step every
+// active sensor answers at is selected, and the clock steps down when the
+// error rate rises. Prepend 1000000 for Fast-mode Plus capable wiring.
+constexpr uint32_t I2C_CLOCK_STEPS[] = {
+    400000, 100000
+};
+constexpr uint8_t I2C_CLOCK_STEP_COUNT = sizeof(I2C_CLOCK_STEPS) / sizeof(I2C_CLOCK_STEPS[0]);
+
+// Window for counting bus errors (ms)
+constexpr uint16_t I2C_HEALTH_WINDOW_MS = 1000;
+
+// Bus errors (timeouts, SDA held low) within one window that trigger a
+// clock step-down and recovery. NACKs only count against their own chip.
+constexpr uint8_t I2C_ERROR_THRESHOLD = 5;
+
+// Pause after a bus recovery (ms). Skipped at boot with FAST_BOOT_ENABLED
+constexpr uint16_t I2C_RECOVERY_SETTLE_MS = 10;
+
+// Shortest time between two bus recoveries (ms). Doubles after each
+// recovery, up to the maximum, and resets after a clean window.
+constexpr uint32_t I2C_RECOVERY_BACKOFF_MS = 1000;
+constexpr uint32_t I2C_RECOVERY_BACKOFF_MAX_MS = 60000;
+
+// Clean health windows in a row before a stepped-down clock steps back up
+// (never above the speed selected at boot)
+constexpr uint8_t I2C_CLOCK_RESTORE_WINDOWS = 10;
+
+// NACKs in a row after which a chip is taken offline (not read any more),
+// and how often an offline chip is probed again (ms)
+constexpr uint8_t I2C_CHIP_NACK_LIMIT = 8;
+constexpr uint16_t I2C_CHIP_REPROBE_MS = 5000;
+
+// Wire timeout for one transfer (us). A chip holding SCL or SDA low
+// would otherwise stall the caller for the core's default 25 ms. The boot
+// probe runs with the shorter one, so a stuck bus cannot hold up setup();
+// a CAP1188 transfer at 100 kHz takes under 400 us.
+constexpr uint16_t I2C_BOOT_TIMEOUT_US = 500;
+constexpr uint16_t I2C_TIMEOUT_US = 1000;
+
+// Maximum number of queued I2C transactions
+constexpr uint8_t I2C_QUEUE_SIZE = 16;
+
+// Minimum idle time between two transfers to the same chip (us).
+// Transfers to other chips may run in between
+constexpr uint16_t I2C_TURNAROUND_US = 50;
+
+// Time budget for I2C work per TouchController::tick() (us)
+constexpr uint16_t TOUCH_I2C_BUDGET_US = 1500;
+static_assert(I2C_TIMEOUT_US <= TOUCH_I2C_BUDGET_US, "A timed-out transfer must fit in one tick's I2C budget");
+
+// Time from reset until the CAP1188s answer on the bus (ms)
+constexpr uint16_t TOUCH_POWER_UP_MS = 20;
+
 // CAP1188 Register addresses
 constexpr uint8_t CAP1188_REG_MAIN_CONTROL = 0x00;
 constexpr uint8_t CAP1188_REG_SENSITIVITY_CONTROL = 0x1F;
 constexpr uint8_t CAP1188_REG_SENSOR_INPUT_STATUS = 0x03;
 constexpr uint8_t CAP1188_REG_SENSOR_INPUT_ENABLE = 0x21;
 constexpr uint8_t CAP1188_REG_CALIBRATION_ACTIVE = 0x26;
-
-// CS1 bit mask (only using CS1 channel)
-constexpr uint8_t CS1_BIT_MASK = 0x01;
-
-// Default sensitivity level (0 = most sensitive, 7 = least sensitive)
-constexpr uint8_t DEFAULT_SENSITIVITY = 0;
+constexpr uint8_t CAP1188_REG_INTERRUPT_ENABLE = 0x27;
+constexpr uint8_t CAP1188_REG_REPEAT_RATE_ENABLE = 0x28;
+constexpr uint8_t CAP1188_REG_MULTIPLE_TOUCH_CONFIG = 0x2A;
+constexpr uint8_t CAP1188_REG_SENSOR_THRESHOLD_1 = 0x30;   // CS1; CS2-CS8 follow
+
+// Main control register INT bit (holds ALERT asserted until cleared)
+constexpr uint8_t CAP1188_MAIN_CONTROL_INT = 0x01;
+
+// Number of inputs per CAP1188 (CS1-CS8)
+constexpr uint8_t CAP1188_INPUT_COUNT = 8;
+
+// Default sensitivity level (0 = most sensitive, 7 = least sensitive).
+// Written to the DELTA_SENSE field (bits 6:4) of the sensitivity register;
+// the SENSITIVITY command sets it per chip.
+constexpr uint8_t DEFAULT_SENSITIVITY = 2;
+constexpr uint8_t MAX_SENSITIVITY = 7;
+
+// Default touch threshold per input (CAP1188 reset value; higher = needs a
+// stronger touch). The THRESHOLD command sets it per position.
+constexpr uint8_t DEFAULT_TOUCH_THRESHOLD = 0x40;
+constexpr uint8_t MAX_TOUCH_THRESHOLD = 127;
+
+// RECALIBRATE: after the trigger writes the chips' CALIBRATION_ACTIVE bits
+// are read every CALIBRATION_POLL_MS until they clear. Chips that haven't
+// cleared them after CALIBRATION_TIMEOUT_MS are reported as failed.
+constexpr uint16_t CALIBRATION_POLL_MS = 10;
+constexpr uint16_t CALIBRATION_TIMEOUT_MS = 1000;
 
 // ============================================================================
 // I2C Address Mapping for Sensors A-Y
@@ -156,6 +437,38 @@ constexpr uint8_t SENSOR_I2C_ADDRESSES[NUM_TOUCH_SENSORS] = {
     0x0A   // Y
 };
 
+// CAP1188 input (0-7 = CS1-CS8) for sensors A-Y. Positions that share an
+// address are read together with one status read, so a chip can serve up
+// to 8 positions.
+constexpr uint8_t SENSOR_INPUT_CHANNELS[NUM_TOUCH_SENSORS] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // A-M
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0      // N-Y
+};
+
+// Check that every SENSOR_INPUT_CHANNELS entry from index i on is a CAP1188 input
+constexpr bool sensorInputChannelsValid(uint8_t i = 0) {
+    return i >= NUM_TOUCH_SENSORS ||
+           (SENSOR_INPUT_CHANNELS[i] < CAP1188_INPUT_COUNT && sensorInputChannelsValid(i + 1));
+}
+static_assert(sensorInputChannelsValid(), "SENSOR_INPUT_CHANNELS entries must be CAP1188 inputs (0-7)");
+
+// ALERT group (index into TOUCH_ALERT_PINS) for sensors A-Y
+// (positions on the same chip must share a group)
+constexpr uint8_t SENSOR_ALERT_GROUPS[NUM_TOUCH_SENSORS] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // A-M
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1      // N-Y
+};
+
+// ============================================================================
+// Diagnostics
+// ============================================================================
+
+// Loop profiler: per-stage timing and touch latency, reported by STATS
+// (see Profiler.h). Enable via build flag: -D ENABLE_PROFILER=1
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 0
+#endif
+
 // ============================================================================
 // Command IDs
 // ==================================
\ No newline at end of file
@@ -0,0 +1,130 @@
+/**
+ * @file Effects.h
+ * @brief Keyframed LED effects played from constant tables
+ *
+ * An effect is a color plus a list of keyframes. Each keyframe gives a
+ * brightness level (perceptual, gamma corrected on output), an expansion
+ * radius (position effects) and the number of frame ticks it takes to get
+ * there from the previous keyframe, following an easing curve.
+ *
+ * Sampling an effect costs a few table lookups per frame. The result is
+ * one scaled color and one radius, so the per-pixel work when rendering
+ * stays a plain copy. Gamma and easing curves are built at compile time.
+ *
+ * Targets:
+ *   ALL      - Whole-strip overlay (drawn on top of all other layers)
+ *   POSITION - Region around one position, like SUCCESS
+ *
+ * Adding an effect only needs a new table entry; the Pi plays it by ID
+ * with PLAY.
+ */
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "LedController.h"
+
+// ============================================================================
+// Effect IDs (PLAY argument, append only)
+// ============================================================================
+
+constexpr uint8_t EFFECT_SUCCESS = 0;     // Green expansion (SUCCESS)
+constexpr uint8_t EFFECT_CELEBRATE = 1;   // Green pulses on all LEDs (SEQUENCE_COMPLETED)
+constexpr uint8_t EFFECT_BREATHE = 2;     // Two slow blue breaths on all LEDs
+constexpr uint8_t EFFECT_FLASH = 3;       // Three short orange flashes on all LEDs
+constexpr uint8_t EFFECT_RIPPLE = 4;      // Green ring fading out around a position
+constexpr uint8_t EFFECT_COUNT = 5;
+
+constexpr uint8_t NO_EFFECT = 0xFF;
+
+// ============================================================================
+// Keyframe Tables
+// ============================================================================
+
+enum class Easing : uint8_t {
+    STEP,          // Jump to the keyframe value when it is reached
+    LINEAR,
+    EASE_IN_OUT,   // Smoothstep
+    EASE_OUT       // Fast start, slow arrival
+};
+
+enum class EffectTarget : uint8_t {
+    ALL,
+    POSITION
+};
+
+struct Keyframe {
+    uint8_t frames;   // Frame ticks from the previous keyframe (0 for the first)
+    uint8_t level;    // Brightness 0-255, before gamma
+    uint8_t radius;   // LEDs on each side of the position (POSITION only)
+    Easing easing;    // Curve from the previous keyframe
+};
+
+struct Effect {
+    RgbColor color;
+    EffectTarget target;
+    bool hold;                 // Keep the last keyframe lit when done (SUCCESS)
+    const Keyframe* keys;
+    uint8_t keyCount;
+};
+
+// One frame of an effect
+struct EffectSample {
+    RgbColor color;   // Effect color at this frame's brightness
+    uint8_t radius;
+    bool done;        // Past the last keyframe
+};
+
+// ============================================================================
+// Effects
+// ============================================================================
+
+class Effects {
+public:
+    /**
+     * @brief Look up an effect by ID
+     * @param id Effect ID
+     * @return Effect, or nullptr if unknown
+     */
+    static const Effect* get(uint8_t id);
+
+    /**
+     * @brief Get the total length of an effect
+     * @param effect Effect
+     * @return Length in frame ticks
+     */
+    static constexpr uint16_t length(const Effect& effect) {
+        uint16_t frames = 0;
+        for (uint8_t i = 0; i < effect.keyCount; i++) {
+            frames += effect.keys[i].frames;
+        }
+        return frames;
+    }
+
+    /**
+     * @brief Sample an effect
+     * @param effect Effect
+     * @param elapsed Frame ticks since the effect started
+     * @return Color, radius and completion at that frame
+     */
+    static EffectSample sample(const Effect& effect, uint32_t elapsed);
+
+    /**
+     * @brief Apply an easing curve
+     * @param easing Curve
+     * @param t Progress 0-255
+     * @return Eased progress 0-255
+     */
+    static uint8_t ease(Easing easing, uint8_t t);
+
+    /**
+     * @brief Gamma correct a brightness level (gamma ~2.2)
+     * @param level Perceptual level 0-255
+     * @return Linear PWM level 0-255
+     */
+    static uint8_t gamma(uint8_t level);
+};
+
+#endif // EFFECTS_H
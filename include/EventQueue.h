@@ -3,19 +3,43 @@
  * @brief Outgoing event queue for serial communication
  * 
  * Provides a non-blocking queue for outgoing serial messages.
- * Events are flushed gradually to avoid blocking the main loop.
+ * Events are queued as compact records and formatted on flush into one
+ * contiguous TX ring, which is handed to the serial port with a single
+ * write() of whatever fits its free TX space, so flushing never blocks.
+ * Records are only formatted once the port has room for them. While the
+ * port is backed up, a spontaneous TOUCH_DOWN/TOUCH_UP pair on the same
+ * position is dropped from the queue as a net no-change (coalesced).
+ * Queue high-water marks and drops are counted and reported by STATS,
+ * followed by PROFILE lines when built with ENABLE_PROFILER.
+ * In latency mode (LATENCY ON) touch-down events carry their raw-edge and
+ * send times, and the next LED command for that position is answered with
+ * a LATENCY line splitting the round-trip into its parts.
+ * Events are written as ASCII v2 lines, or as binary frames after
+ * MODE BINARY (see BinaryProtocol.h).
+ *
+ * Producers pick an EventSource. LOOP events go into the main queue. Each
+ * other source has its own single-producer/single-consumer ring, so touch
+ * or animation events can be queued from an interrupt without disabling
+ * interrupts. Every event gets a sequence number when queued, and flush()
+ * always sends the oldest head across the queue and the rings. Events keep
+ * the order they were queued in, also across sources (an ACK stays ahead
+ * of its DONE when the DONE comes from another source). Only LOOP touch
+ * events are coalesced.
  */
 
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
 #include <Arduino.h>
+#include <atomic>
 #include "Config.h"
+#include "CommandController.h"
 
 // ============================================================================
 // Event Types
 // ============================================================================
 
+// Values double as binary protocol opcodes - append new types at the end
 enum class EventType : uint8_t {
     ACK,            // Command acknowledged
     DONE,           // Long-running command completed
@@ -28,22 +52,77 @@ enum class EventType : uint8_t {
     RECALIBRATED,   // Sensor(s) recalibrated
     SCAN_RESULT,    // I2C device found during scan (legacy)
     SCAN_DONE,      // I2C scan completed (legacy)
-    INFO            // Firmware info response
+    INFO,           // Firmware info response
+    MODE,           // Framing change (sent as ACK MODE, then applied)
+    STATS,          // Queue statistics response
+    PROFILE,        // Loop profiler stage (after STATS, ENABLE_PROFILER)
+    LATENCY,        // Touch-to-LED round-trip (latency mode)
+    MEM             // RAM usage response
 };
 
+// ============================================================================
+// Event Sources
+// ============================================================================
+
+// Who queues an event. Each source must be a single producer context
+// (the main loop, or one interrupt); LOOP is the default for everything.
+enum class EventSource : uint8_t {
+    LOOP = 0,       // Main loop (main queue)
+    TOUCH,          // Touch events (TouchController::setEventSource)
+    ANIMATION       // Animation DONE events (CommandController::setAnimationEventSource)
+};
+
+constexpr uint8_t EVENT_SOURCE_COUNT = 3;
+
 // ============================================================================
 // Event Structure
 // ============================================================================
 
 struct Event {
     EventType type;
-    char action[12];      // Action name (e.g., "SHOW", "SUCCESS")
+    CommandAction action; // ACK/DONE: acknowledged action
     char position;        // Position letter ('A'-'Y') or 0 if none
+    uint8_t sequence;     // Queue order across sources (set when queued)
     uint32_t commandId;   // Command ID or NO_COMMAND_ID
-    char extra[52];       // Extra data - larger for SCANNED[A,B,C,...] (max ~50 chars for 25 sensors)
-    bool valid;           // Whether this slot contains valid data
+    union {
+        const char* reason;   // ERR: reason (string literal)
+        uint32_t sensorMask;  // SCANNED: active sensors (bit 0 = A)
+        uint32_t positionMask; // ACK: position list when position is 0
+        uint8_t address;      // SCAN_RESULT: I2C address
+        bool binary;          // MODE: target framing
+        uint8_t stage;        // PROFILE: ProfileStage
+        struct {
+            uint32_t edgeUs;   // micros() of the sweep that saw the raw change
+            uint32_t queuedUs; // micros() when debounced and queued
+        } touch;              // TOUCH_*/TOUCHED_*
+        struct {
+            uint32_t replyUs;  // Touch sent to LED command executed
+            uint8_t slot;      // Latency slot with the other timings
+        } latency;            // LATENCY
+    };
 };
 
+// Sequence numbers wrap, so fewer than half of their range may be waiting
+static_assert(EVENT_QUEUE_SIZE + (EVENT_SOURCE_COUNT - 1) * EVENT_RING_SIZE < 128,
+              "Too many queued events for 8-bit sequence numbers");
+
+// ============================================================================
+// Source Ring
+// ============================================================================
+
+// Lock-free single-producer/single-consumer ring. The producer only writes
+// head, the consumer (flush) only writes tail; indices run freely and wrap.
+struct EventRing {
+    Event events[EVENT_RING_SIZE];
+    std::atomic<uint8_t> head;      // Next slot to fill
+    std::atomic<uint8_t> tail;      // Next slot to send
+    volatile uint32_t dropped;      // Events lost to a full ring (producer only)
+};
+
+// Called with each ASCII line as it is formatted for TX (no line ending).
+// Used by the Mock Pi to see replies without reading the port back.
+typedef void (*EventMonitor)(const char* line, void* context);
+
 // ============================================================================
 // EventQueue Class
 // ============================================================================
@@ -59,70 +138,104 @@ public:
 
     /**
      * @brief Flush pending events to serial (non-blocking)
-     * Sends up to maxEvents per call to avoid blocking
-     * @param maxEvents Maximum events to send (default: 3)
+     * Formats queued events into the TX ring while they fit, then writes
+     * as much of the ring as the serial port can take without blocking
      */
-    void flush(uint8_t maxEvents = 3);
+    void flush();
 
     /**
-     * @brief Check if the queue is full
+     * @brief Check if the main (LOOP) queue is full
      * @return true if queue is full
      */
     bool isFull() const;
 
     /**
-     * @brief Check if the queue is empty
-     * @return true if queue is empty
+     * @brief Check if the queue and all source rings are empty
+     * @return true if nothing is waiting to be formatted
      */
     bool isEmpty() const;
 
     /**
-     * @brief Get number of events in queue
+     * @brief Check if every event has been handed to the serial port
+     * @return true if no events are queued and the TX ring is drained
+     */
+    bool isIdle() const;
+
+    /**
+     * @brief Get number of events in the main (LOOP) queue
      * @return Number of pending events
      */
     uint8_t count() const;
 
+    /**
+     * @brief Get number of free slots in the main (LOOP) queue
+     * @return Free slots
+     */
+    uint8_t freeSlots() const;
+
     // === Event emission methods ===
 
     /**
      * @brief Queue an ACK event
-     * @param action Action name
+     * @param action Acknowledged action
      * @param position Position letter (0 if none)
      * @param commandId Command ID (NO_COMMAND_ID if none)
      * @return true if queued successfully
      */
-    bool queueAck(const char* action, char position = 0, uint32_t commandId = NO_COMMAND_ID);
+    bool queueAck(CommandAction action, char position = 0, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue an ACK event for a position list (ACK SHOW A,C,F)
+     * @param action Acknowledged action
+     * @param positionMask Positions (bit 0 = A)
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueAckPositions(CommandAction action, uint32_t positionMask, uint32_t commandId = NO_COMMAND_ID);
 
     /**
      * @brief Queue a DONE event
-     * @param action Action name
+     * @param action Completed action
      * @param position Position letter (0 if none)
      * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @param source Producer (safe from an interrupt for non-LOOP sources)
      * @return true if queued successfully
      */
-    bool queueDone(const char* action, char position = 0, uint32_t commandId = NO_COMMAND_ID);
+    bool queueDone(CommandAction action, char position = 0, uint32_t commandId = NO_COMMAND_ID,
+                   EventSource source = EventSource::LOOP);
 
     /**
      * @brief Queue an ERR event
-     * @param reason Error reason string
+     * @param reason Error reason (string literal - stored by pointer)
      * @param commandId Command ID (NO_COMMAND_ID if none)
      * @return true if queued successfully
      */
     bool queueError(const char* reason, uint32_t commandId = NO_COMMAND_ID);
 
+    /**
+     * @brief Count bytes lost to a full RX buffer and queue ERR rx_overflow
+     * @param bytes Number of bytes dropped
+     * @return true if queued successfully
+     */
+    bool queueRxOverflow(uint16_t bytes);
+
     /**
      * @brief Queue a TOUCH_DOWN event
      * @param position Position letter
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     * @param source Producer (safe from an interrupt for non-LOOP sources)
      * @return true if queued successfully
      */
-    bool queueTouchDown(char position);
+    bool queueTouchDown(char position, uint32_t edgeUs = 0, EventSource source = EventSource::LOOP);
 
     /**
      * @brief Queue a TOUCH_UP event
      * @param position Position letter
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     * @param source Producer (safe from an interrupt for non-LOOP sources)
      * @return true if queued successfully
      */
-    bool queueTouchUp(char position);
+    bool queueTouchUp(char position, uint32_t edgeUs = 0, EventSource source = EventSource::LOOP);
 
     /**
      * @brief Queue a SCAN_RESULT event
@@ -140,11 +253,364 @@ public:
 
     /**
      * @brief Queue a SCANNED event (new format: SCANNED[A,B,C,...])
-     * @param sensorList String containing comma-separated active sensor letters
+     * @param sensorMask Active sensors (bit 0 = A)
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueScanned(uint32_t sensorMask, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue a TOUCHED_DOWN event
+     * @param position Position letter
+     * @param commandId Command ID from EXPECT_DOWN
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     * @param source Producer (safe from an interrupt for non-LOOP sources)
+     * @return true if queued successfully
+     */
+    bool queueTouchedDown(char position, uint32_t commandId = NO_COMMAND_ID, uint32_t edgeUs = 0,
+                          EventSource source = EventSource::LOOP);
+
+    /**
+     * @brief Queue a TOUCHED_UP event
+     * @param position Position letter
+     * @param commandId Command ID from EXPECT_UP
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     * @param source Producer (safe from an interrupt for non-LOOP sources)
+     * @return true if queued successfully
+     */
+    bool queueTouchedUp(char position, uint32_t commandId = NO_COMMAND_ID, uint32_t edgeUs = 0,
+                        EventSource source = EventSource::LOOP);
+
+    /**
+     * @brief Queue a RECALIBRATED event
+     * @param position Position letter, or 0 for ALL
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueRecalibrated(char position, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue an INFO event
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @param details Extra key=value fields appended to the line (optional).
+     *                Kept in a single buffer - a later INFO replaces them.
+     * @return true if queued successfully
+     */
+    bool queueInfo(uint32_t commandId = NO_COMMAND_ID, const char* details = nullptr);
+
+    /**
+     * @brief Queue a framing change
+     * The ACK MODE is sent in the current framing; events after it use
+     * the new one.
+     * @param binary true for binary frames, false for ASCII lines
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueMode(bool binary, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue a STATS event (counters are read when it is sent)
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueStats(uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue a MEM event (free stack and heap are read when it is sent)
      * @param commandId Command ID (NO_COMMAND_ID if none)
      * @return true if queued successfully
      */
-    bool queueScanned(const char* sensorList, uint32_t commandId = NO_COMMAND_ID);
+    bool queueMem(uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Queue a PROFILE event for one profiler stage
+     * The stage is read (and reset) when the event is sent.
+     * @param stage ProfileStage value
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return true if queued successfully
+     */
+    bool queueProfile(uint8_t stage, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Answer a sent touch-down with a LATENCY event
+     * Only the first LED command after each touch-down is answered.
+     * @param position Position letter the LED command targets
+     * @param rxUs micros() when the LED command was executed
+     * @param commandId Command ID of the LED command
+     * @return true if a touch-down was waiting and the event was queued
+     */
+    bool queueLatencyEcho(char position, uint32_t rxUs, uint32_t commandId = NO_COMMAND_ID);
+
+    /**
+     * @brief Turn latency mode on or off
+     * Turning it off forgets touch-downs that were not answered yet.
+     * @param enabled true to timestamp touch-downs and answer LED commands
+     */
+    void setLatencyMode(bool enabled);
+
+    /**
+     * @brief Check if latency mode is on
+     * @return true after LATENCY ON
+     */
+    bool isLatencyMode() const;
+
+    /**
+     * @brief Check if events are written as binary frames
+     * @return true after a flushed MODE BINARY
+     */
+    bool isBinaryMode() const;
+
+    /**
+     * @brief Set the link rate reported in INFO (also paces TX, see portRoom())
+     * @param baud UART baud rate, or 0 for native USB CDC
+     */
+    void setLinkRate(uint32_t baud);
+
+    /**
+     * @brief Get the measured serial throughput
+     * @return Bytes per second written over the last window
+     */
+    uint32_t getTxRate() const;
+
+    /**
+     * @brief Get the number of events lost because the queue was full
+     * @return Dropped events since boot (main queue and source rings)
+     */
+    uint32_t getDroppedCount() const;
+
+    /**
+     * @brief Set a function that sees every ASCII event line sent
+     * @param monitor Function, or nullptr to remove it
+     * @param context Passed back to the function
+     */
+    void setMonitor(EventMonitor monitor, void* context);
+
+private:
+    // Longest formatted event (ASCII INFO with details and ID)
+    static constexpr size_t MAX_EVENT_LEN = 144;
+    static_assert(EVENT_TX_BUFFER_SIZE >= MAX_EVENT_LEN, "TX ring must hold the longest event");
+
+    // Source rings (index = EventSource - 1)
+    EventRing m_rings[EVENT_SOURCE_COUNT - 1];
+
+    // Next sequence number (taken by any source, also from interrupts)
+    std::atomic<uint8_t> m_sequence;
+
+    // Ring buffer of pending events
+    Event m_queue[EVENT_QUEUE_SIZE];
+    uint8_t m_head;
+    uint8_t m_tail;
+    uint8_t m_count;
+
+    // Formatted bytes not yet taken by the serial port
+    uint8_t m_txBuffer[EVENT_TX_BUFFER_SIZE];
+    uint16_t m_txHead;
+    uint16_t m_txTail;
+    uint16_t m_txCount;
+
+    // Details for the INFO line
+    char m_infoDetails[52];
+
+    // Outgoing framing: false = ASCII lines, true = COBS frames
+    bool m_binaryMode;
+
+    // Link rate for INFO and TX pacing (baud, 0 = USB CDC)
+    uint32_t m_linkRate;
+
+    // micros() when the bytes written without a reported TX room will have
+    // left the port (see portRoom())
+    uint32_t m_txPacedUntil;
+
+    // Latency mode: touch-downs sent and not yet answered by an LED command
+    static constexpr uint8_t LATENCY_SLOTS = 4;
+
+    enum class LatencyState : uint8_t {
+        FREE,       // Unused
+        SENT,       // Touch-down sent, waiting for an LED command
+        ECHOED      // LATENCY event queued, not sent yet
+    };
+
+    struct LatencySlot {
+        char position;
+        LatencyState state;
+        uint32_t debounceUs;    // Raw edge to event queued
+        uint32_t queueUs;       // Queued to formatted for TX
+        uint32_t sentUs;        // micros() when formatted for TX
+    };
+
+    bool m_latencyMode;
+    LatencySlot m_latency[LATENCY_SLOTS];
+
+    // micros() when the event being formatted left the queue
+    uint32_t m_flushUs;
+
+    // Throughput measurement
+    static constexpr uint16_t TX_RATE_WINDOW_MS = 1000;
+    uint32_t m_txBytes;         // Total bytes written to the port
+    uint32_t m_txWindowStart;
+    uint32_t m_txWindowBytes;
+    uint32_t m_txRate;          // Bytes per second over the last window
+
+    // Queue statistics (since boot)
+    uint8_t m_highWater;        // Most events queued at once
+    uint16_t m_txHighWater;     // Most bytes waiting in the TX ring
+    uint32_t m_dropped;         // Events lost because the queue was full
+    uint32_t m_coalesced;       // TOUCH_DOWN/TOUCH_UP pairs removed
+    uint32_t m_rxDropped;       // Received bytes lost to a full RX buffer
+
+    // Line monitor (nullptr if none)
+    EventMonitor m_monitor;
+    void* m_monitorContext;
+
+    /**
+     * @brief Build an event record with no payload
+     * @param type Event type
+     * @param position Position letter (0 if none)
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @return Event record
+     */
+    static Event makeEvent(EventType type, char position, uint32_t commandId);
+
+    /**
+     * @brief Build a touch event record stamped with its queue time
+     * @param type TOUCH_DOWN, TOUCH_UP, TOUCHED_DOWN or TOUCHED_UP
+     * @param position Position letter
+     * @param commandId Command ID (NO_COMMAND_ID if none)
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     * @return Event record
+     */
+    static Event makeTouchEvent(EventType type, char position, uint32_t commandId, uint32_t edgeUs);
+
+    /**
+     * @brief Add an event to the queue or its source ring
+     * @param event Event to add (sequence is set here)
+     * @param source Producer
+     * @return true if queued, false if the queue or ring is full
+     */
+    bool enqueue(const Event& event, EventSource source = EventSource::LOOP);
+
+    /**
+     * @brief Find the oldest event across the queue and the source rings
+     * @param source Output: where it is
+     * @return Event, or nullptr if all are empty
+     */
+    const Event* peekOldest(EventSource& source);
+
+    /**
+     * @brief Remove the event returned by peekOldest()
+     * @param source Where it is
+     */
+    void popOldest(EventSource source);
+
+    /**
+     * @brief Remove a still-queued opposite touch event for a position
+     * Only the newest queued event for the position is considered, so
+     * ordering relative to TOUCHED_* events is preserved.
+     * @param opposite TOUCH_DOWN or TOUCH_UP to look for
+     * @param position Position letter
+     * @return true if one was removed (the new event cancels it)
+     */
+    bool coalesceTouch(EventType opposite, char position);
+
+    /**
+     * @brief Remember a touch-down formatted for TX (latency mode)
+     * Reuses the position's waiting slot, else a free one, else the oldest
+     * waiting one. Slots with a queued LATENCY event are kept.
+     * @param event TOUCH_DOWN or TOUCHED_DOWN event
+     */
+    void recordLatency(const Event& event);
+
+    /**
+     * @brief Append the edge/sent fields of a touch-down (latency mode only)
+     * @param event Touch event
+     * @param out Output buffer
+     * @param len Current length
+     * @param size Usable size
+     * @return New length
+     */
+    size_t formatTouchTimes(const Event& event, char* out, size_t len, size_t size) const;
+
+    /**
+     * @brief Append ASCII text fields for INFO
+     * @param out Output buffer
+     * @param len Current length
+     * @param size Usable size
+     * @return New length
+     */
+    size_t formatInfo(char* out, size_t len, size_t size) const;
+
+    /**
+     * @brief Append ASCII text fields for STATS
+     * @param out Output buffer
+     * @param len Current length
+     * @param size Usable size
+     * @return New length
+     */
+    size_t formatStats(char* out, size_t len, size_t size) const;
+
+    /**
+     * @brief Append ASCII text fields for MEM
+     * @param out Output buffer
+     * @param len Current length
+     * @param size Usable size
+     * @return New length
+     */
+    size_t formatMem(char* out, size_t len, size_t size) const;
 
     /**
-     * @brief Queue a TOUCHED_DOWN event
\ No newline at end of file
+     * @brief Append ASCII text fields for PROFILE
+     * @param stage ProfileStage value
+     * @param out Output buffer
+     * @param len Current length
+     * @param size Usable size
+     * @return New length
+     */
+    size_t formatProfile(uint8_t stage, char* out, size_t len, size_t size) const;
+
+    /**
+     * @brief Format an event as an ASCII v2 line
+     * @param event Event to format
+     * @param out Output buffer (MAX_EVENT_LEN bytes)
+     * @return Number of bytes
+     */
+    size_t formatEvent(const Event& event, char* out);
+
+    /**
+     * @brief Format an event as an encoded binary frame
+     * @param event Event to format
+     * @param out Output buffer (BINARY_MAX_ENCODED_LEN bytes)
+     * @return Number of bytes, including the delimiter
+     */
+    size_t formatBinaryEvent(const Event& event, uint8_t* out);
+
+    /**
+     * @brief Copy formatted bytes into the TX ring
+     * @param data Bytes
+     * @param len Number of bytes (must fit)
+     */
+    void pushTx(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Write as much of the TX ring as the port can take
+     */
+    void writeTx();
+
+    /**
+     * @brief Get how many bytes the port can take without blocking
+     * A port reporting 0 may just not implement availableForWrite(), so
+     * 0 is treated as unknown: up to SERIAL_TX_FALLBACK_CHUNK bytes, less
+     * what the link can't have sent yet since the last paced write.
+     * @param paced Output: true if the room is the paced estimate
+     * @return Bytes
+     */
+    int portRoom(bool& paced);
+
+    /**
+     * @brief Get the time bytes take on the link (10 bits each)
+     * @param bytes Number of bytes (up to EVENT_TX_BUFFER_SIZE)
+     * @return Microseconds, rounded up; 0 if the link has no rate (USB)
+     */
+    uint32_t linkTimeUs(uint32_t bytes) const;
+};
+
+#endif // EVENT_QUEUE_H
@@ -0,0 +1,251 @@
+/**
+ * @file I2cEngine.h
+ * @brief Time-sliced I2C transaction engine for the CAP1188 sensor bus
+ *
+ * Transactions are queued and executed one bus transfer per step, within a
+ * caller-supplied time budget, so the main loop is never stalled by a full
+ * sensor sweep. The fixed 50us sleeps of the blocking access pattern are
+ * replaced by a turnaround guard between transfers to the same device, so
+ * transfers that alternate between chips run back to back.
+ *
+ * Operations:
+ *   PROBE       - Address-only write, succeeds if the device ACKs
+ *   READ        - Read one register
+ *   WRITE       - Write one register
+ *   CLEAR_BITS  - Read register, clear mask bits, write back if any were set
+ *
+ * Completed transactions are collected with takeCompleted() in submit order.
+ * Blocking helpers are kept for the boot path.
+ *
+ * Failed transfers are classified as NACK or TIMEOUT (any other bus error)
+ * so callers can track bus health per device.
+ */
+
+#ifndef I2C_ENGINE_H
+#define I2C_ENGINE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Config.h"
+
+// ============================================================================
+// Transaction Types
+// ============================================================================
+
+enum class I2cOp : uint8_t {
+    PROBE,
+    READ,
+    WRITE,
+    CLEAR_BITS
+};
+
+// ============================================================================
+// Transfer Errors
+// ============================================================================
+
+enum class I2cError : uint8_t {
+    NONE,       // Transfer ACKed
+    NACK,       // Address or data not acknowledged
+    TIMEOUT     // Bus timeout or other bus error
+};
+
+// ============================================================================
+// Transaction Structure
+// ============================================================================
+
+struct I2cTransaction {
+    I2cOp op;
+    uint8_t address;
+    uint8_t reg;
+    uint8_t value;      // WRITE: value, CLEAR_BITS: mask, READ: result
+    uint8_t tag;        // Caller-defined (e.g. sensor index)
+    uint8_t kind;       // Caller-defined purpose of the transaction
+    uint8_t phase;      // Internal: step within a multi-transfer operation
+    bool ok;            // Result: all transfers were ACKed
+    I2cError error;     // First error if !ok
+};
+
+// ============================================================================
+// I2cEngine Class
+// ============================================================================
+
+class I2cEngine {
+public:
+    I2cEngine();
+
+    /**
+     * @brief Initialize the I2C peripheral and clear the queues
+     * @param clockHz Bus clock (Hz)
+     */
+    void begin(uint32_t clockHz);
+
+    /**
+     * @brief Drop all pending and completed transactions
+     */
+    void reset();
+
+    /**
+     * @brief Change the bus clock
+     * @param clockHz Bus clock (Hz)
+     */
+    void setClock(uint32_t clockHz);
+
+    /**
+     * @brief Change the Wire timeout (kept across begin())
+     * @param timeoutUs Longest time one transfer may take (us)
+     */
+    void setTimeout(uint16_t timeoutUs);
+
+    /**
+     * @brief Get the current bus clock
+     * @return Bus clock (Hz)
+     */
+    uint32_t getClock() const;
+
+    /**
+     * @brief Queue a transaction
+     * @param op Operation
+     * @param address I2C address
+     * @param reg Register address (ignored for PROBE)
+     * @param value Value (WRITE) or mask (CLEAR_BITS)
+     * @param tag Caller-defined tag returned with the result
+     * @param kind Caller-defined kind returned with the result
+     * @return true if queued, false if the queue is full
+     */
+    bool submit(I2cOp op, uint8_t address, uint8_t reg, uint8_t value,
+                uint8_t tag, uint8_t kind);
+
+    /**
+     * @brief Execute queued transfers until the budget is used up
+     * @param budgetUs Time budget (us)
+     */
+    void run(uint32_t budgetUs);
+
+    /**
+     * @brief Take the oldest completed transaction
+     * @param out Completed transaction
+     * @return true if one was available
+     */
+    bool takeCompleted(I2cTransaction& out);
+
+    /**
+     * @brief Check if nothing is pending or waiting to be collected
+     * @return true if idle
+     */
+    bool isIdle() const;
+
+    /**
+     * @brief Get number of free slots in the pending queue
+     * @return Free slots
+     */
+    uint8_t freeSlots() const;
+
+    // === Blocking Helpers (boot path) ===
+
+    /**
+     * @brief Check if a device ACKs its address
+     * @param address I2C address
+     * @return true if the device responded
+     */
+    bool probe(uint8_t address);
+
+    /**
+     * @brief Read a register (blocking)
+     * @param address I2C address
+     * @param reg Register address
+     * @param value Output value
+     * @return true if successful
+     */
+    bool readRegister(uint8_t address, uint8_t reg, uint8_t& value);
+
+    /**
+     * @brief Write a register (blocking)
+     * @param address I2C address
+     * @param reg Register address
+     * @param value Value to write
+     * @return true if successful
+     */
+    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Get the error of the last blocking helper call
+     * @return Error (NONE if it succeeded)
+     */
+    I2cError lastError() const;
+
+private:
+    // Pending transactions (FIFO)
+    I2cTransaction m_pending[I2C_QUEUE_SIZE];
+    uint8_t m_pendingHead;
+    uint8_t m_pendingTail;
+    uint8_t m_pendingCount;
+
+    // Completed transactions waiting to be collected (FIFO)
+    I2cTransaction m_completed[I2C_QUEUE_SIZE];
+    uint8_t m_completedHead;
+    uint8_t m_completedTail;
+    uint8_t m_completedCount;
+
+    // Last transfers (ring, m_recentNext = oldest), for the turnaround guard
+    static constexpr uint8_t RECENT_TRANSFERS = 4;
+    uint8_t m_recentAddress[RECENT_TRANSFERS];
+    uint32_t m_recentUs[RECENT_TRANSFERS];
+    uint8_t m_recentNext;
+
+    // Current bus clock (Hz)
+    uint32_t m_clockHz;
+
+    // Wire timeout (us)
+    uint16_t m_timeoutUs;
+
+    // Error of the last blocking helper call
+    I2cError m_lastError;
+
+    /**
+     * @brief Perform one bus transfer of a transaction
+     * @param t Transaction
+     * @return true if the transaction is finished
+     */
+    bool step(I2cTransaction& t);
+
+    /**
+     * @brief Wait out the remaining turnaround time of a device, if any
+     * @param address I2C address of the next transfer
+     */
+    void waitTurnaround(uint8_t address);
+
+    /**
+     * @brief Remember when a transfer to a device ended
+     * @param address I2C address
+     */
+    void noteTransfer(uint8_t address);
+
+    // === Raw Transfers ===
+
+    /**
+     * @brief Register pointer write + single byte read
+     * @return NONE if ACKed and a byte was received
+     */
+    I2cError transferRead(uint8_t address, uint8_t reg, uint8_t& value);
+
+    /**
+     * @brief Single register write
+     * @return NONE if ACKed
+     */
+    I2cError transferWrite(uint8_t address, uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Address-only write
+     * @return NONE if ACKed
+     */
+    I2cError transferProbe(uint8_t address);
+
+    /**
+     * @brief Map a Wire.endTransmission() status to an error
+     * @param status Wire status (0 = success)
+     * @return Error classification
+     */
+    static I2cError classify(uint8_t status);
+};
+
+#endif // I2C_ENGINE_H
@@ -12,6 +12,25 @@
  *   BLINK               - Start blinking LED at position
  *   STOP_BLINK          - Stop blinking LED at position
  *   SEQUENCE_COMPLETED  - Celebration animation on all LEDs
+ *   PLAY                - Keyframed effect by ID (see Effects.h)
+ *   FRAME               - Raw pixel upload into the stream layer
+ * 
+ * Rendering: an RGB framebuffer with three layers covering both strips.
+ *   Base layer    - rebuilt from position states (expansions first, then
+ *                   single LEDs on top, so overlapping SUCCESS and
+ *                   position effect regions never erase each other)
+ *   Stream layer  - raw pixels uploaded by the Pi (FRAME); black pixels
+ *                   are transparent. Skipped while all black; a FRAME
+ *                   without pixels clears it from its offset on
+ *   Overlay layer - one color over all LEDs, set by whole-strip effects
+ *                   (SEQUENCE_COMPLETED, PLAY); black is transparent
+ * State changes only mark the frame dirty. Everything runs on one frame
+ * clock (LED_FRAME_RATE_HZ, from a hardware timer when LED_FRAME_TIMER is
+ * set): on each tick all animation timelines advance together from the
+ * frame counter, blinking positions share one phase, and the layers are
+ * blended in one pass, with brightness applied, straight into the strip
+ * buffers. Only strips that changed are pushed, up to their last changed
+ * pixel, through the strip's LedOutput backend (see LedOutput.h).
  */
 
 #ifndef LED_CONTROLLER_H
@@ -20,6 +39,13 @@
 #include <Arduino.h>
 #include <Adafruit_NeoPixel.h>
 #include "Config.h"
+#include "LedOutput.h"
+
+#if LED_FRAME_TIMER
+#include <FspTimer.h>
+#endif
+
+struct Effect;  // Effects.h (includes this header for RgbColor)
 
 // ============================================================================
 // Strip identifier
@@ -30,6 +56,32 @@ enum class StripId : uint8_t {
     STRIP2 = 1
 };
 
+// ============================================================================
+// Framebuffer pixel
+// ============================================================================
+
+struct RgbColor {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+// FRAME copies RGB byte runs straight into the layers
+static_assert(sizeof(RgbColor) == 3, "RgbColor must be packed RGB");
+
+// Strip buffer pixel: GRB byte order with LED_BRIGHTNESS already applied,
+// so it can be copied into the NeoPixel buffer as is
+struct GrbColor {
+    uint8_t g;
+    uint8_t r;
+    uint8_t b;
+};
+
+static_assert(sizeof(GrbColor) == 3, "GrbColor must be packed GRB");
+
+// Total LEDs across both strips (framebuffer length)
+constexpr uint16_t NUM_LEDS_TOTAL = NUM_LEDS_STRIP1 + NUM_LEDS_STRIP2;
+
 // ============================================================================
 // Mapping of a logical position to a physical LED
 // ============================================================================
@@ -46,7 +98,7 @@ struct LedMapping {
 enum class PositionState : uint8_t {
     OFF,           // LED is off
     SHOWN,         // Single LED lit (SHOW command)
-    ANIMATING,     // SUCCESS animation in progress
+    ANIMATING,     // Position effect (SUCCESS, PLAY) in progress
     EXPANDED,      // SUCCESS animation complete, expanded region lit
     BLINKING       // LED is blinking on/off
 };
@@ -57,9 +109,11 @@ enum class PositionState : uint8_t {
 
 struct PositionData {
     PositionState state;
-    uint8_t animationStep;       // Current expansion step (0 = center only)
-    uint32_t lastAnimationTime;  // For non-blocking animation timing
-    bool blinkOn;                // Current blink state (on/off)
+    uint8_t animationStep;       // Current expansion radius (0 = center only)
+    uint8_t effect;              // Effect playing at this position
+    RgbColor color;              // Current effect color
+    GrbColor scaled;             // color, scaled for the strip buffer
+    uint32_t startFrame;         // Frame tick the effect started
 };
 
 // ============================================================================
@@ -80,7 +134,8 @@ public:
 
     /**
      * @brief Update LED animations (non-blocking)
-     * @param nowMillis Current time from millis()
+     * Returns immediately unless a frame tick has passed.
+     * @param nowMillis Current time from millis() (frame clock without timer)
      */
     void update(uint32_t nowMillis);
 
@@ -155,6 +210,56 @@ public:
      */
     bool isSequenceCompletedAnimationComplete() const;
 
+    /**
+     * @brief Start a keyframed effect
+     * Replaces the effect already playing on the same target. ALL effects
+     * are refused while SEQUENCE_COMPLETED runs, since they would replace
+     * its overlay before it ends the round.
+     * @param effect Effect ID (see Effects.h)
+     * @param position Position index for POSITION effects, 255 for ALL effects
+     * @return true if started, false if unknown, the target doesn't match or
+     *         SEQUENCE_COMPLETED holds the overlay
+     */
+    bool playEffect(uint8_t effect, uint8_t position);
+
+    /**
+     * @brief Check if an effect is still running
+     * @param position Position index, or 255 for the whole-strip effect
+     * @return true while running (a held SUCCESS region counts as done)
+     */
+    bool isEffectPlaying(uint8_t position) const;
+
+    /**
+     * @brief Get the RAM used for the LEDs
+     * @return Bytes: this object, the strips' pixel buffers (heap) and the
+     *         output backends
+     */
+    uint32_t memoryUsage() const;
+
+    /**
+     * @brief Hold back frame pushes so several changes land in one frame
+     * Animations keep running; the combined state is pushed on release.
+     * @param hold true to hold, false to release
+     */
+    void holdFrames(bool hold);
+
+    /**
+     * @brief Copy raw pixels into the stream layer (FRAME)
+     * @param offset Framebuffer index of the first pixel (strip 2 follows strip 1)
+     * @param rgb RGB bytes, 3 per pixel
+     * @param count Number of pixels
+     * @return true if the range fits the framebuffer
+     */
+    bool writePixels(uint16_t offset, const uint8_t* rgb, uint16_t count);
+
+    /**
+     * @brief Set the stream layer to black (transparent) from an offset on
+     *        (FRAME without pixels)
+     * @param offset Framebuffer index of the first pixel to clear
+     * @return true if the offset is in the framebuffer
+     */
+    bool clearPixels(uint16_t offset);
+
     /**
      * @brief Convert position character (A-Y) to index (0-24)
      * @param c Position character (case-insensitive)
@@ -171,19 +276,54 @@ public:
 
 private:
     // NeoPixel strip objects
-    Adafruit_NeoPixel m_strip1;
-    Adafruit_NeoPixel m_strip2;
+    PrefixNeoPixel m_strip1;
+    PrefixNeoPixel m_strip2;
+
+    // Output backend per strip
+    LedOutput* m_outputs[2];
 
     // State tracking for each position
     PositionData m_positions[NUM_POSITIONS];
 
-    // SEQUENCE_COMPLETED animation state
-    bool m_sequenceAnimActive;       // Whether animation is running
-    uint8_t m_sequenceAnimStep;      // Current animation step
-    uint32_t m_sequenceAnimLastTime; // Last animation step time
+    // SEQUENCE_COMPLETED animation state (plays EFFECT_CELEBRATE, then
+    // turns all positions off)
+    bool m_sequenceAnimActive;
+
+    // Whole-strip effect (NO_EFFECT if none)
+    uint8_t m_overlayEffect;
+    uint32_t m_overlayEffectStart;
+
+    // Frame clock: last frame tick processed
+    uint32_t m_frame;
+
+    // Shared blink phase of all BLINKING positions
+    bool m_blinkOn;
+
+#if LED_FRAME_TIMER
+    // Periodic timer that advances the frame clock
+    FspTimer m_frameTimer;
+    bool m_frameTimerRunning;
+#endif
+
+    // Framebuffer layers (strip 1 pixels, then strip 2). The base layer and
+    // the overlay are kept scaled, in strip byte order; FRAME pixels are
+    // scaled when composed.
+    GrbColor m_baseLayer[NUM_LEDS_TOTAL];
+    RgbColor m_streamLayer[NUM_LEDS_TOTAL];
+    RgbColor m_overlayColor;
+    GrbColor m_overlayScaled;
+    bool m_streamActive;        // m_streamLit != 0
+    uint16_t m_streamLit;       // Non-black stream pixels
+    bool m_overlayActive;
+
+    // Whether the layers must be recomposed
+    bool m_frameDirty;
 
-    // Flag to indicate strip.show() is needed
-    bool m_needsUpdate;
+    // Frame pushes held back (BATCH in progress)
+    bool m_framesHeld;
+
+    // Pixels to push per strip (last changed index + 1, 0 = unchanged)
+    uint16_t m_dirtyLength[2];
 
     /**
      * @brief Get the LED mapping for a position
@@ -204,49 +344,121 @@ private:
      * @param strip Strip identifier
      * @return Pointer to strip
      */
-    Adafruit_NeoPixel* getStrip(StripId strip);
+    PrefixNeoPixel* getStrip(StripId strip);
 
     /**
-     * @brief Set a single LED color
+     * @brief Get the framebuffer offset of a strip's first LED
      * @param strip Strip identifier
-     * @param index LED index
-     * @param r Red component
-     * @param g Green component
-     * @param b Blue component
+     * @return Offset into the layers
      */
-    void setLed(StripId strip, int16_t index, uint8_t r, uint8_t g, uint8_t b);
+    uint16_t getStripOffset(StripId strip) const;
 
     /**
-     * @brief Clear the expanded region for a position
-     * @param position Position index
-     * @param mapping LED mapping
+     * @brief Set a single base layer pixel
+     * @param strip Strip identifier
+     * @param index LED index (ignored if out of range)
+     * @param color Scaled color
+     */
+    void setBasePixel(StripId strip, int16_t index, const GrbColor& color);
+
+    /**
+     * @brief Fill a range of base layer pixels
+     * @param strip Strip identifier
+     * @param first First LED index (clipped to the strip)
+     * @param last Last LED index, inclusive (clipped to the strip)
+     * @param color Scaled color
+     */
+    void fillBase(StripId strip, int16_t first, int16_t last, const GrbColor& color);
+
+    /**
+     * @brief Apply LED_BRIGHTNESS and reorder to GRB
+     * @param color Color
+     * @return Strip buffer pixel
+     */
+    static GrbColor scaleColor(const RgbColor& color);
+
+    /**
+     * @brief Fill pixels with one color (memset/memcpy, no per-pixel loop)
+     * @param pixels First pixel (3 bytes each)
+     * @param count Number of pixels
+     * @param color Scaled color
+     */
+    static void fillPixels(uint8_t* pixels, uint16_t count, const GrbColor& color);
+
+    /**
+     * @brief Start an ALL effect on the overlay
+     * @param effect Effect ID
+     * @param fx Effect
+     */
+    void startOverlayEffect(uint8_t effect, const Effect& fx);
+
+    /**
+     * @brief Set the overlay color
+     * @param color Color (black = transparent)
      */
-    void clearExpandedRegion(uint8_t position, const LedMapping* mapping);
+    void setOverlay(const RgbColor& color);
 
     /**
-     * @brief Render the current state of a position
+     * @brief Render the base layer from all position states
+     */
+    void rebuildBaseLayer();
+
+    /**
+     * @brief Render the current state of a position into the base layer
      * @param position Position index
+     * @param expansions true to draw SUCCESS regions, false for single LEDs
+     */
+    void renderPosition(uint8_t position, bool expansions);
+
+    /**
+     * @brief Blend the layers into a strip's pixel buffer
+     * Records the last changed pixel in m_dirtyLength
+     * @param strip Strip identifier
+     */
+    void composeStrip(StripId strip);
+
+    /**
+     * @brief Push changed strips through their outputs
      */
-    void renderPosition(uint8_t position);
+    void pushDirtyStrips();
 
     /**
-     * @brief Update animation for a single position
+     * @brief Start the hardware frame timer
+     * @return true if running (otherwise the clock follows millis())
+     */
+    bool startFrameTimer();
+
+    /**
+     * @brief Get the current frame tick
+     * @param nowMillis Current time (used without a frame timer)
+     * @return Frame counter
+     */
+    uint32_t currentFrame(uint32_t nowMillis) const;
+
+    /**
+     * @brief Advance the effect playing at a position
      * @param position Position index
-     * @param nowMillis Current time
      */
-    void updateAnimation(uint8_t position, uint32_t nowMillis);
+    void updateAnimation(uint8_t position);
+
+    /**
+     * @brief Advance the whole-strip effect
+     * Ends SEQUENCE_COMPLETED when it finishes.
+     */
+    void updateOverlayEffect();
 
     /**
-     * @brief Update SEQUENCE_COMPLETED animation
-     * @param nowMillis Current time
+     * @brief Update the shared blink phase
      */
-    void updateSequenceCompletedAnimation(uint32_t nowMillis);
+    void updateBlinking();
 
+#if LED_FRAME_TIMER
     /**
-     * @brief Update blink state for blinking positions
-     * @param nowMillis Current time
+     * @brief Frame timer overflow callback (interrupt context)
+     * @param args Callback arguments
      */
-    void updateBlinking(uint32_t nowMillis);
+    static void onFrameTimer(timer_callback_args_t* args);
+#endif
 };
 
 #endif // LED_CONTROLLER_H
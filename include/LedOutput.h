@@ -0,0 +1,165 @@
+/**
+ * @file LedOutput.h
+ * @brief Output backends that push LED strip pixel data to the WS2812 chain
+ *
+ * Backends (selected per strip via STRIP1_OUTPUT / STRIP2_OUTPUT):
+ *   LED_OUTPUT_NEOPIXEL - Adafruit_NeoPixel bit-bang. Blocks for the whole
+ *                         push with interrupts disabled.
+ *   LED_OUTPUT_SPI_DTC  - SPI0 MOSI driven by the DTC from an encoded,
+ *                         double-buffered copy of the pixels. show() only
+ *                         encodes; the frame transmits in the background
+ *                         with interrupts enabled. The strip's data line
+ *                         must be wired to LED_SPI_MOSI_PIN.
+ *
+ * Both read the strip's own pixel buffer (GRB, brightness applied), so
+ * LedController keeps using Adafruit_NeoPixel for pixel storage.
+ */
+
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "Config.h"
+
+// ============================================================================
+// NeoPixel strip with prefix refresh
+// ============================================================================
+
+/**
+ * WS2812 pixels latch the first 24 bits that reach them and forward the
+ * rest, so pushing only the first N pixels leaves the others unchanged.
+ */
+class PrefixNeoPixel : public Adafruit_NeoPixel {
+public:
+    using Adafruit_NeoPixel::Adafruit_NeoPixel;
+
+    /**
+     * @brief Push only the first pixels of the strip (blocking)
+     * @param count Number of pixels to push (clamped to strip length)
+     */
+    void showPrefix(uint16_t count);
+
+    /**
+     * @brief Get number of bytes per pixel
+     * @return Bytes per pixel (3 for GRB)
+     */
+    uint8_t bytesPerPixel() const;
+};
+
+// ============================================================================
+// Output Backend Interface
+// ============================================================================
+
+class LedOutput {
+public:
+    /**
+     * @brief Initialize the output hardware
+     */
+    virtual void begin() = 0;
+
+    /**
+     * @brief Push the first pixels of a strip
+     * @param strip Strip holding the pixel data
+     * @param count Number of pixels to push
+     */
+    virtual void show(PrefixNeoPixel& strip, uint16_t count) = 0;
+};
+
+// ============================================================================
+// Adafruit_NeoPixel Backend (blocking)
+// ============================================================================
+
+class NeoPixelOutput : public LedOutput {
+public:
+    void begin() override;
+    void show(PrefixNeoPixel& strip, uint16_t count) override;
+};
+
+// ============================================================================
+// SPI + DTC Backend (non-blocking, double-buffered)
+// ============================================================================
+
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC || STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC
+
+#include "r_spi.h"
+#include "r_dtc.h"
+
+// LEDs on the SPI-driven strip
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC
+constexpr uint16_t LED_SPI_STRIP_LEDS = NUM_LEDS_STRIP1;
+#else
+constexpr uint16_t LED_SPI_STRIP_LEDS = NUM_LEDS_STRIP2;
+#endif
+
+// Each WS2812 bit is sent as 3 SPI bits (0 = 100, 1 = 110)
+constexpr uint16_t LED_SPI_BYTES_PER_PIXEL = 9;
+
+// Trailing low bytes that form the >= 280us reset/latch gap
+constexpr uint16_t LED_SPI_RESET_BYTES = (uint32_t)LED_SPI_CLOCK_HZ * 300 / 8000000 + 1;
+
+constexpr uint16_t LED_SPI_BUFFER_SIZE = LED_SPI_STRIP_LEDS * LED_SPI_BYTES_PER_PIXEL + LED_SPI_RESET_BYTES;
+
+class SpiDtcOutput : public LedOutput {
+public:
+    SpiDtcOutput();
+
+    void begin() override;
+
+    /**
+     * @brief Encode a frame into the back buffer and queue it
+     * Returns immediately. A frame queued while another transmits replaces
+     * any older queued frame and starts as soon as the bus is free.
+     */
+    void show(PrefixNeoPixel& strip, uint16_t count) override;
+
+    /**
+     * @brief Check if a frame is transmitting
+     * @return true if the DTC is still feeding SPI
+     */
+    bool isTransmitting() const;
+
+private:
+    // Encoded frames; one transmits while the other is written
+    uint8_t m_buffers[2][LED_SPI_BUFFER_SIZE];
+    uint16_t m_lengths[2];
+
+    // Buffer being transmitted / queued next (-1 = none), shared with the ISR
+    volatile int8_t m_transmitting;
+    volatile int8_t m_queued;
+
+    // FSP driver instances
+    spi_instance_ctrl_t m_spiCtrl;
+    spi_cfg_t m_spiCfg;
+    spi_extended_cfg_t m_spiExt;
+    dtc_instance_ctrl_t m_dtcCtrl;
+    transfer_info_t m_dtcInfo;
+    dtc_extended_cfg_t m_dtcExt;
+    transfer_cfg_t m_dtcCfg;
+    transfer_instance_t m_dtc;
+
+    /**
+     * @brief Start transmitting a buffer (call with interrupts disabled)
+     * @param buffer Buffer index
+     */
+    void startTransfer(int8_t buffer);
+
+    /**
+     * @brief Encode GRB bytes into the SPI bit pattern
+     * @param pixels Source bytes
+     * @param numBytes Number of source bytes
+     * @param out Output buffer (3 bytes per source byte + reset gap)
+     * @return Number of bytes to transmit
+     */
+    static uint16_t encode(const uint8_t* pixels, uint16_t numBytes, uint8_t* out);
+
+    /**
+     * @brief SPI driver callback (interrupt context)
+     * @param args Callback arguments
+     */
+    static void onSpiEvent(spi_callback_args_t* args);
+};
+
+#endif // LED_OUTPUT_SPI_DTC
+
+#endif // LED_OUTPUT_H
@@ -0,0 +1,88 @@
+/**
+ * @file MemoryReport.h
+ * @brief RAM usage for the MEM command
+ *
+ * Free stack, stack high-water mark and free heap are read from the RA4M1
+ * linker symbols (__StackLimit, __HeapLimit). begin() paints the unused
+ * stack so the deepest point reached since boot can be found later.
+ * Component sizes are set once at boot by main.cpp; components not in the
+ * build stay at 0.
+ *
+ * On the host build (tests) there are no such symbols and the free stack
+ * and heap read as 0.
+ */
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// ============================================================================
+// Components
+// ============================================================================
+
+enum class MemoryComponent : uint8_t {
+    LEDS,       // LedController, strip pixel buffers and output backends
+    TOUCH,      // TouchController (incl. I2C engine)
+    COMMANDS,   // CommandController (RX ring, line buffer, command queue)
+    EVENTS,     // EventQueue (event queue, source rings, TX ring)
+    SETTINGS,   // SettingsStore
+    MOCK_PI,    // MockPiPrograms (only with ENABLE_MOCK_PI)
+    COUNT
+};
+
+constexpr uint8_t MEMORY_COMPONENT_COUNT = static_cast<uint8_t>(MemoryComponent::COUNT);
+
+// ============================================================================
+// MemoryReport Class
+// ============================================================================
+
+class MemoryReport {
+public:
+    /**
+     * @brief Paint the unused stack (call early in setup())
+     */
+    static void begin();
+
+    /**
+     * @brief Set the RAM used by a component
+     * @param component Component
+     * @param bytes Bytes (static and heap)
+     */
+    static void setComponent(MemoryComponent component, uint32_t bytes);
+
+    /**
+     * @brief Get the RAM used by a component
+     * @param component Component
+     * @return Bytes, 0 if not set
+     */
+    static uint32_t componentBytes(MemoryComponent component);
+
+    /**
+     * @brief Get the short name of a component (as reported by MEM)
+     * @param component Component
+     * @return Name
+     */
+    static const char* componentName(MemoryComponent component);
+
+    /**
+     * @brief Get the stack left below the current stack pointer
+     * @return Bytes
+     */
+    static uint32_t freeStack();
+
+    /**
+     * @brief Get the stack never used since begin()
+     * @return Bytes (still painted)
+     */
+    static uint32_t minFreeStack();
+
+    /**
+     * @brief Get the heap not yet claimed by malloc()
+     * @return Bytes between the heap top and the heap limit
+     */
+    static uint32_t freeHeap();
+};
+
+#endif // MEMORY_REPORT_H
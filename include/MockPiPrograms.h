@@ -9,6 +9,10 @@
  *   1. playSequenceSimple     - Sequential show/expect/success for each position
  *   2. playSequenceSimultaneous - Supports multi-touch steps with timing tolerance
  *   3. recordThenPlayback     - Record touches, then play them back
+ *   4. twoHandSequence        - Overlapping two-hand sequence with BLINK
+ *   5. stress                 - Load generator: commands at a set rate and
+ *                               mix plus simulated touches, with periodic
+ *                               throughput / reply latency / drop reports
  * 
  * Non-blocking state machine design - no delay() or blocking waits.
  * 
@@ -16,6 +20,8 @@
  *   - Sends commands via CommandController::injectCommand()
  *   - Monitors touch state by directly polling TouchController::isTouched()
  *   - Can also parse event lines fed via feedEventLine()
+ *   - The stress program sees replies through EventQueue::setMonitor() and
+ *     touches sensors through TouchController::setSimulatedTouches()
  */
 
 #ifndef MOCK_PI_PROGRAMS_H
@@ -27,6 +33,7 @@
 // Forward declarations
 class TouchController;
 class CommandController;
+class EventQueue;
 
 // ============================================================================
 // Configuration
@@ -45,6 +52,11 @@ constexpr uint32_t MOCK_PI_IDLE_THRESHOLD_MS = 1000;      // 1s idle to end reco
 constexpr uint32_t MOCK_PI_INTER_STEP_DELAY_MS = 100;     // Delay between steps
 constexpr uint32_t MOCK_PI_ACK_TIMEOUT_MS = 500;          // Wait for ACK before proceeding
 
+// Stress program
+constexpr uint32_t MOCK_PI_STRESS_HOLD_MS = 60;           // Simulated touch length (> debounce)
+constexpr uint8_t MOCK_PI_STRESS_TRACKED = 32;            // Commands awaiting a reply
+constexpr uint8_t MOCK_PI_STRESS_MAX_BURST = 8;           // Late commands caught up per update
+
 // ============================================================================
 // Program Selection
 // ============================================================================
@@ -54,7 +66,52 @@ enum class MockPiProgram : uint8_t {
     SEQUENCE_SIMPLE,          // Program 1: Simple sequential
     SEQUENCE_SIMULTANEOUS,    // Program 2: With simultaneous steps
     RECORD_PLAYBACK,          // Program 3: Record then playback
-    TWO_HAND_SEQUENCE         // Program 4: Two-hand overlapping sequence
+    TWO_HAND_SEQUENCE,        // Program 4: Two-hand overlapping sequence
+    STRESS                    // Program 5: Load generator / soak test
+};
+
+// ============================================================================
+// Stress Program Settings and Results
+// ============================================================================
+
+struct MockPiStressConfig {
+    uint16_t commandsPerSecond;   // Injection rate (0 = touches only)
+    uint8_t ledWeight;            // SHOW/HIDE/BLINK/STOP_BLINK on a random position
+    uint8_t expectWeight;         // EXPECT_DOWN plus a simulated touch there
+    uint8_t pingWeight;           // PING
+    uint8_t touchesPerSecond;     // Extra simulated touches (TOUCH_DOWN/UP events)
+    uint32_t durationMs;          // Stop after this long (0 = until stop())
+    uint16_t reportIntervalMs;    // Log a report this often
+    uint32_t seed;                // Random sequence (same seed, same commands)
+};
+
+constexpr MockPiStressConfig MOCK_PI_STRESS_DEFAULTS = {
+    100,    // commandsPerSecond
+    6,      // ledWeight
+    2,      // expectWeight
+    2,      // pingWeight
+    5,      // touchesPerSecond
+    0,      // durationMs
+    5000,   // reportIntervalMs
+    1       // seed
+};
+
+// Counters since the stress program started
+struct MockPiStressStats {
+    uint32_t sent;                // Commands injected
+    uint32_t behind;              // Command slots skipped because the loop fell behind
+    uint32_t replies;             // First replies matched to a command ID
+    uint32_t lost;                // No reply within MOCK_PI_ACK_TIMEOUT_MS, or before
+                                  // MOCK_PI_STRESS_TRACKED newer commands were sent
+    uint32_t busy;                // ERR busy replies
+    uint32_t errors;              // Other ERR replies
+    uint32_t touches;             // Simulated touches started
+    uint32_t touchEvents;         // TOUCH_* / TOUCHED_* events seen
+    uint32_t lines;               // Event lines seen
+    uint32_t bytes;               // Bytes of those lines (with line ending)
+    uint32_t dropped;             // Events the queue dropped
+    uint32_t latencyMaxUs;        // Slowest reply (injected -> formatted for TX)
+    uint64_t latencySumUs;        // For the average over all replies
 };
 
 // ============================================================================
@@ -113,7 +170,10 @@ enum class MockPiState : uint8_t {
     // Recording states
     RECORDING,                // Recording touches
     RECORDING_IDLE_CHECK,     // Checking if recording should end
-    PLAYBACK                  // Playing back recorded sequence
+    PLAYBACK,                 // Playing back recorded sequence
+    
+    // Stress state
+    STRESS                    // Injecting load (see startStress)
 };
 
 // ============================================================================
@@ -141,6 +201,12 @@ public:
      */
     void setCommandController(CommandController* cc) { m_commandController = cc; }
     
+    /**
+     * @brief Set the event queue reference (stress program replies and drops)
+     * @param eq Pointer to EventQueue
+     */
+    void setEventQueue(EventQueue* eq) { m_eventQueue = eq; }
+    
     /**
      * @brief Main update loop - call frequently from loop()
      */
@@ -184,6 +250,22 @@ public:
      */
     void startTwoHandSequence(const char* positions);
     
+    /**
+     * @brief Start Program 5: Stress / soak test
+     * Injects commands at config.commandsPerSecond in the configured mix and
+     * simulates touches, then logs throughput, reply latency and drops every
+     * config.reportIntervalMs. Commands are not echoed, so the only serial
+     * load is the firmware's own replies and the reports.
+     * @param config Rate, mix and duration
+     */
+    void startStress(const MockPiStressConfig& config);
+    
+    /**
+     * @brief Get the stress program counters
+     * @return Counters since startStress()
+     */
+    const MockPiStressStats& stressStats() const { return m_stressStats; }
+    
     /**
      * @brief Stop current program
      */
@@ -245,6 +327,80 @@ private:
     bool m_waitingForAck;
     uint8_t m_pendingCommands;
     
+    // Stress program
+    EventQueue* m_eventQueue;
+    MockPiStressConfig m_stressConfig;
+    MockPiStressStats m_stressStats;
+    MockPiStressStats m_stressReported;              // Counters at the last report
+    uint32_t m_stressRandom;                         // xorshift32 state
+    uint32_t m_stressStartTime;
+    uint32_t m_stressLastReport;
+    uint32_t m_stressNextCommandUs;
+    uint32_t m_stressNextTouchUs;
+    uint32_t m_stressDroppedBase;                    // Queue drop count at start
+    uint32_t m_stressIds[MOCK_PI_STRESS_TRACKED];    // Awaiting a reply (slot = id % N)
+    uint32_t m_stressSentUs[MOCK_PI_STRESS_TRACKED];
+    uint32_t m_stressHeld;                           // Simulated touches held
+    uint32_t m_stressReleaseTime[NUM_TOUCH_SENSORS]; // millis() to release each
+    uint32_t m_stressWindowMaxUs;                    // Slowest reply since the last report
+    
+    // === Stress Methods ===
+    
+    /**
+     * @brief Advance the stress program (inject, release touches, report)
+     */
+    void updateStress();
+    
+    /**
+     * @brief Inject one command picked from the configured mix
+     * @param now Current millis()
+     */
+    void sendStressCommand(uint32_t now);
+    
+    /**
+     * @brief Start a simulated touch on a free active position
+     * @param now Current millis()
+     * @param preferred Position index to touch, or 255 for a random one
+     * @return true if a touch was started
+     */
+    bool startStressTouch(uint32_t now, uint8_t preferred);
+    
+    /**
+     * @brief Count an event line sent by the firmware
+     * @param line Event line (with "ARDUINO> " prefix, no line ending)
+     */
+    void onStressLine(const char* line);
+    
+    /**
+     * @brief Count commands that got no reply in time
+     * @param nowUs Current micros()
+     */
+    void expireStressReplies(uint32_t nowUs);
+    
+    /**
+     * @brief Log throughput since the last report and the totals
+     * @param final true for the summary when the program ends
+     */
+    void reportStress(bool final);
+    
+    /**
+     * @brief End the stress program and release simulated touches
+     */
+    void endStress();
+    
+    /**
+     * @brief Next value of the stress program's random sequence
+     * @return Pseudo-random value
+     */
+    uint32_t nextStressRandom();
+    
+    /**
+     * @brief EventQueue monitor callback
+     * @param line Event line
+     * @param context MockPiPrograms instance
+     */
+    static void onEventLine(const char* line, void* context);
+    
     // === Internal Methods ===
     
     /**
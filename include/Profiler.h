@@ -0,0 +1,125 @@
+/**
+ * @file Profiler.h
+ * @brief Compile-time loop profiler (build with -D ENABLE_PROFILER=1)
+ *
+ * Records min/avg/max micros() per stage of loop(), plus I2C transfer
+ * time, strip push time and touch-to-event latency (first raw sample that
+ * differed to the event entering the TX ring). Loop iterations per second
+ * are counted over one-second windows.
+ *
+ * STATS reports one PROFILE line per stage. Reading a stage resets it, so
+ * each STATS covers the time since the previous one.
+ *
+ * With ENABLE_PROFILER 0 (default) every PROFILE_* macro compiles away.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// ============================================================================
+// Stages
+// ============================================================================
+
+enum class ProfileStage : uint8_t {
+    LOOP,            // Whole loop() iteration
+    POLL_SERIAL,     // CommandController::pollSerial()
+    PROCESS_LINES,   // CommandController::processCompletedLines()
+    COMMAND_TICK,    // CommandController::tick()
+    TOUCH_TICK,      // TouchController::tick()
+    LED_TICK,        // LedController::tick()
+    EVENT_FLUSH,     // EventQueue::flush()
+    I2C,             // One I2C bus transfer
+    STRIP_SHOW,      // One strip push (LedOutput::show)
+    TOUCH_LATENCY,   // Raw touch change to event formatted for TX
+    COUNT
+};
+
+constexpr uint8_t PROFILE_STAGE_COUNT = static_cast<uint8_t>(ProfileStage::COUNT);
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+struct ProfileStat {
+    uint32_t count;
+    uint32_t totalUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+};
+
+class Profiler {
+public:
+    /**
+     * @brief Add one measurement to a stage
+     * @param stage Stage
+     * @param us Duration in microseconds
+     */
+    static void record(ProfileStage stage, uint32_t us);
+
+    /**
+     * @brief Read a stage without resetting it
+     * @param stage Stage
+     * @return Statistics since the last reset()
+     */
+    static ProfileStat peek(ProfileStage stage);
+
+    /**
+     * @brief Start a new measurement window for a stage
+     * @param stage Stage
+     */
+    static void reset(ProfileStage stage);
+
+    /**
+     * @brief Get loop iterations per second
+     * @return Rate over the last complete one-second window
+     */
+    static uint32_t loopRate();
+
+    /**
+     * @brief Get the short name of a stage (as reported by STATS)
+     * @param stage Stage
+     * @return Name
+     */
+    static const char* stageName(ProfileStage stage);
+
+    /**
+     * @brief Record the latency of a touch event being formatted for TX
+     * @param edgeUs micros() of the sweep that first saw the raw change
+     */
+    static void touchSent(uint32_t edgeUs);
+};
+
+// ============================================================================
+// Scoped Timer
+// ============================================================================
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage) : m_stage(stage), m_start(micros()) {}
+    ~ProfileScope() { Profiler::record(m_stage, micros() - m_start); }
+
+private:
+    ProfileStage m_stage;
+    uint32_t m_start;
+};
+
+// ============================================================================
+// Instrumentation Macros
+// ============================================================================
+
+#if ENABLE_PROFILER
+#define PROFILE_SCOPE(stage)              ProfileScope profileScope(ProfileStage::stage)
+#define PROFILE_CALL(stage, call)         do { ProfileScope profileScope(ProfileStage::stage); call; } while (0)
+#define PROFILE_TOUCH_SENT(edgeUs)        Profiler::touchSent(edgeUs)
+#define PROFILE_STAGE_SENT(stage)         Profiler::reset(static_cast<ProfileStage>(stage))
+#else
+#define PROFILE_SCOPE(stage)              do { } while (0)
+#define PROFILE_CALL(stage, call)         do { call; } while (0)
+#define PROFILE_TOUCH_SENT(edgeUs)        do { } while (0)
+#define PROFILE_STAGE_SENT(stage)         do { } while (0)
+#endif
+
+#endif // PROFILER_H
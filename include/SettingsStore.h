@@ -0,0 +1,117 @@
+/**
+ * @file SettingsStore.h
+ * @brief Settings kept across resets in EEPROM (data flash on the UNO R4)
+ *
+ * One record at SETTINGS_EEPROM_ADDRESS: a header (magic, version, payload
+ * length), the StoredSettings payload and a checksum. A record that fails
+ * any of these checks is ignored and defaults are used until the next
+ * commit(). commit() only writes bytes that changed, so calling it on
+ * every boot does not wear the flash. Runtime changes are marked with
+ * markDirty() and committed by the owner once isCommitDue(). Bump
+ * SETTINGS_VERSION when the layout of StoredSettings changes.
+ */
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// ============================================================================
+// Stored Settings
+// ============================================================================
+
+struct StoredSettings {
+    // Sensor map from the last boot (see TouchController::begin)
+    uint8_t chipCount;        // Chips in the sensor table the map was built for
+    uint8_t layoutChecksum;   // Checksum of that sensor table
+    uint8_t clockStep;        // I2C_CLOCK_STEPS index all chips answered at
+    uint8_t reserved;
+    uint32_t activeChips;     // Chips (bit per chip table index) that answered
+
+    // Sensor tuning, per position (SENSITIVITY / THRESHOLD commands).
+    // Sensitivity is per chip, so positions on one chip share it.
+    uint8_t sensitivity[NUM_TOUCH_SENSORS];
+    uint8_t threshold[NUM_TOUCH_SENSORS];
+};
+
+// ============================================================================
+// SettingsStore Class
+// ============================================================================
+
+class SettingsStore {
+public:
+    SettingsStore();
+
+    /**
+     * @brief Read the stored record
+     * @return true if a valid record was found
+     */
+    bool begin();
+
+    /**
+     * @brief Check if the current settings came from a valid stored record
+     * @return true if loaded or committed since boot
+     */
+    bool isLoaded() const;
+
+    /**
+     * @brief Get the settings (change them, then commit())
+     * @return Settings
+     */
+    StoredSettings& settings();
+
+    /**
+     * @brief Get the settings
+     * @return Settings
+     */
+    const StoredSettings& settings() const;
+
+    /**
+     * @brief Write the record, skipping bytes that are already stored
+     * @return Number of bytes written
+     */
+    uint16_t commit();
+
+    /**
+     * @brief Note a change to be committed later
+     *
+     * Each call restarts the SETTINGS_COMMIT_DELAY_MS quiet time.
+     */
+    void markDirty();
+
+    /**
+     * @brief Check if there are changes not yet committed
+     * @return true if dirty
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Check if the changes have been quiet long enough to commit
+     * @param now Current millis()
+     * @return true if dirty and quiet for SETTINGS_COMMIT_DELAY_MS
+     */
+    bool isCommitDue(uint32_t now) const;
+
+    /**
+     * @brief CRC-8 (poly 0x07) over a block
+     * @param data Bytes
+     * @param length Number of bytes
+     * @param crc Running CRC (0 to start)
+     * @return Updated CRC
+     */
+    static uint8_t checksum(const uint8_t* data, size_t length, uint8_t crc = 0);
+
+private:
+    StoredSettings m_settings;
+    bool m_loaded;
+    bool m_dirty;
+    uint32_t m_dirtyTime;     // millis() of the last markDirty()
+
+    /**
+     * @brief Reset the settings to defaults
+     */
+    void setDefaults();
+};
+
+#endif // SETTINGS_STORE_H
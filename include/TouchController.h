@@ -1,11 +1,32 @@
 /**
  * @file TouchController.h
- * @brief Touch sensor controller for 25 CAP1188 capacitive touch sensors over I2C
+ * @brief Touch sensor controller for 25 CAP1188 capacitive touch positions over I2C
  * 
  * Protocol v2: Event-driven architecture
  * - Always polls sensors (not just in EXPECT mode)
  * - Emits TOUCH_DOWN/TOUCH_UP events on state changes
- * - Debounces touch inputs for reliable detection
+ * - Debounces touch inputs for reliable detection (2-bit vertical counters
+ *   over packed 32-bit masks, one bit per position)
+ * - Optional adaptive debounce (TOUCH_DEBOUNCE_ADAPTIVE): settled sensors
+ *   report the leading edge at once, followed by a per-sensor lockout
+ *   sized from the bounce seen on that sensor
+ * - Sensor reads run through I2cEngine in bounded time slices, so a sweep
+ *   never stalls the main loop
+ * - Hot positions (expected, touched or debouncing) are read every
+ *   TOUCH_HOT_POLL_INTERVAL_MS; idle ones share the rest of the same read
+ *   budget round-robin
+ * 
+ * - Optional ALERT mode (TOUCH_ALERT_ENABLED): only sensors whose ALERT
+ *   group signalled are read, with a slow background sweep as a safety net
+ * - Bus runs at the fastest I2C_CLOCK_STEPS speed all sensors answer at,
+ *   stepping down (with bus recovery) when errors pile up
+ * - Positions are mapped to CAP1188 inputs (SENSOR_INPUT_CHANNELS); one
+ *   status read per chip updates every position wired to it
+ * - Chips are initialized one register at a time across all chips; with
+ *   FAST_BOOT_ENABLED the sensor map stored at the previous boot is only
+ *   verified (see SettingsStore)
+ * - Per-position sensitivity and threshold are stored with the sensor map
+ *   and written back in the same init pass
  * 
  * Events:
  *   TOUCH_DOWN <letter> - Touch went from inactive -> active (debounced)
@@ -18,20 +39,33 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include "Config.h"
+#include "I2cEngine.h"
 
-// Forward declaration
+// Forward declarations
 class EventQueue;
+enum class EventSource : uint8_t;
+class SettingsStore;
 
 // ============================================================================
-// Touch State Per Sensor
+// CAP1188 Chip (one I2C device, up to 8 positions)
 // ============================================================================
 
-struct TouchSensorState {
-    bool active;              // Whether sensor responded to init
-    bool currentTouched;      // Current raw touch state
-    bool debouncedTouched;    // Debounced (stable) touch state
-    bool lastReportedTouched; // Last state reported via event
-    uint32_t lastChangeTime;  // When the raw state last changed
+struct TouchChip {
+    uint8_t address;          // I2C address
+    uint8_t inputMask;        // Enabled inputs (bit 0 = CS1)
+    uint8_t alertGroup;       // ALERT group (index into TOUCH_ALERT_PINS)
+    bool active;              // Whether chip responded to init
+    uint32_t positions;       // Positions (bitmask) wired to this chip
+};
+
+// ============================================================================
+// Bus Health Per Chip
+// ============================================================================
+
+struct SensorBusHealth {
+    uint16_t nackCount;       // Transfers not acknowledged
+    uint16_t timeoutCount;    // Bus timeouts / other bus errors
+    uint8_t nackRun;          // NACKs since the last acknowledged transfer
 };
 
 // ============================================================================
@@ -61,29 +95,82 @@ public:
     void setEventQueue(EventQueue* eventQueue);
 
     /**
-     * @brief Initialize all 25 CAP1188 sensors
+     * @brief Set the store for the sensor map kept across resets
+     * @param settings Pointer to a begun settings store (nullptr = none)
+     */
+    void setSettingsStore(SettingsStore* settings);
+
+    /**
+     * @brief Initialize all CAP1188 chips serving the 25 positions
+     * With FAST_BOOT_ENABLED and a stored sensor map, only the stored
+     * chips' answers at the stored bus speed are checked
      * @return true if at least one sensor was initialized
      */
     bool begin();
 
     /**
      * @brief Tick the touch controller (non-blocking)
-     * Polls sensors, debounces, and emits events
+     * Advances the sensor sweep by at most TOUCH_I2C_BUDGET_US, then
+     * debounces and emits events once a sweep completes
      * Call this every loop iteration
      */
     void tick();
 
     /**
-     * @brief Recalibrate a specific sensor
+     * @brief Start recalibrating sensors (non-blocking)
+     * The trigger writes go out back to back, one per chip, then every
+     * CALIBRATION_POLL_MS the chips' calibration-active bits are read
+     * until they clear or CALIBRATION_TIMEOUT_MS passes since the chip's
+     * own trigger
+     * @param sensorMask Sensors (bit 0 = A); inactive ones are skipped
+     * @return true if at least one active sensor is recalibrated
+     */
+    bool startRecalibration(uint32_t sensorMask);
+
+    /**
+     * @brief Check if any of the sensors' chips is still calibrating
+     * @param sensorMask Sensors (bit 0 = A)
+     * @return true until every chip confirmed or timed out
+     */
+    bool isRecalibrating(uint32_t sensorMask) const;
+
+    /**
+     * @brief Get sensors whose last recalibration was not confirmed
+     * @param sensorMask Sensors to check (bit 0 = A)
+     * @return Failed sensors (trigger NACKed or timed out)
+     */
+    uint32_t getRecalibrationFailures(uint32_t sensorMask) const;
+
+    /**
+     * @brief Set the sensitivity of a sensor's chip (queued, stored)
+     * Positions on the same chip share the level
      * @param sensorIndex Sensor index (0-24)
-     * @return true if successful
+     * @param level 0 (most sensitive) - MAX_SENSITIVITY
+     * @return true if the write was queued
      */
-    bool recalibrate(uint8_t sensorIndex);
+    bool setSensitivity(uint8_t sensorIndex, uint8_t level);
 
     /**
-     * @brief Recalibrate all active sensors
+     * @brief Set the touch threshold of a sensor's input (queued, stored)
+     * @param sensorIndex Sensor index (0-24)
+     * @param threshold 0 - MAX_TOUCH_THRESHOLD (higher needs a stronger touch)
+     * @return true if the write was queued
+     */
+    bool setThreshold(uint8_t sensorIndex, uint8_t threshold);
+
+    /**
+     * @brief Get the sensitivity level applied to a sensor
+     * @param sensorIndex Sensor index (0-24)
+     * @return Level (DEFAULT_SENSITIVITY without a settings store)
+     */
+    uint8_t getSensitivity(uint8_t sensorIndex) const;
+
+    /**
+     * @brief Get the touch threshold applied to a sensor
+     * @param sensorIndex Sensor index (0-24)
+     * @return Threshold (DEFAULT_TOUCH_THRESHOLD without a settings store)
      */
-    void recalibrateAll();
+    uint8_t getThreshold(uint8_t sensorIndex) const;
 
     /**
      * @brief Set expectation for touch down at position
@@ -138,6 +225,63 @@ public:
      */
     uint8_t getActiveSensorCount() const;
 
+    /**
+     * @brief Get active sensors
+     * @return Bitmask (bit i = sensor i initialized successfully)
+     */
+    uint32_t getActiveSensorMask() const;
+
+    /**
+     * @brief Get debounced touch state of all sensors
+     * @return Bitmask (bit i = sensor i touched)
+     */
+    uint32_t getTouchedMask() const;
+
+    /**
+     * @brief Take debounced edges accumulated since the last call
+     * Edges are consumed, so only one consumer should call this
+     * @param pressed Output: sensors that went inactive -> active
+     * @param released Output: sensors that went active -> inactive
+     */
+    void getEdgeMasks(uint32_t& pressed, uint32_t& released);
+
+    /**
+     * @brief Report positions as touched on top of the sensor readings
+     * For load tests (Mock Pi): the positions go through the same reads,
+     * debounce and events as real touches. Only active sensors count.
+     * @param mask Sensors to report touched (bit 0 = A), 0 to stop
+     */
+    void setSimulatedTouches(uint32_t mask);
+
+    /**
+     * @brief Get the simulated touches
+     * @return Sensors reported touched regardless of the hardware
+     */
+    uint32_t getSimulatedTouches() const;
+
+    /**
+     * @brief Choose the event source the touch events are queued on
+     * Use a non-LOOP source when tick() runs in an interrupt; it must then
+     * be the only producer on that source.
+     * @param source Event source (default LOOP)
+     */
+    void setEventSource(EventSource source);
+
+    /**
+     * @brief Get the current I2C bus clock
+     * @return Bus clock (Hz)
+     */
+    uint32_t getBusClock() const;
+
+    /**
+     * @brief Build bus health summary for INFO
+     * Format: "i2c=<hz> nack=<n> timeout=<n> worst=<letter>:<n>"
+     * (worst is "-" if no errors were recorded)
+     * @param buffer Output buffer (should be at least 64 chars)
+     * @param bufferSize Size of buffer
+     */
+    void buildBusInfo(char* buffer, size_t bufferSize) const;
+
     // === Utility Methods ===
 
     /**
@@ -157,16 +301,55 @@ public:
     /**
      * @brief Convert I2C address to sensor index
      * @param address I2C address
-     * @return Sensor index 0-24, or 255 if not found
+     * @return First sensor index 0-24 on that chip, or 255 if not found
      */
     static uint8_t addressToIndex(uint8_t address);
 
 private:
-    // Event queue for emitting events
+    // Event queue for emitting events, and the source they are queued on
     EventQueue* m_eventQueue;
+    EventSource m_eventSource;
+
+    // Sensor bus transaction engine
+    I2cEngine m_i2c;
 
-    // Per-sensor state
-    TouchSensorState m_sensors[NUM_TOUCH_SENSORS];
+    // Sensor map and tuning kept across resets (nullptr = probe on every
+    // boot, default tuning)
+    SettingsStore* m_settings;
+
+    // Per-sensor state, one bit per sensor
+    uint32_t m_activeMask;       // Sensor's chip responded to init
+    uint32_t m_rawMask;          // Current raw touch state
+    uint32_t m_debouncedMask;    // Debounced (stable) touch state
+    uint32_t m_reportedMask;     // Last state reported via event
+    uint32_t m_simulatedMask;    // Reported touched regardless of the chip
+
+    // Vertical debounce counters (bit i of both = 2-bit count for sensor i)
+    uint32_t m_debounceCount0;
+    uint32_t m_debounceCount1;
+
+    // Adaptive debounce state (TOUCH_DEBOUNCE_ADAPTIVE)
+    uint32_t m_lastRawMask;      // Raw state of the previous sample
+    uint32_t m_settledMask;      // Raw matched debounced, not locked out
+    uint32_t m_lockedMask;       // Holding after an accepted change
+    uint32_t m_bouncedMask;      // Bounced during the current lockout
+    uint32_t m_noisyMask;        // Noise estimate at DEBOUNCE_NOISY_LEVEL or above
+    uint8_t m_lockLeft[NUM_TOUCH_SENSORS];  // Lockout samples left
+    uint8_t m_noise[NUM_TOUCH_SENSORS];     // Learned noise estimate
+
+    // micros() of each sensor's last debounce step (counter or lockout)
+    uint32_t m_stepUs[NUM_TOUCH_SENSORS];
+
+    // Debounced edges not yet taken by getEdgeMasks()
+    uint32_t m_pressedEdges;
+    uint32_t m_releasedEdges;
+
+    // Chip table index per sensor
+    uint8_t m_sensorChip[NUM_TOUCH_SENSORS];
+
+    // Chip table built from SENSOR_I2C_ADDRESSES / SENSOR_INPUT_CHANNELS
+    TouchChip m_chips[NUM_TOUCH_SENSORS];
+    uint8_t m_chipCount;
 
     // Expectation tracking for EXPECT_DOWN/EXPECT_UP commands
     ExpectState m_expectDown[NUM_TOUCH_SENSORS];
@@ -175,57 +358,255 @@ private:
     // Timestamp of last sensor poll
     uint32_t m_lastPollTime;
 
+    // Timestamp of last full sweep (ALERT mode only)
+    uint32_t m_lastSweepTime;
+
+    // Chips (bitmask) whose status read is not yet queued this sweep
+    uint32_t m_sweepPending;
+
+    // Positions read by the current sweep (debounce advances only these)
+    uint32_t m_sweepPositions;
+
+    // Chip reads per poll (full sweep per TOUCH_POLL_INTERVAL_MS, spread)
+    uint8_t m_readsPerPoll;
+
+    // Round-robin positions (chip index) for hot and idle reads
+    uint8_t m_hotCursor;
+    uint8_t m_idleCursor;
+
+    // Whether a sweep is in progress
+    bool m_sweepActive;
+
+    // micros() when the current sweep started
+    uint32_t m_sweepStartUs;
+
+    // micros() of the sweep that first saw each sensor's pending change
+    uint32_t m_edgeUs[NUM_TOUCH_SENSORS];
+
+    // Bitmask of ALERT groups signalled since last poll (set from ISR)
+    static volatile uint8_t s_pendingAlertGroups;
+
     // Number of successfully initialized sensors
     uint8_t m_activeSensorCount;
 
+    // Per-chip error counters
+    SensorBusHealth m_busHealth[NUM_TOUCH_SENSORS];
+
+    // Current index into I2C_CLOCK_STEPS, and the one selected at boot
+    uint8_t m_clockStep;
+    uint8_t m_bootClockStep;
+
+    // Bus errors in the current health window
+    uint8_t m_windowErrors;
+
+    // Start of the current health window
+    uint32_t m_windowStart;
+
+    // Health windows without bus errors in a row
+    uint8_t m_cleanWindows;
+
+    // Last bus recovery, and the time to wait before the next one
+    uint32_t m_lastRecovery;
+    uint32_t m_recoveryBackoff;
+
+    // Chips taken offline after repeated NACKs (bit per chip), probed
+    // again round-robin
+    uint32_t m_offlineChips;
+    uint32_t m_lastReprobe;
+    uint8_t m_reprobeCursor;
+
+    // Recalibration, chip bitmasks (bit per chip table index)
+    uint32_t m_calWrites;        // Trigger write not yet queued
+    uint32_t m_calPending;       // Calibrating, not yet confirmed
+    uint32_t m_calPolls;         // Status read not yet queued this poll
+    uint32_t m_calInFlight;      // Status read queued, result not handled
+    uint32_t m_calStale;         // Queued status read predates a new trigger
+    uint32_t m_calFailed;        // Positions (not chips) not confirmed
+    uint8_t m_calInputs[NUM_TOUCH_SENSORS];  // Inputs calibrating per chip
+    uint32_t m_lastCalPoll;
+    uint32_t m_calDeadline[NUM_TOUCH_SENSORS];  // Per chip, millis() when it times out (set when its trigger is queued)
+
     // === I2C Methods ===
 
     /**
-     * @brief Initialize a single CAP1188 sensor
-     * @param address I2C address
-     * @return true if successful
+     * @brief Group positions by I2C address into the chip table
      */
-    bool initSensor(uint8_t address);
+    void buildChipTable();
 
     /**
-     * @brief Read a register from a CAP1188 sensor
-     * @param address I2C address
-     * @param reg Register address
-     * @param value Output value
-     * @return true if successful
+     * @brief Initialize chips at the current bus clock, one register at a
+     * time across all of them (a chip that fails a step is dropped)
+     * @param chips Chips to initialize (bit per chip table index)
+     * @return Chips that completed initialization
      */
-    bool readRegister(uint8_t address, uint8_t reg, uint8_t& value);
+    uint32_t initChips(uint32_t chips);
 
     /**
-     * @brief Write a register to a CAP1188 sensor
-     * @param address I2C address
-     * @param reg Register address
-     * @param value Value to write
-     * @return true if successful
+     * @brief Get the value a chip init step writes to a chip
+     * @param source ChipInitValue of the step
+     * @param value Fixed value of the step
+     * @param chipIndex Index into the chip table
+     * @param channel Input (0-7) for per-input steps
+     * @return Register value
      */
-    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+    uint8_t chipInitValue(uint8_t source, uint8_t value, uint8_t chipIndex, uint8_t channel) const;
 
     /**
-     * @brief Read raw touch state from a sensor
-     * @param address I2C address
-     * @return true if CS1 is touched
+     * @brief Initialize chips from the stored sensor map
+     * @return Chips that answered, or 0 if there is no usable map or a
+     * stored chip did not answer
+     */
+    uint32_t initFromStoredMap();
+
+    /**
+     * @brief Store the current sensor map (written only if it changed)
      */
-    bool readRawTouch(uint8_t address);
+    void storeSensorMap();
+
+    /**
+     * @brief Checksum of the chip table the sensor map refers to
+     * @return Checksum
+     */
+    uint8_t chipTableChecksum() const;
 
     /**
      * @brief Try to recover a stuck I2C bus
+     * @param clockHz Bus clock to restart at
+     * @param settleMs Pause after restarting (ms)
+     */
+    void recoverI2CBus(uint32_t clockHz, uint16_t settleMs);
+
+    /**
+     * @brief Select the fastest clock step all active sensors answer at
+     */
+    void selectBusClock();
+
+    /**
+     * @brief Count a failed transfer against a chip
+     * @param chipIndex Index into the chip table
+     * @param error Error classification
+     */
+    void recordBusError(uint8_t chipIndex, I2cError error);
+
+    /**
+     * @brief Step the clock down and recover the bus if the error rate is
+     * too high, step it back up after clean windows, and take chips that
+     * stopped answering offline (or back online)
+     * Only called between sweeps, while the engine is idle
+     * @param now Current time from millis()
+     */
+    void checkBusHealth(uint32_t now);
+
+    /**
+     * @brief Stop reading a chip and release its positions
+     * @param chipIndex Index into the chip table
+     */
+    void takeChipOffline(uint8_t chipIndex);
+
+    /**
+     * @brief Probe one offline chip and re-initialize it if it answers
+     * Blocking (one read, plus the chip init if it answered)
+     */
+    void reprobeOfflineChip();
+
+    /**
+     * @brief Start a sweep over the chips picked for this poll
+     * @param now Current time from millis()
      */
-    void recoverI2CBus();
+    void startSweep(uint32_t now);
 
     /**
-     * @brief Poll all sensors and update raw states
+     * @brief Get chips with a hot position (expected, touched, debouncing
+     *        or in an adaptive lockout)
+     * @return Bitmask of chips
      */
-    void pollSensors();
+    uint32_t collectHotChips() const;
 
     /**
-     * @brief Process debouncing and emit events
+     * @brief Pick this poll's reads: hot chips first, idle ones round-robin
+     * At least one read is left for idle chips while there are any.
+     * @param activeMask Chips that responded to init
+     * @param hotMask Hot chips
+     * @return Bitmask of chips to read
+     */
+    uint32_t pickPollChips(uint32_t activeMask, uint32_t hotMask);
+
+    /**
+     * @brief Take up to count chips from a mask, starting at a cursor
+     * @param mask Candidate chips
+     * @param count Most chips to take
+     * @param cursor Chip index to start at; moved past the last one taken
+     * @return Bitmask of chips taken
+     */
+    uint32_t takeRoundRobin(uint32_t mask, uint8_t count, uint8_t& cursor) const;
+
+    /**
+     * @brief Queue status reads for the current sweep while there is room
+     */
+    void scheduleSweepReads();
+
+    /**
+     * @brief Queue recalibration triggers and calibration status reads
+     * @param now Current millis()
+     */
+    void scheduleCalibration(uint32_t now);
+
+    /**
+     * @brief Handle a completed calibration trigger or status read
+     * @param t Completed transaction
+     */
+    void handleCalibration(const I2cTransaction& t);
+
+    /**
+     * @brief Handle a completed I2C transaction
+     * @param t Completed transaction
+     */
+    void handleTransaction(const I2cTransaction& t);
+
+    // === ALERT Mode ===
+
+    /**
+     * @brief Configure ALERT pins and attach their interrupts
+     */
+    void beginAlertInterrupts();
+
+    /**
+     * @brief Collect chips in signalled ALERT groups (plus touched ones)
+     * @return Bitmask of chips to read
+     */
+    uint32_t collectAlertedChips();
+
+    /**
+     * @brief ALERT pin interrupt handler for one group
+     */
+    template <uint8_t Group>
+    static void onAlert();
+
+    /**
+     * @brief Advance the debounce counters by one sample and emit events
      */
     void processDebounce();
+
+    /**
+     * @brief Pick the sensors whose debounce state steps on this sweep
+     * A sensor steps on its first differing read, then at most once per
+     * DEBOUNCE_STEP_US however often it is read.
+     * @param candidates Sensors read by this sweep that differ or are locked
+     * @param fresh Sensors whose change was seen for the first time
+     * @return Sensors that step
+     */
+    uint32_t collectDueSteps(uint32_t candidates, uint32_t fresh);
+
+    /**
+     * @brief Apply the adaptive debounce rules to one sample
+     * Runs the lockouts, learns per-sensor noise from bounces and adds the
+     * leading edges of settled, quiet sensors to the counted changes.
+     * @param delta Sensors whose raw state differs from the debounced one
+     * @param counted Changes the vertical counters accepted this sample
+     * @param due Sensors whose debounce state steps this sample
+     * @return Changes to apply
+     */
+    uint32_t adaptDebounce(uint32_t delta, uint32_t counted, uint32_t due);
 };
 
 #endif // TOUCH_CONTROLLER_H
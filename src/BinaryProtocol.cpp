@@ -0,0 +1,191 @@
+/**
+ * @file BinaryProtocol.cpp
+ * @brief Implementation of the binary frame helpers (CRC-8, varint, COBS, base64)
+ */
+
+#include "BinaryProtocol.h"
+
+/**
+ * @brief Map a base64 character to its 6-bit value
+ * @return Value, or 0xFF if not a base64 character
+ */
+static uint8_t base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return 0xFF;
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+uint8_t BinaryProtocol::crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    
+    return crc;
+}
+
+size_t BinaryProtocol::putVarint(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    
+    return n;
+}
+
+size_t BinaryProtocol::getVarint(const uint8_t* in, size_t len, uint32_t& value) {
+    value = 0;
+    
+    for (size_t n = 0; n < len && n < 5; n++) {
+        value |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            return n + 1;
+        }
+    }
+    
+    return 0;  // Ran out of bytes, or more than 32 bits
+}
+
+size_t BinaryProtocol::finishFrame(uint8_t* frame, size_t len, uint8_t* out) {
+    frame[len] = crc8(frame, len);
+    
+    size_t n = cobsEncode(frame, len + 1, out);
+    out[n++] = BINARY_FRAME_DELIMITER;
+    return n;
+}
+
+size_t BinaryProtocol::openFrame(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t n = cobsDecode(in, len, out);
+    
+    // Need at least opcode + position + CRC
+    if (n < 3) {
+        return 0;
+    }
+    
+    n--;
+    if (crc8(out, n) != out[n]) {
+        return 0;
+    }
+    
+    return n;
+}
+
+size_t BinaryProtocol::base64Decode(const char* in, size_t len, uint8_t* out, size_t size) {
+    // Strip padding; the remaining length says how the last group ends
+    while (len > 0 && in[len - 1] == '=') {
+        len--;
+    }
+    if (len % 4 == 1 || len * 3 / 4 > size) {
+        return 0;
+    }
+    
+    size_t n = 0;
+    uint32_t bits = 0;
+    uint8_t count = 0;
+    
+    for (size_t i = 0; i < len; i++) {
+        uint8_t v = base64Value(in[i]);
+        if (v == 0xFF) {
+            return 0;
+        }
+        
+        bits = (bits << 6) | v;
+        if (++count == 4) {
+            out[n++] = (uint8_t)(bits >> 16);
+            out[n++] = (uint8_t)(bits >> 8);
+            out[n++] = (uint8_t)bits;
+            bits = 0;
+            count = 0;
+        }
+    }
+    
+    // Partial group: 2 chars = 1 byte, 3 chars = 2 bytes
+    if (count == 2) {
+        out[n++] = (uint8_t)(bits >> 4);
+    } else if (count == 3) {
+        out[n++] = (uint8_t)(bits >> 10);
+        out[n++] = (uint8_t)(bits >> 2);
+    }
+    
+    return n;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+size_t BinaryProtocol::cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    // Each block starts with a code byte = distance to the next zero
+    size_t codeIndex = 0;
+    size_t outIndex = 1;
+    uint8_t code = 1;
+    
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+            continue;
+        }
+        
+        out[outIndex++] = in[i];
+        code++;
+        
+        // Full 254-byte block without a zero
+        if (code == 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+        }
+    }
+    
+    out[codeIndex] = code;
+    return outIndex;
+}
+
+size_t BinaryProtocol::cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t inIndex = 0;
+    size_t outIndex = 0;
+    
+    while (inIndex < len) {
+        uint8_t code = in[inIndex++];
+        if (code == 0 || inIndex + code - 1 > len) {
+            return 0;
+        }
+        
+        for (uint8_t i = 1; i < code; i++) {
+            out[outIndex++] = in[inIndex++];
+        }
+        
+        // A block shorter than 254 bytes stood for a zero, except the last
+        if (code != 0xFF && inIndex < len) {
+            out[outIndex++] = 0;
+        }
+    }
+    
+    return outIndex;
+}
@@ -5,13 +5,20 @@
  * Protocol v2 implementation with:
  * - Non-blocking serial read via ring buffer
  * - Command ID support for request-response correlation
- * - Long-running command support (SCAN, SUCCESS animation)
+ * - Long-running command support (SCAN, RECALIBRATE, SUCCESS animation, PLAY)
+ * - Optional binary framing (MODE BINARY)
  */
 
 #include "CommandController.h"
 #include "LedController.h"
 #include "TouchController.h"
 #include "EventQueue.h"
+#include "BinaryProtocol.h"
+#include "Effects.h"
+#include "Profiler.h"
+
+// Every position (RECALIBRATE_ALL)
+static constexpr uint32_t ALL_POSITIONS_MASK = (1UL << NUM_TOUCH_SENSORS) - 1;
 
 // ============================================================================
 // Constructor
@@ -23,10 +30,22 @@ CommandController::CommandController(LedController& ledController,
     : m_ledController(ledController)
     , m_touchController(touchController)
     , m_eventQueue(eventQueue)
+    , m_animationSource(EventSource::LOOP)
     , m_rxHead(0)
     , m_rxTail(0)
+    , m_rxScan(0)
+    , m_rxDiscarding(false)
     , m_lineIndex(0)
     , m_lineOverflow(false)
+    , m_binaryMode(false)
+    , m_baudRate(SERIAL_BAUD_RATE)
+    , m_fallbackBaudRate(SERIAL_BAUD_RATE)
+    , m_linkConfirmed(false)
+    , m_batchActive(false)
+    , m_batchId(NO_COMMAND_ID)
+    , m_batchStart(0)
+    , m_freeHead(0)
+    , m_laneHead{NO_COMMAND_SLOT, NO_COMMAND_SLOT}
 {
 }
 
@@ -36,40 +55,80 @@ CommandController::CommandController(LedController& ledController,
 
 void CommandController::begin() {
     // Clear ring buffer
-    m_rxHead = 0;
-    m_rxTail = 0;
+    resetRx();
     
     // Clear line buffer
     m_lineIndex = 0;
     m_lineOverflow = false;
     memset(m_lineBuffer, 0, sizeof(m_lineBuffer));
+    m_binaryMode = false;
     
-    // Clear command queue
+    // Clear command queue - every slot on the free list
     for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
         m_commandQueue[i].active = false;
+        m_commandQueue[i].next = (i + 1 < COMMAND_QUEUE_SIZE) ? i + 1 : NO_COMMAND_SLOT;
+    }
+    m_freeHead = 0;
+    for (uint8_t i = 0; i < COMMAND_LANE_COUNT; i++) {
+        m_laneHead[i] = NO_COMMAND_SLOT;
     }
 }
 
 void CommandController::pollSerial() {
-    // Read all available bytes into ring buffer (non-blocking)
-    while (Serial.available() > 0) {
-        char c = Serial.read();
+    // Move everything the UART driver holds into the ring in bulk copies
+    // (non-blocking: never asks for more than available())
+    int available = PI_SERIAL.available();
+    uint16_t dropped = 0;
+    
+    while (available > 0) {
+        if (m_rxDiscarding) {
+            // Skip the rest of a message that did not fit
+            char c = PI_SERIAL.read();
+            available--;
+            dropped++;
+            m_rxDiscarding = !isDelimiter(c);
+            continue;
+        }
+        
+        // Contiguous free space from the head (leave one slot empty)
+        uint16_t room = (m_rxTail > m_rxHead)
+            ? (m_rxTail - m_rxHead - 1)
+            : (sizeof(m_rxBuffer) - m_rxHead - (m_rxTail == 0 ? 1 : 0));
         
-        // Calculate next head position
-        uint8_t nextHead = (m_rxHead + 1) % sizeof(m_rxBuffer);
+        if (room == 0) {
+            // Ring full - the message being received cannot complete. Drop
+            // its start from the ring and its remaining bytes as they arrive,
+            // so no command is ever spliced together across the gap.
+            dropped += dropPartialMessage();
+            m_rxDiscarding = true;
+            continue;
+        }
         
-        // Check for buffer full (leave one slot empty)
-        if (nextHead != m_rxTail) {
-            m_rxBuffer[m_rxHead] = c;
-            m_rxHead = nextHead;
+        size_t chunk = (size_t)available < room ? (size_t)available : room;
+        size_t n = PI_SERIAL.readBytes(&m_rxBuffer[m_rxHead], chunk);
+        if (n == 0) {
+            break;
         }
-        // If buffer full, silently drop characters
+        m_rxHead = (m_rxHead + n) % sizeof(m_rxBuffer);
+        available -= n;
+    }
+    
+    if (dropped > 0) {
+        m_eventQueue.queueRxOverflow(dropped);
     }
 }
 
 void CommandController::processCompletedLines() {
-    // Try to extract and process complete lines
-    while (extractLine()) {
+    // Try to extract and process complete lines (or frames in binary mode).
+    // Framing is re-checked per message so MODE applies to the bytes after it.
+    // Commands wait in the RX buffer while their replies would not fit.
+    while (m_eventQueue.freeSlots() >= EVENT_SLOTS_PER_COMMAND &&
+           (m_binaryMode ? extractFrame() : extractLine())) {
+        if (m_binaryMode) {
+            processFrame();
+            continue;
+        }
+        
         // Check for overflow condition
         if (m_lineOverflow) {
             m_eventQueue.queueError("line_too_long", NO_COMMAND_ID);
@@ -90,27 +149,32 @@ void CommandController::processCompletedLines() {
             continue;
         }
         
+        // A line that parsed proves the link works at the current rate.
+        // Injected commands (mock Pi) never went over the link.
+        m_linkConfirmed = true;
+        
         // Execute the command
         executeCommand(cmd);
     }
 }
 
 void CommandController::tick() {
-    // Tick all active long-running commands
-    for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
-        if (m_commandQueue[i].active) {
-            tickCommand(m_commandQueue[i]);
-        }
+    uint32_t now = millis();
+    
+    // Abandon a BATCH whose END never arrived
+    if (m_batchActive && now - m_batchStart >= BATCH_TIMEOUT_MS) {
+        endBatch();
+        m_eventQueue.queueError("batch_timeout", m_batchId);
     }
+    
+    // Only due commands are ticked. Animation DONEs yield to replies for
+    // new commands (PING, EXPECT_*); they are merely delayed, never lost.
+    tickLane(CommandLane::CONTROL, now, 0);
+    tickLane(CommandLane::ANIMATION, now, EVENT_SLOTS_PER_COMMAND);
 }
 
 bool CommandController::isQueueFull() const {
-    for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
-        if (!m_commandQueue[i].active) {
-            return false;
-        }
-    }
-    return true;
+    return m_freeHead == NO_COMMAND_SLOT;
 }
 
 void CommandController::injectCommand(const char* line) {
@@ -133,6 +197,14 @@ void CommandController::injectCommand(const char* line) {
     executeCommand(cmd);
 }
 
+bool CommandController::isBinaryMode() const {
+    return m_binaryMode;
+}
+
+void CommandController::setAnimationEventSource(EventSource source) {
+    m_animationSource = source;
+}
+
 // ============================================================================
 // Serial/Parsing Methods
 // ============================================================================
@@ -141,36 +213,12 @@ bool CommandController::extractLine() {
     m_lineIndex = 0;
     m_lineOverflow = false;
     
-    // Check if theres data in ring buffer
-    if (m_rxHead == m_rxTail) {
-        return false;  // Buffer empty
-    }
-    
-    // Scan for newline
-    uint8_t pos = m_rxTail;
-    bool foundNewline = false;
-    
-    while (pos != m_rxHead) {
-        char c = m_rxBuffer[pos];
-        
-        if (c == '\n' || c == '\r') {
-            foundNewline = true;
-            break;
-        }
-        
-        pos = (pos + 1) % sizeof(m_rxBuffer);
-    }
-    
-    if (!foundNewline) {
+    if (!scanForDelimiter()) {
         // Check if we've accumulated too much without newline
-        uint8_t pending = (m_rxHead >= m_rxTail) 
-            ? (m_rxHead - m_rxTail)
-            : (sizeof(m_rxBuffer) - m_rxTail + m_rxHead);
-            
-        if (pending >= MAX_LINE_LEN) {
+        if (rxPending() >= MAX_LINE_LEN) {
             // Discard everything up to MAX_LINE_LEN
             m_lineOverflow = true;
-            m_rxTail = (m_rxTail + MAX_LINE_LEN) % sizeof(m_rxBuffer);
+            discardRx(MAX_LINE_LEN);
             return true;  // Signal to caller that we have an overflow
         }
         
@@ -178,30 +226,25 @@ bool CommandController::extractLine() {
     }
     
     // Extract characters up to newline
-    while (m_rxTail != m_rxHead) {
-        char c = m_rxBuffer[m_rxTail];
-        m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
-        
-        // Stop at newline
-        if (c == '\n' || c == '\r') {
-            // Skip any additional CR/LF
-            while (m_rxTail != m_rxHead) {
-                char next = m_rxBuffer[m_rxTail];
-                if (next != '\n' && next != '\r') {
-                    break;
-                }
-                m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
-            }
-            break;
-        }
-        
+    while (m_rxTail != m_rxScan) {
         // Add to line buffer if room
         if (m_lineIndex < MAX_LINE_LEN - 1) {
-            m_lineBuffer[m_lineIndex++] = c;
+            m_lineBuffer[m_lineIndex++] = m_rxBuffer[m_rxTail];
         } else {
             m_lineOverflow = true;
         }
+        m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
+    }
+    
+    // Skip the newline and any additional CR/LF
+    while (m_rxTail != m_rxHead) {
+        char next = m_rxBuffer[m_rxTail];
+        if (next != '\n' && next != '\r') {
+            break;
+        }
+        m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
     }
+    m_rxScan = m_rxTail;
     
     // Null-terminate
     m_lineBuffer[m_lineIndex] = '\0';
@@ -215,8 +258,13 @@ bool CommandController::parseLine(const char* line, ParsedCommand& cmd) {
     cmd.hasPosition = false;
     cmd.position = 0;
     cmd.positionIndex = 255;
+    cmd.positionMask = 0;
     cmd.hasId = false;
     cmd.id = NO_COMMAND_ID;
+    cmd.hasArg = false;
+    cmd.arg = 0;
+    cmd.pixels = nullptr;
+    cmd.pixelCount = 0;
     cmd.valid = false;
     
     const char* ptr = skipWhitespace(line);
@@ -283,7 +331,9 @@ bool CommandController::parseLine(const char* line, ParsedCommand& cmd) {
         const char* tokenEnd = findTokenEnd(ptr);
         size_t tokenLen = tokenEnd - tokenStart;
         
-        if (tokenLen == 1) {
+        bool digit = *tokenStart >= '0' && *tokenStart <= '9';
+        if (tokenLen == 1 && cmd.action != CommandAction::FRAME &&
+            !(digit && actionRequiresArgument(cmd.action))) {
             // Single character - could be position
             char c = *tokenStart;
             uint8_t idx = charToIndex(c);
@@ -292,10 +342,35 @@ bool CommandController::parseLine(const char* line, ParsedCommand& cmd) {
                 cmd.hasPosition = true;
                 cmd.position = (c >= 'a' && c <= 'z') ? (c - 32) : c;  // Uppercase
                 cmd.positionIndex = idx;
+                cmd.positionMask = 1UL << idx;
             } else {
                 m_eventQueue.queueError("unknown_position", cmd.hasId ? cmd.id : NO_COMMAND_ID);
                 return false;
             }
+        } else if (actionAcceptsPositionList(cmd.action) && memchr(tokenStart, ',', tokenLen)) {
+            // Position list - applied in one frame
+            if (!parsePositionList(tokenStart, tokenLen, cmd.positionMask)) {
+                m_eventQueue.queueError("unknown_position", cmd.hasId ? cmd.id : NO_COMMAND_ID);
+                return false;
+            }
+            cmd.hasPosition = true;
+            cmd.position = 0;
+            cmd.positionIndex = 255;
+        } else if (cmd.action == CommandAction::FRAME && cmd.hasArg && !cmd.pixels) {
+            // Pixel data after the offset - decoded once, copied as a block
+            size_t n = BinaryProtocol::base64Decode(tokenStart, tokenLen, m_pixelData, sizeof(m_pixelData));
+            if (n == 0 || n % 3 != 0) {
+                m_eventQueue.queueError("bad_argument", cmd.hasId ? cmd.id : NO_COMMAND_ID);
+                return false;
+            }
+            cmd.pixels = m_pixelData;
+            cmd.pixelCount = n / 3;
+        } else if (cmd.action == CommandAction::FRAME && cmd.pixels) {
+            // Nothing may follow the pixel data (a number would move the offset)
+            m_eventQueue.queueError("bad_format", cmd.hasId ? cmd.id : NO_COMMAND_ID);
+            return false;
+        } else if (parseArgument(cmd.action, tokenStart, tokenLen, cmd.arg)) {
+            cmd.hasArg = true;
         } else if (tokenLen > 1) {
             // Multi-character token that's not a command ID - error
             m_eventQueue.queueError("bad_format", cmd.hasId ? cmd.id : NO_COMMAND_ID);
@@ -311,6 +386,242 @@ bool CommandController::parseLine(const char* line, ParsedCommand& cmd) {
         return false;
     }
     
+    // Validate argument presence and value
+    if (actionRequiresArgument(cmd.action)) {
+        if (!cmd.hasArg) {
+            m_eventQueue.queueError("bad_format", cmd.hasId ? cmd.id : NO_COMMAND_ID);
+            return false;
+        }
+        if (!argumentIsValid(cmd.action, cmd.arg)) {
+            m_eventQueue.queueError("bad_argument", cmd.hasId ? cmd.id : NO_COMMAND_ID);
+            return false;
+        }
+    }
+    
+    cmd.valid = true;
+    return true;
+}
+
+bool CommandController::extractFrame() {
+    m_lineIndex = 0;
+    m_lineOverflow = false;
+    
+    if (!scanForDelimiter()) {
+        if (rxPending() >= MAX_LINE_LEN) {
+            // No frame is this long - drop and resync on the next delimiter
+            m_lineOverflow = true;
+            discardRx(MAX_LINE_LEN);
+            return true;
+        }
+        
+        return false;  // No complete frame yet
+    }
+    
+    // Copy encoded bytes up to the delimiter
+    while (m_rxTail != m_rxScan) {
+        if (m_lineIndex < MAX_LINE_LEN) {
+            m_lineBuffer[m_lineIndex++] = m_rxBuffer[m_rxTail];
+        } else {
+            m_lineOverflow = true;
+        }
+        m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
+    }
+    
+    // Skip the delimiter
+    m_rxTail = (m_rxTail + 1) % sizeof(m_rxBuffer);
+    m_rxScan = m_rxTail;
+    
+    return true;
+}
+
+bool CommandController::scanForDelimiter() {
+    // Resume where the last call stopped - bytes before m_rxScan are known
+    // not to contain a delimiter, so a partial line is never rescanned
+    while (m_rxScan != m_rxHead) {
+        if (isDelimiter(m_rxBuffer[m_rxScan])) {
+            return true;
+        }
+        m_rxScan = (m_rxScan + 1) % sizeof(m_rxBuffer);
+    }
+    
+    return false;
+}
+
+uint16_t CommandController::rxPending() const {
+    return rxDistance(m_rxTail, m_rxHead);
+}
+
+uint16_t CommandController::rxDistance(uint16_t from, uint16_t to) const {
+    return (to + sizeof(m_rxBuffer) - from) % sizeof(m_rxBuffer);
+}
+
+bool CommandController::isDelimiter(char c) const {
+    if (m_binaryMode) {
+        return (uint8_t)c == BINARY_FRAME_DELIMITER;
+    }
+    return c == '\n' || c == '\r';
+}
+
+void CommandController::discardRx(uint16_t count) {
+    m_rxTail = (m_rxTail + count) % sizeof(m_rxBuffer);
+    
+    // The scan position may now be behind the tail
+    if (rxDistance(m_rxTail, m_rxScan) > rxPending()) {
+        m_rxScan = m_rxTail;
+    }
+}
+
+uint16_t CommandController::dropPartialMessage() {
+    uint16_t dropped = 0;
+    
+    // Walk the head back to just after the last complete message
+    while (m_rxHead != m_rxTail) {
+        uint16_t prev = (m_rxHead + sizeof(m_rxBuffer) - 1) % sizeof(m_rxBuffer);
+        if (isDelimiter(m_rxBuffer[prev])) {
+            break;
+        }
+        m_rxHead = prev;
+        dropped++;
+    }
+    
+    // The scan position may now be past the head
+    if (rxDistance(m_rxTail, m_rxScan) > rxPending()) {
+        m_rxScan = m_rxHead;
+    }
+    
+    return dropped;
+}
+
+void CommandController::resetRx() {
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_rxScan = 0;
+    m_rxDiscarding = false;
+}
+
+void CommandController::processFrame() {
+    // Empty frames (repeated delimiters) may be sent to resync
+    if (m_lineIndex == 0 && !m_lineOverflow) {
+        return;
+    }
+    
+    uint8_t frame[MAX_LINE_LEN];
+    size_t len = 0;
+    if (!m_lineOverflow) {
+        len = BinaryProtocol::openFrame((const uint8_t*)m_lineBuffer, m_lineIndex, frame);
+    }
+    
+    if (len == 0) {
+        m_eventQueue.queueError("bad_frame", NO_COMMAND_ID);
+        return;
+    }
+    
+    ParsedCommand cmd;
+    if (!parseFrame(frame, len, cmd)) {
+        return;  // Error already queued by parseFrame
+    }
+    
+    // A frame that parsed proves the link works at the current rate
+    m_linkConfirmed = true;
+    executeCommand(cmd);
+}
+
+bool CommandController::parseFrame(const uint8_t* frame, size_t len, ParsedCommand& cmd) {
+    cmd.action = CommandAction::INVALID;
+    cmd.hasPosition = false;
+    cmd.position = 0;
+    cmd.positionIndex = 255;
+    cmd.positionMask = 0;
+    cmd.hasId = false;
+    cmd.id = NO_COMMAND_ID;
+    cmd.hasArg = false;
+    cmd.arg = 0;
+    cmd.pixels = nullptr;
+    cmd.pixelCount = 0;
+    cmd.valid = false;
+    
+    // [opcode][position][id varint if flagged][arg varint if present][FRAME pixels]
+    uint8_t opcode = frame[0] & BINARY_OPCODE_MASK;
+    size_t pos = 2;
+    
+    if (frame[0] & BINARY_FLAG_HAS_ID) {
+        size_t n = BinaryProtocol::getVarint(frame + pos, len - pos, cmd.id);
+        if (n == 0) {
+            m_eventQueue.queueError("bad_frame", NO_COMMAND_ID);
+            return false;
+        }
+        cmd.hasId = true;
+        pos += n;
+    }
+    
+    uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
+    
+    if (pos < len) {
+        size_t n = BinaryProtocol::getVarint(frame + pos, len - pos, cmd.arg);
+        if (n == 0) {
+            m_eventQueue.queueError("bad_frame", id);
+            return false;
+        }
+        cmd.hasArg = true;
+        pos += n;
+    }
+    
+    // Only FRAME carries bytes after the argument: raw RGB pixels
+    if (opcode == static_cast<uint8_t>(CommandAction::FRAME) && pos < len) {
+        if ((len - pos) % 3 != 0 || (len - pos) / 3 > FRAME_MAX_PIXELS) {
+            m_eventQueue.queueError("bad_argument", id);
+            return false;
+        }
+        cmd.pixels = frame + pos;
+        cmd.pixelCount = (len - pos) / 3;
+    } else if (pos != len) {
+        m_eventQueue.queueError("bad_frame", id);
+        return false;
+    }
+    
+    if (opcode == 0 || opcode >= COMMAND_ACTION_COUNT) {
+        m_eventQueue.queueError("unknown_action", id);
+        return false;
+    }
+    cmd.action = static_cast<CommandAction>(opcode);
+    
+    if (frame[1] != 0) {
+        uint8_t idx = charToIndex((char)frame[1]);
+        if (idx == 255) {
+            m_eventQueue.queueError("unknown_position", id);
+            return false;
+        }
+        cmd.hasPosition = true;
+        cmd.position = (frame[1] >= 'a' && frame[1] <= 'z') ? (frame[1] - 32) : frame[1];
+        cmd.positionIndex = idx;
+        cmd.positionMask = 1UL << idx;
+    } else if (actionAcceptsPositionList(cmd.action) && cmd.hasArg) {
+        // Position list sent as a varint mask argument
+        if (cmd.arg == 0 || (cmd.arg >> NUM_POSITIONS) != 0) {
+            m_eventQueue.queueError("unknown_position", id);
+            return false;
+        }
+        cmd.hasPosition = true;
+        cmd.positionMask = cmd.arg;
+        cmd.hasArg = false;
+    }
+    
+    if (actionRequiresPosition(cmd.action) && !cmd.hasPosition) {
+        m_eventQueue.queueError("bad_format", id);
+        return false;
+    }
+    
+    if (actionRequiresArgument(cmd.action)) {
+        if (!cmd.hasArg) {
+            m_eventQueue.queueError("bad_format", id);
+            return false;
+        }
+        if (!argumentIsValid(cmd.action, cmd.arg)) {
+            m_eventQueue.queueError("bad_argument", id);
+            return false;
+        }
+    }
+    
     cmd.valid = true;
     return true;
 }
@@ -355,6 +666,39 @@ CommandAction CommandController::parseAction(const char* str, size_t len) {
     if (len == 4 && strcasecmpN(str, "PING", 4)) {
         return CommandAction::PING;
     }
+    if (len == 4 && strcasecmpN(str, "MODE", 4)) {
+        return CommandAction::MODE;
+    }
+    if (len == 4 && strcasecmpN(str, "BAUD", 4)) {
+        return CommandAction::BAUD;
+    }
+    if (len == 5 && strcasecmpN(str, "STATS", 5)) {
+        return CommandAction::STATS;
+    }
+    if (len == 5 && strcasecmpN(str, "BATCH", 5)) {
+        return CommandAction::BATCH;
+    }
+    if (len == 3 && strcasecmpN(str, "END", 3)) {
+        return CommandAction::END;
+    }
+    if (len == 5 && strcasecmpN(str, "FRAME", 5)) {
+        return CommandAction::FRAME;
+    }
+    if (len == 4 && strcasecmpN(str, "PLAY", 4)) {
+        return CommandAction::PLAY;
+    }
+    if (len == 7 && strcasecmpN(str, "LATENCY", 7)) {
+        return CommandAction::LATENCY;
+    }
+    if (len == 11 && strcasecmpN(str, "SENSITIVITY", 11)) {
+        return CommandAction::SENSITIVITY;
+    }
+    if (len == 9 && strcasecmpN(str, "THRESHOLD", 9)) {
+        return CommandAction::THRESHOLD;
+    }
+    if (len == 3 && strcasecmpN(str, "MEM", 3)) {
+        return CommandAction::MEM;
+    }
     
     return CommandAction::INVALID;
 }
@@ -374,6 +718,17 @@ const char* CommandController::actionToString(CommandAction action) {
         case CommandAction::SEQUENCE_COMPLETED: return "SEQUENCE_COMPLETED";
         case CommandAction::INFO:               return "INFO";
         case CommandAction::PING:               return "PING";
+        case CommandAction::MODE:               return "MODE";
+        case CommandAction::BAUD:               return "BAUD";
+        case CommandAction::STATS:              return "STATS";
+        case CommandAction::BATCH:              return "BATCH";
+        case CommandAction::END:                return "END";
+        case CommandAction::FRAME:              return "FRAME";
+        case CommandAction::PLAY:               return "PLAY";
+        case CommandAction::LATENCY:            return "LATENCY";
+        case CommandAction::SENSITIVITY:        return "SENSITIVITY";
+        case CommandAction::THRESHOLD:          return "THRESHOLD";
+        case CommandAction::MEM:                return "MEM";
         default:                                return "UNKNOWN";
     }
 }
@@ -388,18 +743,124 @@ bool CommandController::actionRequiresPosition(CommandAction action) {
         case CommandAction::EXPECT_DOWN:
         case CommandAction::EXPECT_UP:
         case CommandAction::RECALIBRATE:
+        case CommandAction::SENSITIVITY:
+        case CommandAction::THRESHOLD:
             return true;
         default:
             return false;
     }
 }
 
+bool CommandController::actionRequiresArgument(CommandAction action) {
+    return action == CommandAction::MODE || action == CommandAction::BAUD ||
+           action == CommandAction::FRAME || action == CommandAction::PLAY ||
+           action == CommandAction::LATENCY || action == CommandAction::SENSITIVITY ||
+           action == CommandAction::THRESHOLD;
+}
+
+bool CommandController::actionAcceptsPositionList(CommandAction action) {
+    switch (action) {
+        case CommandAction::SHOW:
+        case CommandAction::HIDE:
+        case CommandAction::BLINK:
+        case CommandAction::STOP_BLINK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool CommandController::parsePositionList(const char* str, size_t len, uint32_t& mask) {
+    mask = 0;
+    
+    // Letters separated by single commas: A,C,F
+    for (size_t i = 0; i < len; i += 2) {
+        uint8_t idx = charToIndex(str[i]);
+        if (idx == 255 || (i + 1 < len && str[i + 1] != ',')) {
+            return false;
+        }
+        mask |= 1UL << idx;
+    }
+    
+    return (len % 2) == 1;  // No trailing comma
+}
+
+bool CommandController::parseArgument(CommandAction action, const char* str, size_t len, uint32_t& arg) {
+    if (action == CommandAction::MODE) {
+        if (len == 6 && strcasecmpN(str, "BINARY", 6)) {
+            arg = 1;
+            return true;
+        }
+        if (len == 5 && strcasecmpN(str, "ASCII", 5)) {
+            arg = 0;
+            return true;
+        }
+        return false;
+    }
+    
+    if (action == CommandAction::LATENCY) {
+        if (len == 2 && strcasecmpN(str, "ON", 2)) {
+            arg = 1;
+            return true;
+        }
+        if (len == 3 && strcasecmpN(str, "OFF", 3)) {
+            arg = 0;
+            return true;
+        }
+        return false;
+    }
+    
+    if (action == CommandAction::BAUD || action == CommandAction::FRAME ||
+        action == CommandAction::PLAY || action == CommandAction::SENSITIVITY ||
+        action == CommandAction::THRESHOLD) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (str[i] < '0' || str[i] > '9' || value > 100000000UL) {
+                return false;
+            }
+            value = value * 10 + (str[i] - '0');
+        }
+        arg = value;
+        return true;
+    }
+    
+    return false;
+}
+
+bool CommandController::argumentIsValid(CommandAction action, uint32_t arg) {
+    switch (action) {
+        case CommandAction::MODE:
+        case CommandAction::LATENCY:
+            return arg <= 1;
+        case CommandAction::BAUD:
+            for (uint8_t i = 0; i < SERIAL_BAUD_RATE_COUNT; i++) {
+                if (SERIAL_BAUD_RATES[i] == arg) {
+                    return true;
+                }
+            }
+            return false;
+        case CommandAction::FRAME:
+            return arg < NUM_LEDS_TOTAL;
+        case CommandAction::PLAY:
+            return arg < EFFECT_COUNT;
+        case CommandAction::SENSITIVITY:
+            return arg <= MAX_SENSITIVITY;
+        case CommandAction::THRESHOLD:
+            return arg <= MAX_TOUCH_THRESHOLD;
+        default:
+            return true;
+    }
+}
+
 bool CommandController::actionIsLongRunning(CommandAction action) {
     switch (action) {
         case CommandAction::SUCCESS:
         case CommandAction::SCAN:
+        case CommandAction::RECALIBRATE:
         case CommandAction::RECALIBRATE_ALL:
         case CommandAction::SEQUENCE_COMPLETED:
+        case CommandAction::BAUD:
+        case CommandAction::PLAY:
             return true;
         default:
             return false;
@@ -412,6 +873,7 @@ bool CommandController::actionIsLongRunning(CommandAction action) {
 
 void CommandController::executeCommand(const ParsedCommand& cmd) {
     uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
+    uint32_t rxUs = micros();
     
     if (actionIsLongRunning(cmd.action)) {
         // Queue for background execution
@@ -423,57 +885,76 @@ void CommandController::executeCommand(const ParsedCommand& cmd) {
         // Execute immediately
         executeInstant(cmd);
     }
+    
+    if (m_eventQueue.isLatencyMode() && cmd.hasPosition) {
+        echoLatency(cmd, rxUs);
+    }
 }
 
 void CommandController::executeInstant(const ParsedCommand& cmd) {
     uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
-    const char* action = actionToString(cmd.action);
     bool success = false;
     
     switch (cmd.action) {
         case CommandAction::SHOW:
-            success = m_ledController.show(cmd.positionIndex);
-            if (success) {
-                m_eventQueue.queueAck(action, cmd.position, id);
-            } else {
+        case CommandAction::HIDE:
+        case CommandAction::BLINK:
+        case CommandAction::STOP_BLINK:
+            success = applyLedCommand(cmd);
+            if (!success) {
                 m_eventQueue.queueError("command_failed", id);
+            } else if (m_batchActive) {
+                // Acknowledged once by END
+            } else if (cmd.position != 0) {
+                m_eventQueue.queueAck(cmd.action, cmd.position, id);
+            } else {
+                m_eventQueue.queueAckPositions(cmd.action, cmd.positionMask, id);
             }
             break;
             
-        case CommandAction::HIDE:
-            success = m_ledController.hide(cmd.positionIndex);
-            if (success) {
-                m_eventQueue.queueAck(action, cmd.position, id);
-            } else {
-                m_eventQueue.queueError("command_failed", id);
+        case CommandAction::BATCH:
+            if (m_batchActive) {
+                m_eventQueue.queueError("bad_batch", id);
+                break;
             }
+            // Changes until END are pushed together in one LED frame
+            m_batchActive = true;
+            m_batchId = id;
+            m_batchStart = millis();
+            m_ledController.holdFrames(true);
             break;
             
-        case CommandAction::BLINK:
-            success = m_ledController.blink(cmd.positionIndex);
-            if (success) {
-                m_eventQueue.queueAck(action, cmd.position, id);
-            } else {
-                m_eventQueue.queueError("command_failed", id);
+        case CommandAction::END:
+            if (!m_batchActive) {
+                m_eventQueue.queueError("bad_batch", id);
+                break;
             }
+            endBatch();
+            m_eventQueue.queueAck(CommandAction::BATCH, 0, m_batchId);
             break;
             
-        case CommandAction::STOP_BLINK:
-            success = m_ledController.stopBlink(cmd.positionIndex);
-            if (success) {
-                m_eventQueue.queueAck(action, cmd.position, id);
+        case CommandAction::FRAME:
+            // Always ACKed, also inside a BATCH: the ACK is the Pi's send credit.
+            // No pixels clears the stream layer from the offset on.
+            if (cmd.pixels ? m_ledController.writePixels(cmd.arg, cmd.pixels, cmd.pixelCount)
+                           : m_ledController.clearPixels(cmd.arg)) {
+                m_eventQueue.queueAck(cmd.action, 0, id);
             } else {
-                m_eventQueue.queueError("command_failed", id);
+                m_eventQueue.queueError("bad_argument", id);
             }
             break;
             
-        case CommandAction::RECALIBRATE:
+        case CommandAction::SENSITIVITY:
+        case CommandAction::THRESHOLD:
             if (m_touchController) {
-                success = m_touchController->recalibrate(cmd.positionIndex);
+                // Applied now and stored for the next boot
+                if (cmd.action == CommandAction::SENSITIVITY) {
+                    success = m_touchController->setSensitivity(cmd.positionIndex, (uint8_t)cmd.arg);
+                } else {
+                    success = m_touchController->setThreshold(cmd.positionIndex, (uint8_t)cmd.arg);
+                }
                 if (success) {
-                    m_eventQueue.queueAck(action, cmd.position, id);
-                    // Also emit RECALIBRATED event per protocol
-                    m_eventQueue.queueRecalibrated(cmd.position, id);
+                    m_eventQueue.queueAck(cmd.action, cmd.position, id);
                 } else {
                     m_eventQueue.queueError("command_failed", id);
                 }
@@ -485,7 +966,7 @@ void CommandController::executeInstant(const ParsedCommand& cmd) {
         case CommandAction::EXPECT_DOWN:
             if (m_touchController) {
                 m_touchController->setExpectDown(cmd.positionIndex, id);
-                m_eventQueue.queueAck(action, cmd.position, id);
+                m_eventQueue.queueAck(cmd.action, cmd.position, id);
                 // TOUCHED_DOWN will be emitted later when touch detected
             } else {
                 m_eventQueue.queueError("no_touch_controller", id);
@@ -495,19 +976,55 @@ void CommandController::executeInstant(const ParsedCommand& cmd) {
         case CommandAction::EXPECT_UP:
             if (m_touchController) {
                 m_touchController->setExpectUp(cmd.positionIndex, id);
-                m_eventQueue.queueAck(action, cmd.position, id);
+                m_eventQueue.queueAck(cmd.action, cmd.position, id);
                 // TOUCHED_UP will be emitted later when release detected
             } else {
                 m_eventQueue.queueError("no_touch_controller", id);
             }
             break;
             
-        case CommandAction::INFO:
-            m_eventQueue.queueInfo(id);
+        case CommandAction::INFO: {
+            // Append I2C bus speed and error counters
+            char details[52] = "";
+            if (m_touchController) {
+                m_touchController->buildBusInfo(details, sizeof(details));
+            }
+            m_eventQueue.queueInfo(id, details);
             break;
+        }
             
         case CommandAction::PING:
-            m_eventQueue.queueAck("PING", 0, id);
+            m_eventQueue.queueAck(CommandAction::PING, 0, id);
+            break;
+            
+        case CommandAction::STATS:
+            m_eventQueue.queueStats(id);
+#if ENABLE_PROFILER
+            // One PROFILE line per stage, leaving room for touch events and
+            // the next command. Stages not sent keep their samples for the
+            // next STATS.
+            for (uint8_t stage = 0; stage < PROFILE_STAGE_COUNT &&
+                 m_eventQueue.freeSlots() > EVENT_SLOTS_PER_COMMAND; stage++) {
+                m_eventQueue.queueProfile(stage, id);
+            }
+#endif
+            break;
+            
+        case CommandAction::MEM:
+            m_eventQueue.queueMem(id);
+            break;
+            
+        case CommandAction::LATENCY:
+            m_eventQueue.setLatencyMode(cmd.arg != 0);
+            m_eventQueue.queueAck(cmd.action, 0, id);
+            break;
+            
+        case CommandAction::MODE:
+            // Incoming framing switches now; replies switch after the ACK
+            // (sent in the old framing). Nothing changes if it can't be queued.
+            if (m_eventQueue.queueMode(cmd.arg != 0, id)) {
+                m_binaryMode = cmd.arg != 0;
+            }
             break;
             
         default:
@@ -517,53 +1034,163 @@ void CommandController::executeInstant(const ParsedCommand& cmd) {
 }
 
 bool CommandController::queueCommand(const ParsedCommand& cmd) {
-    // Find empty slot
-    for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
-        if (!m_commandQueue[i].active) {
-            m_commandQueue[i].command = cmd;
-            m_commandQueue[i].active = true;
-            m_commandQueue[i].startTime = millis();
-            m_commandQueue[i].state = 0;
-            m_commandQueue[i].scanAddress = 0;  // Used as sensor index for RECALIBRATE_ALL
-            
-            // Send ACK immediately
-            uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
-            const char* action = actionToString(cmd.action);
-            
-            if (cmd.action == CommandAction::SUCCESS) {
-                // Start the animation
-                m_ledController.success(cmd.positionIndex);
-                m_eventQueue.queueAck(action, cmd.position, id);
-            } else if (cmd.action == CommandAction::SCAN) {
-                if (m_touchController) {
-                    m_eventQueue.queueAck(action, 0, id);
-                } else {
-                    m_eventQueue.queueError("no_touch_controller", id);
-                    m_commandQueue[i].active = false;
-                    return false;
-                }
-            } else if (cmd.action == CommandAction::RECALIBRATE_ALL) {
-                if (m_touchController) {
-                    m_eventQueue.queueAck(action, 0, id);
-                } else {
-                    m_eventQueue.queueError("no_touch_controller", id);
-                    m_commandQueue[i].active = false;
-                    return false;
-                }
-            } else if (cmd.action == CommandAction::SEQUENCE_COMPLETED) {
-                // Start the celebration animation
-                m_ledController.startSequenceCompletedAnimation();
-                m_eventQueue.queueAck(action, 0, id);
-            }
-            
-            return true;
+    // One rate change at a time
+    if (cmd.action == CommandAction::BAUD && isQueued(CommandAction::BAUD)) {
+        return false;
+    }
+    
+    if (m_freeHead == NO_COMMAND_SLOT) {
+        return false;  // Queue full
+    }
+    
+    // Take a slot off the free list
+    uint8_t slot = m_freeHead;
+    QueuedCommand& qc = m_commandQueue[slot];
+    m_freeHead = qc.next;
+    
+    uint32_t now = millis();
+#if COMPACT_COMMAND_QUEUE
+    qc.command.action = cmd.action;
+    qc.command.position = cmd.position;
+    qc.command.positionIndex = cmd.positionIndex;
+    qc.command.hasId = cmd.hasId;
+    qc.command.id = cmd.id;
+    qc.command.arg = cmd.arg;
+#else
+    qc.command = cmd;
+#endif
+    qc.active = true;
+    qc.lane = laneFor(cmd.action);
+    qc.startTime = now;
+    qc.dueTime = now;
+    qc.state = 0;
+    qc.scanAddress = 0;
+    
+    // Send ACK immediately
+    uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
+    
+    if (cmd.action == CommandAction::SUCCESS) {
+        // Start the animation; nothing to check before it can have finished
+        m_ledController.success(cmd.positionIndex);
+        m_eventQueue.queueAck(cmd.action, cmd.position, id);
+        qc.dueTime = now + SUCCESS_ANIMATION_MS;
+    } else if (cmd.action == CommandAction::SCAN) {
+        if (!m_touchController) {
+            m_eventQueue.queueError("no_touch_controller", id);
+            qc.active = false;
+            qc.next = m_freeHead;
+            m_freeHead = slot;
+            return false;
+        }
+        m_eventQueue.queueAck(cmd.action, 0, id);
+    } else if (cmd.action == CommandAction::RECALIBRATE || cmd.action == CommandAction::RECALIBRATE_ALL) {
+        // Trigger writes go out on the next touch tick; finished once the
+        // chips clear their calibration-active bits
+        bool all = cmd.action == CommandAction::RECALIBRATE_ALL;
+        uint32_t mask = all ? ALL_POSITIONS_MASK : 1UL << cmd.positionIndex;
+        const char* error = nullptr;
+        if (!m_touchController) {
+            error = "no_touch_controller";
+        } else if (!m_touchController->startRecalibration(mask)) {
+            error = "command_failed";
+        }
+        if (error) {
+            m_eventQueue.queueError(error, id);
+            qc.active = false;
+            qc.next = m_freeHead;
+            m_freeHead = slot;
+            return true;  // Already answered
+        }
+        m_eventQueue.queueAck(cmd.action, all ? 0 : cmd.position, id);
+        qc.dueTime = now + CALIBRATION_POLL_MS;
+    } else if (cmd.action == CommandAction::SEQUENCE_COMPLETED) {
+        // Start the celebration animation
+        m_ledController.startSequenceCompletedAnimation();
+        m_eventQueue.queueAck(cmd.action, 0, id);
+        qc.dueTime = now + SEQUENCE_ANIMATION_MS;
+    } else if (cmd.action == CommandAction::PLAY) {
+        // Whole-strip effects take no position, position effects need one.
+        // SEQUENCE_COMPLETED keeps the overlay until it has ended the round.
+        bool overlayBusy = Effects::get(cmd.arg)->target == EffectTarget::ALL && cmd.positionIndex == 255 &&
+                           !m_ledController.isSequenceCompletedAnimationComplete();
+        if (overlayBusy || !m_ledController.playEffect(cmd.arg, cmd.positionIndex)) {
+            m_eventQueue.queueError(overlayBusy ? "busy" : "bad_argument", id);
+            qc.active = false;
+            qc.next = m_freeHead;
+            m_freeHead = slot;
+            return true;  // Already answered
+        }
+        m_eventQueue.queueAck(cmd.action, cmd.position, id);
+        qc.dueTime = now + ledFramesToMs(Effects::length(*Effects::get(cmd.arg)));
+    } else if (cmd.action == CommandAction::BAUD) {
+        m_eventQueue.queueAck(cmd.action, 0, id);
+    }
+    
+    schedule(slot);
+    return true;
+}
+
+void CommandController::tickLane(CommandLane lane, uint32_t now, uint8_t reserveSlots) {
+    uint8_t& head = m_laneHead[static_cast<uint8_t>(lane)];
+    
+    // The lane is sorted by due time - stop at the first command not yet due
+    while (head != NO_COMMAND_SLOT &&
+           (int32_t)(now - m_commandQueue[head].dueTime) >= 0 &&
+           m_eventQueue.freeSlots() > reserveSlots) {
+        uint8_t slot = head;
+        QueuedCommand& qc = m_commandQueue[slot];
+        head = qc.next;
+        
+        // Rescheduled at least 1 ms ahead, so this loop always ends
+        qc.dueTime = now + 1;
+        tickCommand(qc, now);
+        
+        if (qc.active) {
+            schedule(slot);
+        } else {
+            qc.next = m_freeHead;
+            m_freeHead = slot;
         }
     }
+}
+
+void CommandController::schedule(uint8_t slot) {
+    QueuedCommand& qc = m_commandQueue[slot];
+    uint8_t* link = &m_laneHead[static_cast<uint8_t>(qc.lane)];
+    
+    // After every command due no later (FIFO among equal due times)
+    while (*link != NO_COMMAND_SLOT &&
+           (int32_t)(m_commandQueue[*link].dueTime - qc.dueTime) <= 0) {
+        link = &m_commandQueue[*link].next;
+    }
     
-    return false;  // Queue full
+    qc.next = *link;
+    *link = slot;
+}
+
+bool CommandController::isQueued(CommandAction action) const {
+    for (uint8_t lane = 0; lane < COMMAND_LANE_COUNT; lane++) {
+        for (uint8_t slot = m_laneHead[lane]; slot != NO_COMMAND_SLOT; slot = m_commandQueue[slot].next) {
+            if (m_commandQueue[slot].command.action == action) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+CommandLane CommandController::laneFor(CommandAction action) {
+    switch (action) {
+        case CommandAction::SUCCESS:
+        case CommandAction::SEQUENCE_COMPLETED:
+        case CommandAction::PLAY:
+            return CommandLane::ANIMATION;
+        default:
+            return CommandLane::CONTROL;
+    }
 }
 
-void CommandController::tickCommand(QueuedCommand& qc) {
+void CommandController::tickCommand(QueuedCommand& qc, uint32_t now) {
     if (!qc.active) {
         return;
     }
@@ -574,7 +1201,7 @@ void CommandController::tickCommand(QueuedCommand& qc) {
         case CommandAction::SUCCESS: {
             // Check if animation is complete
             if (m_ledController.isAnimationComplete(qc.command.positionIndex)) {
-                m_eventQueue.queueDone("SUCCESS", qc.command.position, id);
+                m_eventQueue.queueDone(CommandAction::SUCCESS, qc.command.position, id, m_animationSource);
                 qc.active = false;
             }
             break;
@@ -583,42 +1210,80 @@ void CommandController::tickCommand(QueuedCommand& qc) {
         case CommandAction::SCAN: {
             // Build list of active sensors and emit SCANNED[A,B,C,...]
             if (m_touchController) {
-                char sensorList[52];
-                m_touchController->buildActiveSensorList(sensorList, sizeof(sensorList));
-                m_eventQueue.queueScanned(sensorList, id);
+                m_eventQueue.queueScanned(m_touchController->getActiveSensorMask(), id);
             }
             qc.active = false;
             break;
         }
         
+        case CommandAction::RECALIBRATE:
         case CommandAction::RECALIBRATE_ALL: {
-            // Non-blocking recalibration - recalibrate a few sensors per tick
-            const uint8_t SENSORS_PER_TICK = 5;
+            if (!m_touchController) {
+                qc.active = false;
+                break;
+            }
             
-            if (m_touchController) {
-                for (uint8_t i = 0; i < SENSORS_PER_TICK && qc.scanAddress < NUM_TOUCH_SENSORS; i++) {
-                    m_touchController->recalibrate(qc.scanAddress);
-                    qc.scanAddress++;
-                }
-                
-                // Check if complete
-                if (qc.scanAddress >= NUM_TOUCH_SENSORS) {
-                    // Emit RECALIBRATED ALL
-                    m_eventQueue.queueRecalibrated(0, id);  // 0 = ALL
-                    qc.active = false;
-                }
+            bool all = qc.command.action == CommandAction::RECALIBRATE_ALL;
+            uint32_t mask = all ? ALL_POSITIONS_MASK : 1UL << qc.command.positionIndex;
+            
+            // Wait for the chips to confirm (or time out)
+            if (m_touchController->isRecalibrating(mask)) {
+                qc.dueTime = now + CALIBRATION_POLL_MS;
+                break;
+            }
+            
+            if (m_touchController->getRecalibrationFailures(mask)) {
+                m_eventQueue.queueError("calibration_failed", id);
             } else {
-                qc.active = false;
+                m_eventQueue.queueRecalibrated(all ? 0 : qc.command.position, id);  // 0 = ALL
             }
+            qc.active = false;
             break;
         }
         
         case CommandAction::SEQUENCE_COMPLETED: {
             // Check if animation is complete
             if (m_ledController.isSequenceCompletedAnimationComplete()) {
-                m_eventQueue.queueDone("SEQUENCE_COMPLETED", 0, id);
+                m_eventQueue.queueDone(CommandAction::SEQUENCE_COMPLETED, 0, id, m_animationSource);
+                qc.active = false;
+            }
+            break;
+        }
+        
+        case CommandAction::PLAY: {
+            if (!m_ledController.isEffectPlaying(qc.command.positionIndex)) {
+                m_eventQueue.queueDone(CommandAction::PLAY, qc.command.position, id, m_animationSource);
+                qc.active = false;
+            }
+            break;
+        }
+        
+        case CommandAction::BAUD: {
+#if SERIAL_USB_CDC
+            // USB CDC runs at bus speed - nothing to switch
+            m_eventQueue.queueDone(CommandAction::BAUD, 0, id);
+            qc.active = false;
+#else
+            if (qc.state == 0) {
+                // Switch once the ACK has been handed to the UART
+                if (!m_eventQueue.isIdle()) {
+                    break;
+                }
+                m_fallbackBaudRate = m_baudRate;
+                setBaudRate(qc.command.arg);
+                m_linkConfirmed = false;
+                qc.startTime = millis();
+                qc.state = 1;
+            } else if (m_linkConfirmed) {
+                m_eventQueue.queueDone(CommandAction::BAUD, 0, id);
+                qc.active = false;
+            } else if (now - qc.startTime >= BAUD_CONFIRM_TIMEOUT_MS) {
+                // Host never followed - go back to the rate it last used
+                setBaudRate(m_fallbackBaudRate);
+                m_eventQueue.queueError("baud_timeout", id);
                 qc.active = false;
             }
+#endif
             break;
         }
         
@@ -629,6 +1294,66 @@ void CommandController::tickCommand(QueuedCommand& qc) {
     }
 }
 
+bool CommandController::applyLedCommand(const ParsedCommand& cmd) {
+    bool success = true;
+    
+    for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
+        if ((cmd.positionMask & (1UL << i)) == 0) {
+            continue;
+        }
+        
+        switch (cmd.action) {
+            case CommandAction::SHOW:       success &= m_ledController.show(i);      break;
+            case CommandAction::HIDE:       success &= m_ledController.hide(i);      break;
+            case CommandAction::BLINK:      success &= m_ledController.blink(i);     break;
+            case CommandAction::STOP_BLINK: success &= m_ledController.stopBlink(i); break;
+            default:                        return false;
+        }
+    }
+    
+    return success;
+}
+
+void CommandController::echoLatency(const ParsedCommand& cmd, uint32_t rxUs) {
+    switch (cmd.action) {
+        case CommandAction::SHOW:
+        case CommandAction::HIDE:
+        case CommandAction::BLINK:
+        case CommandAction::STOP_BLINK:
+        case CommandAction::SUCCESS:
+        case CommandAction::PLAY:
+            break;
+        default:
+            return;
+    }
+    
+    uint32_t id = cmd.hasId ? cmd.id : NO_COMMAND_ID;
+    
+    // After the command's own ACK, as far as the queue has room
+    for (uint8_t i = 0; i < NUM_POSITIONS && !m_eventQueue.isFull(); i++) {
+        if (cmd.positionMask & (1UL << i)) {
+            m_eventQueue.queueLatencyEcho('A' + i, rxUs, id);
+        }
+    }
+}
+
+void CommandController::endBatch() {
+    m_batchActive = false;
+    m_ledController.holdFrames(false);
+}
+
+void CommandController::setBaudRate(uint32_t baud) {
+    PI_SERIAL.flush();  // Finish sending at the old rate
+    PI_SERIAL.end();
+    PI_SERIAL.begin(baud);
+    m_baudRate = baud;
+    
+    // Bytes received during the switch are garbage
+    resetRx();
+    
+    m_eventQueue.setLinkRate(baud);
+}
+
 // ============================================================================
 // Utility Methods
 // ======================================================
\ No newline at end of file
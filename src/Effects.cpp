@@ -0,0 +1,174 @@
+/**
+ * @file Effects.cpp
+ * @brief Effect tables and keyframe sampling
+ */
+
+#include "Effects.h"
+
+// ============================================================================
+// Curves (built at compile time)
+// ============================================================================
+
+/**
+ * @brief Gamma ~2.2, approximated as 0.8 x^2 + 0.2 x^3
+ */
+static constexpr uint8_t gammaCurve(uint8_t x) {
+    uint32_t x2 = (uint32_t)x * x;
+    return (uint8_t)((4 * x2 * 255 + x2 * x + 5 * 255 * 255 / 2) / (5 * 255 * 255));
+}
+
+/**
+ * @brief Smoothstep: 3t^2 - 2t^3
+ */
+static constexpr uint8_t easeInOutCurve(uint8_t t) {
+    return (uint8_t)((uint32_t)t * t * (3 * 255 - 2 * t) / (255 * 255));
+}
+
+/**
+ * @brief Quadratic ease out: 1 - (1 - t)^2
+ */
+static constexpr uint8_t easeOutCurve(uint8_t t) {
+    return (uint8_t)(255 - (uint32_t)(255 - t) * (255 - t) / 255);
+}
+
+struct CurveTable {
+    uint8_t values[256];
+    
+    constexpr CurveTable(uint8_t (*curve)(uint8_t)) : values{} {
+        for (uint16_t i = 0; i < 256; i++) {
+            values[i] = curve((uint8_t)i);
+        }
+    }
+};
+
+static constexpr CurveTable GAMMA_TABLE(gammaCurve);
+static constexpr CurveTable EASE_IN_OUT_TABLE(easeInOutCurve);
+static constexpr CurveTable EASE_OUT_TABLE(easeOutCurve);
+
+static_assert(GAMMA_TABLE.values[0] == 0 && GAMMA_TABLE.values[255] == 255, "Gamma table must span 0-255");
+static_assert(EASE_IN_OUT_TABLE.values[255] == 255 && EASE_OUT_TABLE.values[255] == 255, "Easing must end at 255");
+
+// ============================================================================
+// Effect Tables
+// ============================================================================
+
+// One LED further every SUCCESS_STEP_FRAMES, then held
+static constexpr Keyframe SUCCESS_KEYS[] = {
+    { 0,                                                 255, 0,                        Easing::LINEAR },
+    { SUCCESS_EXPANSION_RADIUS * SUCCESS_STEP_FRAMES,    255, SUCCESS_EXPANSION_RADIUS, Easing::LINEAR }
+};
+
+// SEQUENCE_ANIM_STEPS fades between full and dim, ending dark
+static constexpr Keyframe CELEBRATE_KEYS[] = {
+    { 0,                    255, 0, Easing::STEP },
+    { SEQUENCE_STEP_FRAMES, 128, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 255, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 128, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 255, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 128, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 255, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 128, 0, Easing::EASE_IN_OUT },
+    { SEQUENCE_STEP_FRAMES, 0,   0, Easing::EASE_IN_OUT }
+};
+
+static constexpr Keyframe BREATHE_KEYS[] = {
+    { 0,                   0,   0, Easing::STEP },
+    { ledFrames(750),      255, 0, Easing::EASE_IN_OUT },
+    { ledFrames(750),      0,   0, Easing::EASE_IN_OUT },
+    { ledFrames(750),      255, 0, Easing::EASE_IN_OUT },
+    { ledFrames(750),      0,   0, Easing::EASE_IN_OUT }
+};
+
+static constexpr Keyframe FLASH_KEYS[] = {
+    { 0,                   255, 0, Easing::STEP },
+    { ledFrames(100),      0,   0, Easing::STEP },
+    { ledFrames(100),      255, 0, Easing::STEP },
+    { ledFrames(100),      0,   0, Easing::STEP },
+    { ledFrames(100),      255, 0, Easing::STEP },
+    { ledFrames(100),      0,   0, Easing::STEP }
+};
+
+static constexpr Keyframe RIPPLE_KEYS[] = {
+    { 0,                   255, 0, Easing::STEP },
+    { ledFrames(500),      0,   8, Easing::EASE_OUT }
+};
+
+#define EFFECT_KEYS(keys) keys, sizeof(keys) / sizeof(keys[0])
+
+static constexpr Effect EFFECTS[EFFECT_COUNT] = {
+    // EFFECT_SUCCESS
+    { { COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B }, EffectTarget::POSITION, true,  EFFECT_KEYS(SUCCESS_KEYS) },
+    // EFFECT_CELEBRATE
+    { { COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B }, EffectTarget::ALL,      false, EFFECT_KEYS(CELEBRATE_KEYS) },
+    // EFFECT_BREATHE
+    { { COLOR_SHOW_R, COLOR_SHOW_G, COLOR_SHOW_B },          EffectTarget::ALL,      false, EFFECT_KEYS(BREATHE_KEYS) },
+    // EFFECT_FLASH
+    { { COLOR_BLINK_R, COLOR_BLINK_G, COLOR_BLINK_B },       EffectTarget::ALL,      false, EFFECT_KEYS(FLASH_KEYS) },
+    // EFFECT_RIPPLE
+    { { COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B }, EffectTarget::POSITION, false, EFFECT_KEYS(RIPPLE_KEYS) }
+};
+
+#undef EFFECT_KEYS
+
+// SUCCESS and SEQUENCE_COMPLETED DONE checks are scheduled from Config.h
+static_assert(Effects::length(EFFECTS[EFFECT_SUCCESS]) == SUCCESS_EXPANSION_RADIUS * SUCCESS_STEP_FRAMES,
+              "SUCCESS effect length must match SUCCESS_ANIMATION_MS");
+static_assert(Effects::length(EFFECTS[EFFECT_CELEBRATE]) == SEQUENCE_ANIM_STEPS * SEQUENCE_STEP_FRAMES,
+              "Celebration effect length must match SEQUENCE_ANIMATION_MS");
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+const Effect* Effects::get(uint8_t id) {
+    return id < EFFECT_COUNT ? &EFFECTS[id] : nullptr;
+}
+
+EffectSample Effects::sample(const Effect& effect, uint32_t elapsed) {
+    const Keyframe* prev = &effect.keys[0];
+    uint8_t level = prev->level;
+    uint8_t radius = prev->radius;
+    bool done = true;
+    uint32_t start = 0;
+    
+    // Find the segment containing this frame and interpolate along its curve
+    for (uint8_t i = 1; i < effect.keyCount; i++) {
+        const Keyframe& next = effect.keys[i];
+        
+        if (elapsed < start + next.frames) {
+            uint8_t t = ease(next.easing, (uint8_t)((elapsed - start) * 255 / next.frames));
+            level = (uint8_t)(prev->level + ((int16_t)next.level - prev->level) * t / 255);
+            radius = (uint8_t)(prev->radius + ((int16_t)next.radius - prev->radius) * t / 255);
+            done = false;
+            break;
+        }
+        
+        start += next.frames;
+        prev = &next;
+        level = prev->level;
+        radius = prev->radius;
+    }
+    
+    // One scale per channel per frame; pixels just copy the result
+    uint8_t g = gamma(level);
+    EffectSample s;
+    s.color.r = (uint8_t)((effect.color.r * g + 127) / 255);
+    s.color.g = (uint8_t)((effect.color.g * g + 127) / 255);
+    s.color.b = (uint8_t)((effect.color.b * g + 127) / 255);
+    s.radius = radius;
+    s.done = done;
+    return s;
+}
+
+uint8_t Effects::ease(Easing easing, uint8_t t) {
+    switch (easing) {
+        case Easing::STEP:        return t == 255 ? 255 : 0;
+        case Easing::EASE_IN_OUT: return EASE_IN_OUT_TABLE.values[t];
+        case Easing::EASE_OUT:    return EASE_OUT_TABLE.values[t];
+        default:                  return t;
+    }
+}
+
+uint8_t Effects::gamma(uint8_t level) {
+    return GAMMA_TABLE.values[level];
+}
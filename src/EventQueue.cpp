@@ -4,16 +4,94 @@
  */
 
 #include "EventQueue.h"
+#include "BinaryProtocol.h"
+#include "MemoryReport.h"
+#include "Profiler.h"
+#include <stdarg.h>
+
+/**
+ * @brief Append formatted text (no terminator) to a buffer
+ * @param buffer Output buffer
+ * @param len Current length
+ * @param size Usable size of the buffer
+ * @param format printf-style format
+ * @return New length (clamped to size - 1)
+ */
+static size_t appendText(char* buffer, size_t len, size_t size, const char* format, ...) {
+    size_t room = size - len;
+    
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + len, room, format, args);
+    va_end(args);
+    
+    if (written < 0) {
+        return len;
+    }
+    return len + ((size_t)written < room ? (size_t)written : room - 1);
+}
+
+/**
+ * @brief Append a comma-separated position list (A,C,F)
+ * @param buffer Output buffer
+ * @param len Current length
+ * @param size Buffer size
+ * @param mask Positions (bit 0 = A)
+ * @return New length
+ */
+static size_t appendPositionList(char* buffer, size_t len, size_t size, uint32_t mask) {
+    bool first = true;
+    
+    for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
+        if (mask & (1UL << i)) {
+            len = appendText(buffer, len, size, first ? "%c" : ",%c", 'A' + i);
+            first = false;
+        }
+    }
+    
+    return len;
+}
 
 // ============================================================================
 // Constructor
 // ============================================================================
 
 EventQueue::EventQueue()
-    : m_head(0)
+    : m_sequence(0)
+    , m_head(0)
     , m_tail(0)
     , m_count(0)
+    , m_txHead(0)
+    , m_txTail(0)
+    , m_txCount(0)
+    , m_binaryMode(false)
+    , m_linkRate(SERIAL_USB_CDC ? 0 : SERIAL_BAUD_RATE)
+    , m_txPacedUntil(0)
+    , m_latencyMode(false)
+    , m_flushUs(0)
+    , m_txBytes(0)
+    , m_txWindowStart(0)
+    , m_txWindowBytes(0)
+    , m_txRate(0)
+    , m_highWater(0)
+    , m_txHighWater(0)
+    , m_dropped(0)
+    , m_coalesced(0)
+    , m_rxDropped(0)
+    , m_monitor(nullptr)
+    , m_monitorContext(nullptr)
 {
+    m_infoDetails[0] = '\0';
+    
+    for (uint8_t i = 0; i < LATENCY_SLOTS; i++) {
+        m_latency[i].state = LatencyState::FREE;
+    }
+    
+    for (uint8_t i = 0; i < EVENT_SOURCE_COUNT - 1; i++) {
+        m_rings[i].head.store(0, std::memory_order_relaxed);
+        m_rings[i].tail.store(0, std::memory_order_relaxed);
+        m_rings[i].dropped = 0;
+    }
 }
 
 // ============================================================================
@@ -24,27 +102,88 @@ void EventQueue::begin() {
     m_head = 0;
     m_tail = 0;
     m_count = 0;
+    m_txHead = 0;
+    m_txTail = 0;
+    m_txCount = 0;
+    m_binaryMode = false;
+    m_infoDetails[0] = '\0';
+    m_latencyMode = false;
+    
+    for (uint8_t i = 0; i < LATENCY_SLOTS; i++) {
+        m_latency[i].state = LatencyState::FREE;
+    }
     
-    // Clear all queue slots
-    for (uint8_t i = 0; i < EVENT_QUEUE_SIZE; i++) {
-        m_queue[i].valid = false;
+    // Only the consumer side is reset; a producer may already be running
+    for (uint8_t i = 0; i < EVENT_SOURCE_COUNT - 1; i++) {
+        EventRing& ring = m_rings[i];
+        ring.tail.store(ring.head.load(std::memory_order_acquire), std::memory_order_release);
     }
 }
 
-void EventQueue::flush(uint8_t maxEvents) {
-    uint8_t sent = 0;
+void EventQueue::flush() {
+    static_assert(MAX_EVENT_LEN >= BINARY_MAX_ENCODED_LEN, "Scratch must hold a binary frame");
+    
+    // Format queued events only while the port can take them, so records
+    // stay compact (and coalescible) while it is backed up
+    uint8_t scratch[MAX_EVENT_LEN];
+    bool paced;
+    int room = portRoom(paced);
+    
+    EventSource source;
+    const Event* next;
     
-    while (!isEmpty() && sent < maxEvents) {
-        Event& event = m_queue[m_tail];
+    while ((int)m_txCount < room && (next = peekOldest(source)) != nullptr) {
+        const Event& event = *next;
+        m_flushUs = micros();
         
-        if (event.valid) {
-            sendEvent(event);
-            event.valid = false;
+        size_t len = m_binaryMode
+            ? formatBinaryEvent(event, scratch)
+            : formatEvent(event, (char*)scratch);
+        
+        if (len > (size_t)(EVENT_TX_BUFFER_SIZE - m_txCount)) {
+            break;  // Retry once the port has drained some bytes
+        }
+        pushTx(scratch, len);
+        if (m_txCount > m_txHighWater) {
+            m_txHighWater = m_txCount;
         }
         
-        m_tail = (m_tail + 1) % EVENT_QUEUE_SIZE;
-        m_count--;
-        sent++;
+        if (m_monitor && !m_binaryMode && len >= 2) {
+            // Already copied to the TX ring, so the line ending can go
+            scratch[len - 2] = '\0';
+            m_monitor((const char*)scratch, m_monitorContext);
+        }
+        
+        // Switch only after the ACK was formatted in the old framing
+        if (event.type == EventType::MODE) {
+            m_binaryMode = event.binary;
+        }
+        
+        if (event.type >= EventType::TOUCH_DOWN && event.type <= EventType::TOUCHED_UP) {
+            PROFILE_TOUCH_SENT(event.touch.edgeUs);
+        } else if (event.type == EventType::PROFILE) {
+            // Reset only once sent: formatting is retried while the ring is full
+            PROFILE_STAGE_SENT(event.stage);
+        }
+        
+        if (m_latencyMode && (event.type == EventType::TOUCH_DOWN || event.type == EventType::TOUCHED_DOWN)) {
+            recordLatency(event);
+        } else if (event.type == EventType::LATENCY) {
+            // Freed only once sent: formatting is retried while the ring is full
+            m_latency[event.latency.slot].state = LatencyState::FREE;
+        }
+        
+        popOldest(source);
+    }
+    
+    writeTx();
+    
+    // Measured throughput over the last window
+    uint32_t now = millis();
+    if (now - m_txWindowStart >= TX_RATE_WINDOW_MS) {
+        m_txRate = (m_txBytes - m_txWindowBytes) * 1000UL / (now - m_txWindowStart);
+        m_txWindowBytes = m_txBytes;
+        m_txWindowStart = now;
     }
 }
 
@@ -53,219 +192,669 @@ bool EventQueue::isFull() const {
 }
 
 bool EventQueue::isEmpty() const {
-    return m_count == 0;
+    if (m_count != 0) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < EVENT_SOURCE_COUNT - 1; i++) {
+        const EventRing& ring = m_rings[i];
+        if (ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventQueue::isIdle() const {
+    return m_txCount == 0 && isEmpty();
 }
 
 uint8_t EventQueue::count() const {
     return m_count;
 }
 
-bool EventQueue::queueAck(const char* action, char position, uint32_t commandId) {
-    Event event;
-    event.type = EventType::ACK;
-    strncpy(event.action, action, sizeof(event.action) - 1);
-    event.action[sizeof(event.action) - 1] = '\0';
-    event.position = position;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
+uint8_t EventQueue::freeSlots() const {
+    return EVENT_QUEUE_SIZE - m_count;
+}
+
+bool EventQueue::isBinaryMode() const {
+    return m_binaryMode;
+}
+
+void EventQueue::setLinkRate(uint32_t baud) {
+    m_linkRate = baud;
+}
+
+uint32_t EventQueue::getTxRate() const {
+    return m_txRate;
+}
+
+uint32_t EventQueue::getDroppedCount() const {
+    uint32_t dropped = m_dropped;
+    for (uint8_t i = 0; i < EVENT_SOURCE_COUNT - 1; i++) {
+        dropped += m_rings[i].dropped;
+    }
+    return dropped;
+}
+
+void EventQueue::setMonitor(EventMonitor monitor, void* context) {
+    m_monitor = monitor;
+    m_monitorContext = context;
+}
+
+void EventQueue::setLatencyMode(bool enabled) {
+    m_latencyMode = enabled;
     
-    return enqueue(event);
+    for (uint8_t i = 0; i < LATENCY_SLOTS; i++) {
+        if (m_latency[i].state != LatencyState::ECHOED) {
+            m_latency[i].state = LatencyState::FREE;
+        }
+    }
 }
 
-bool EventQueue::queueDone(const char* action, char position, uint32_t commandId) {
-    Event event;
-    event.type = EventType::DONE;
-    strncpy(event.action, action, sizeof(event.action) - 1);
-    event.action[sizeof(event.action) - 1] = '\0';
-    event.position = position;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::isLatencyMode() const {
+    return m_latencyMode;
+}
+
+bool EventQueue::queueAck(CommandAction action, char position, uint32_t commandId) {
+    Event event = makeEvent(EventType::ACK, position, commandId);
+    event.action = action;
     
     return enqueue(event);
 }
 
-bool EventQueue::queueError(const char* reason, uint32_t commandId) {
-    Event event;
-    event.type = EventType::ERR;
-    event.action[0] = '\0';
-    event.position = 0;
-    event.commandId = commandId;
-    strncpy(event.extra, reason, sizeof(event.extra) - 1);
-    event.extra[sizeof(event.extra) - 1] = '\0';
-    event.valid = true;
+bool EventQueue::queueAckPositions(CommandAction action, uint32_t positionMask, uint32_t commandId) {
+    Event event = makeEvent(EventType::ACK, 0, commandId);
+    event.action = action;
+    event.positionMask = positionMask;
     
     return enqueue(event);
 }
 
-bool EventQueue::queueTouchDown(char position) {
-    Event event;
-    event.type = EventType::TOUCH_DOWN;
-    event.action[0] = '\0';
-    event.position = position;
-    event.commandId = NO_COMMAND_ID;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::queueDone(CommandAction action, char position, uint32_t commandId, EventSource source) {
+    Event event = makeEvent(EventType::DONE, position, commandId);
+    event.action = action;
     
-    return enqueue(event);
+    return enqueue(event, source);
 }
 
-bool EventQueue::queueTouchUp(char position) {
-    Event event;
-    event.type = EventType::TOUCH_UP;
-    event.action[0] = '\0';
-    event.position = position;
-    event.commandId = NO_COMMAND_ID;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::queueError(const char* reason, uint32_t commandId) {
+    Event event = makeEvent(EventType::ERR, 0, commandId);
+    event.reason = reason;
     
     return enqueue(event);
 }
 
-bool EventQueue::queueScanResult(uint8_t address) {
-    Event event;
-    event.type = EventType::SCAN_RESULT;
-    event.action[0] = '\0';
-    event.position = 0;
-    event.commandId = NO_COMMAND_ID;
+bool EventQueue::queueRxOverflow(uint16_t bytes) {
+    m_rxDropped += bytes;
     
-    // Format address as hex
-    snprintf(event.extra, sizeof(event.extra), "0x%02X", address);
-    event.valid = true;
+    return queueError("rx_overflow", NO_COMMAND_ID);
+}
+
+bool EventQueue::queueTouchDown(char position, uint32_t edgeUs, EventSource source) {
+    // Rings are never modified by the consumer, so only LOOP events coalesce
+    if (source == EventSource::LOOP && coalesceTouch(EventType::TOUCH_UP, position)) {
+        return true;
+    }
+    return enqueue(makeTouchEvent(EventType::TOUCH_DOWN, position, NO_COMMAND_ID, edgeUs), source);
+}
+
+bool EventQueue::queueTouchUp(char position, uint32_t edgeUs, EventSource source) {
+    if (source == EventSource::LOOP && coalesceTouch(EventType::TOUCH_DOWN, position)) {
+        return true;
+    }
+    return enqueue(makeTouchEvent(EventType::TOUCH_UP, position, NO_COMMAND_ID, edgeUs), source);
+}
+
+bool EventQueue::queueScanResult(uint8_t address) {
+    Event event = makeEvent(EventType::SCAN_RESULT, 0, NO_COMMAND_ID);
+    event.address = address;
     
     return enqueue(event);
 }
 
 bool EventQueue::queueScanDone(uint32_t commandId) {
     // First queue SCAN_DONE (without ID, it's a status line)
-    Event event1;
-    event1.type = EventType::SCAN_DONE;
-    event1.action[0] = '\0';
-    event1.position = 0;
-    event1.commandId = NO_COMMAND_ID;
-    event1.extra[0] = '\0';
-    event1.valid = true;
-    
-    if (!enqueue(event1)) {
+    if (!enqueue(makeEvent(EventType::SCAN_DONE, 0, NO_COMMAND_ID))) {
         return false;
     }
     
     // Then queue DONE SCAN with ID
-    return queueDone("SCAN", 0, commandId);
+    return queueDone(CommandAction::SCAN, 0, commandId);
 }
 
-bool EventQueue::queueScanned(const char* sensorList, uint32_t commandId) {
-    Event event;
-    event.type = EventType::SCANNED;
-    event.action[0] = '\0';
-    event.position = 0;
-    event.commandId = commandId;
-    strncpy(event.extra, sensorList, sizeof(event.extra) - 1);
-    event.extra[sizeof(event.extra) - 1] = '\0';
-    event.valid = true;
+bool EventQueue::queueScanned(uint32_t sensorMask, uint32_t commandId) {
+    Event event = makeEvent(EventType::SCANNED, 0, commandId);
+    event.sensorMask = sensorMask;
     
     return enqueue(event);
 }
 
-bool EventQueue::queueTouchedDown(char position, uint32_t commandId) {
-    Event event;
-    event.type = EventType::TOUCHED_DOWN;
-    event.action[0] = '\0';
-    event.position = position;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::queueTouchedDown(char position, uint32_t commandId, uint32_t edgeUs, EventSource source) {
+    return enqueue(makeTouchEvent(EventType::TOUCHED_DOWN, position, commandId, edgeUs), source);
+}
+
+bool EventQueue::queueTouchedUp(char position, uint32_t commandId, uint32_t edgeUs, EventSource source) {
+    return enqueue(makeTouchEvent(EventType::TOUCHED_UP, position, commandId, edgeUs), source);
+}
+
+bool EventQueue::queueRecalibrated(char position, uint32_t commandId) {
+    return enqueue(makeEvent(EventType::RECALIBRATED, position, commandId));
+}
+
+bool EventQueue::queueInfo(uint32_t commandId, const char* details) {
+    if (!enqueue(makeEvent(EventType::INFO, 0, commandId))) {
+        return false;
+    }
     
-    return enqueue(event);
+    if (details) {
+        strncpy(m_infoDetails, details, sizeof(m_infoDetails) - 1);
+        m_infoDetails[sizeof(m_infoDetails) - 1] = '\0';
+    } else {
+        m_infoDetails[0] = '\0';
+    }
+    return true;
 }
 
-bool EventQueue::queueTouchedUp(char position, uint32_t commandId) {
-    Event event;
-    event.type = EventType::TOUCHED_UP;
-    event.action[0] = '\0';
-    event.position = position;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::queueMode(bool binary, uint32_t commandId) {
+    Event event = makeEvent(EventType::MODE, 0, commandId);
+    event.action = CommandAction::MODE;
+    event.binary = binary;
     
     return enqueue(event);
 }
 
-bool EventQueue::queueRecalibrated(char position, uint32_t commandId) {
-    Event event;
-    event.type = EventType::RECALIBRATED;
-    event.action[0] = '\0';
-    event.position = position;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
-    
+bool EventQueue::queueStats(uint32_t commandId) {
+    return enqueue(makeEvent(EventType::STATS, 0, commandId));
+}
+
+bool EventQueue::queueMem(uint32_t commandId) {
+    return enqueue(makeEvent(EventType::MEM, 0, commandId));
+}
+
+bool EventQueue::queueProfile(uint8_t stage, uint32_t commandId) {
+    Event event = makeEvent(EventType::PROFILE, 0, commandId);
+    event.stage = stage;
     return enqueue(event);
 }
 
-bool EventQueue::queueInfo(uint32_t commandId) {
-    Event event;
-    event.type = EventType::INFO;
-    event.action[0] = '\0';
-    event.position = 0;
-    event.commandId = commandId;
-    event.extra[0] = '\0';
-    event.valid = true;
+bool EventQueue::queueLatencyEcho(char position, uint32_t rxUs, uint32_t commandId) {
+    for (uint8_t i = 0; i < LATENCY_SLOTS; i++) {
+        LatencySlot& slot = m_latency[i];
+        if (slot.state != LatencyState::SENT || slot.position != position) {
+            continue;
+        }
+        
+        Event event = makeEvent(EventType::LATENCY, position, commandId);
+        event.latency.replyUs = rxUs - slot.sentUs;
+        event.latency.slot = i;
+        
+        // One answer per touch-down, even if this one is lost
+        slot.state = enqueue(event) ? LatencyState::ECHOED : LatencyState::FREE;
+        return slot.state == LatencyState::ECHOED;
+    }
     
-    return enqueue(event);
+    return false;
 }
 
 // ============================================================================
 // Private Methods
 // ============================================================================
 
-bool EventQueue::enqueue(const Event& event) {
+Event EventQueue::makeEvent(EventType type, char position, uint32_t commandId) {
+    Event event;
+    event.type = type;
+    event.action = CommandAction::INVALID;
+    event.position = position;
+    event.sequence = 0;
+    event.commandId = commandId;
+    event.sensorMask = 0;
+    
+    return event;
+}
+
+Event EventQueue::makeTouchEvent(EventType type, char position, uint32_t commandId, uint32_t edgeUs) {
+    Event event = makeEvent(type, position, commandId);
+    event.touch.edgeUs = edgeUs;
+    event.touch.queuedUs = micros();
+    
+    return event;
+}
+
+bool EventQueue::enqueue(const Event& event, EventSource source) {
+    if (source != EventSource::LOOP) {
+        // Single producer: fill the slot, then publish it with head
+        EventRing& ring = m_rings[(uint8_t)source - 1];
+        uint8_t head = ring.head.load(std::memory_order_relaxed);
+        if ((uint8_t)(head - ring.tail.load(std::memory_order_acquire)) >= EVENT_RING_SIZE) {
+            ring.dropped = ring.dropped + 1;
+            return false;
+        }
+        
+        Event& slot = ring.events[head & (EVENT_RING_SIZE - 1)];
+        slot = event;
+        slot.sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
+        ring.head.store((uint8_t)(head + 1), std::memory_order_release);
+        return true;
+    }
+    
     if (isFull()) {
+        m_dropped++;
         return false;
     }
     
-    m_queue[m_head] = event;
+    Event& slot = m_queue[m_head];
+    slot = event;
+    slot.sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
     m_head = (m_head + 1) % EVENT_QUEUE_SIZE;
     m_count++;
     
+    if (m_count > m_highWater) {
+        m_highWater = m_count;
+    }
+    
     return true;
 }
 
-void EventQueue::sendEvent(const Event& event) {
-    // All Arduino responses are prefixed with ARDUINO>
-    Serial.print("ARDUINO> ");
+const Event* EventQueue::peekOldest(EventSource& source) {
+    const Event* oldest = m_count > 0 ? &m_queue[m_tail] : nullptr;
+    source = EventSource::LOOP;
+    
+    for (uint8_t i = 0; i < EVENT_SOURCE_COUNT - 1; i++) {
+        EventRing& ring = m_rings[i];
+        uint8_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (ring.head.load(std::memory_order_acquire) == tail) {
+            continue;
+        }
+        
+        // Sequence numbers wrap; at most half their range is ever waiting
+        const Event* head = &ring.events[tail & (EVENT_RING_SIZE - 1)];
+        if (!oldest || (int8_t)(head->sequence - oldest->sequence) < 0) {
+            oldest = head;
+            source = static_cast<EventSource>(i + 1);
+        }
+    }
+    
+    return oldest;
+}
+
+void EventQueue::popOldest(EventSource source) {
+    if (source == EventSource::LOOP) {
+        m_tail = (m_tail + 1) % EVENT_QUEUE_SIZE;
+        m_count--;
+        return;
+    }
+    
+    // Hand the slot back only after it was formatted
+    EventRing& ring = m_rings[(uint8_t)source - 1];
+    ring.tail.store((uint8_t)(ring.tail.load(std::memory_order_relaxed) + 1), std::memory_order_release);
+}
+
+bool EventQueue::coalesceTouch(EventType opposite, char position) {
+    // Newest queued event for this position
+    for (uint8_t k = m_count; k > 0; k--) {
+        uint8_t index = (m_tail + k - 1) % EVENT_QUEUE_SIZE;
+        if (m_queue[index].position != position) {
+            continue;
+        }
+        if (m_queue[index].type != opposite) {
+            return false;
+        }
+        
+        // Close the gap
+        for (uint8_t j = k; j < m_count; j++) {
+            m_queue[(m_tail + j - 1) % EVENT_QUEUE_SIZE] = m_queue[(m_tail + j) % EVENT_QUEUE_SIZE];
+        }
+        m_head = (m_head + EVENT_QUEUE_SIZE - 1) % EVENT_QUEUE_SIZE;
+        m_count--;
+        m_coalesced++;
+        return true;
+    }
+    
+    return false;
+}
+
+void EventQueue::recordLatency(const Event& event) {
+    LatencySlot* same = nullptr;
+    LatencySlot* unused = nullptr;
+    LatencySlot* oldest = nullptr;
+    
+    for (uint8_t i = 0; i < LATENCY_SLOTS; i++) {
+        LatencySlot& slot = m_latency[i];
+        if (slot.state == LatencyState::FREE) {
+            unused = &slot;
+        } else if (slot.state == LatencyState::SENT) {
+            if (slot.position == event.position) {
+                same = &slot;
+            }
+            if (!oldest || m_flushUs - slot.sentUs > m_flushUs - oldest->sentUs) {
+                oldest = &slot;
+            }
+        }
+    }
+    
+    LatencySlot* target = same ? same : (unused ? unused : oldest);
+    if (!target) {
+        return;  // Every slot waits for its LATENCY event to go out
+    }
+    
+    target->position = event.position;
+    target->state = LatencyState::SENT;
+    target->debounceUs = event.touch.queuedUs - event.touch.edgeUs;
+    target->queueUs = m_flushUs - event.touch.queuedUs;
+    target->sentUs = m_flushUs;
+}
+
+void EventQueue::pushTx(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        m_txBuffer[m_txHead] = data[i];
+        m_txHead = (m_txHead + 1) % EVENT_TX_BUFFER_SIZE;
+    }
+    m_txCount += len;
+}
+
+void EventQueue::writeTx() {
+    // At most two writes: up to the end of the ring, then the wrapped part
+    while (m_txCount > 0) {
+        bool paced;
+        int room = portRoom(paced);
+        if (room <= 0) {
+            return;
+        }
+        
+        uint16_t contiguous = EVENT_TX_BUFFER_SIZE - m_txTail;
+        uint16_t len = m_txCount < contiguous ? m_txCount : contiguous;
+        if ((uint16_t)room < len) {
+            len = room;
+        }
+        
+        size_t written = PI_SERIAL.write(m_txBuffer + m_txTail, len);
+        m_txTail = (m_txTail + written) % EVENT_TX_BUFFER_SIZE;
+        m_txCount -= written;
+        m_txBytes += written;
+        
+        if (paced) {
+            // The link is busy for these bytes after what is still in flight
+            uint32_t now = micros();
+            if ((int32_t)(m_txPacedUntil - now) < 0) {
+                m_txPacedUntil = now;
+            }
+            m_txPacedUntil += linkTimeUs(written);
+        }
+        
+        if (written < len) {
+            return;
+        }
+    }
+}
+
+int EventQueue::portRoom(bool& paced) {
+    int room = PI_SERIAL.availableForWrite();
+    paced = room <= 0;
+    if (!paced) {
+        return room;
+    }
+    
+    int32_t busyUs = (int32_t)(m_txPacedUntil - micros());
+    if (m_linkRate == 0 || busyUs <= 0) {
+        return SERIAL_TX_FALLBACK_CHUNK;
+    }
+    
+    // Bytes still in flight, rounded up (busyUs is at most a few ms)
+    uint32_t inFlight = ((uint32_t)busyUs * (m_linkRate / 100) + 99999) / 100000;
+    return inFlight < SERIAL_TX_FALLBACK_CHUNK ? (int)(SERIAL_TX_FALLBACK_CHUNK - inFlight) : 0;
+}
+
+uint32_t EventQueue::linkTimeUs(uint32_t bytes) const {
+    if (m_linkRate == 0) {
+        return 0;
+    }
+    return (bytes * 10000000UL + m_linkRate - 1) / m_linkRate;
+}
+
+size_t EventQueue::formatBinaryEvent(const Event& event, uint8_t* out) {
+    uint8_t frame[BINARY_MAX_FRAME_LEN];
+    size_t len = 0;
+    
+    // Header: [opcode|has-id][position][id varint]
+    EventType type = (event.type == EventType::MODE) ? EventType::ACK : event.type;
+    bool hasId = event.commandId != NO_COMMAND_ID;
+    frame[len++] = static_cast<uint8_t>(type) | (hasId ? BINARY_FLAG_HAS_ID : 0);
+    frame[len++] = (uint8_t)event.position;
+    if (hasId) {
+        len += BinaryProtocol::putVarint(frame + len, event.commandId);
+    }
+    
+    // Payload (text payloads keep one byte free for the CRC)
+    char* text = (char*)frame;
+    size_t textSize = sizeof(frame) - 1;
     
     switch (event.type) {
         case EventType::ACK:
-            Serial.print("ACK ");
-            Serial.print(event.action);
-            if (event.position != 0) {
-                Serial.print(" ");
-                Serial.print(event.position);
+        case EventType::DONE:
+        case EventType::MODE:
+            frame[len++] = static_cast<uint8_t>(event.action);
+            if (event.type == EventType::ACK && event.positionMask != 0) {
+                len += BinaryProtocol::putVarint(frame + len, event.positionMask);
             }
-            if (event.commandId != NO_COMMAND_ID) {
-                Serial.print(" #");
-                Serial.print(event.commandId);
+            break;
+            
+        case EventType::SCANNED:
+            len += BinaryProtocol::putVarint(frame + len, event.sensorMask);
+            break;
+            
+        case EventType::SCAN_RESULT:
+            frame[len++] = event.address;
+            break;
+            
+        case EventType::ERR:
+            len = appendText(text, len, textSize, "%s", event.reason);
+            break;
+            
+        case EventType::INFO:
+            len = formatInfo(text, len, textSize);
+            break;
+            
+        case EventType::STATS:
+            len = formatStats(text, len, textSize);
+            break;
+            
+        case EventType::MEM:
+            len = formatMem(text, len, textSize);
+            break;
+            
+        case EventType::PROFILE:
+            len = formatProfile(event.stage, text, len, textSize);
+            break;
+            
+        case EventType::TOUCH_DOWN:
+        case EventType::TOUCHED_DOWN:
+            if (m_latencyMode) {
+                len += BinaryProtocol::putVarint(frame + len, event.touch.edgeUs);
+                len += BinaryProtocol::putVarint(frame + len, m_flushUs);
             }
-            Serial.println();
             break;
             
+        case EventType::LATENCY: {
+            const LatencySlot& slot = m_latency[event.latency.slot];
+            len += BinaryProtocol::putVarint(frame + len, slot.debounceUs);
+            len += BinaryProtocol::putVarint(frame + len, slot.queueUs);
+            len += BinaryProtocol::putVarint(frame + len, event.latency.replyUs);
+            break;
+        }
+            
+        default:
+            break;  // Header only
+    }
+    
+    return BinaryProtocol::finishFrame(frame, len, out);
+}
+
+size_t EventQueue::formatEvent(const Event& event, char* out) {
+    // All Arduino responses are prefixed with ARDUINO>
+    size_t len = appendText(out, 0, MAX_EVENT_LEN, "ARDUINO> ");
+    
+    switch (event.type) {
+        case EventType::ACK:
         case EventType::DONE:
-            Serial.print("DONE ");
-            Serial.print(event.action);
+            len = appendText(out, len, MAX_EVENT_LEN, "%s %s",
+                             event.type == EventType::ACK ? "ACK" : "DONE",
+                             CommandController::actionToString(event.action));
             if (event.position != 0) {
-                Serial.print(" ");
-                Serial.print(event.position);
-            }
-            if (event.commandId != NO_COMMAND_ID) {
-                Serial.print(" #");
-                Serial.print(event.commandId);
+                len = appendText(out, len, MAX_EVENT_LEN, " %c", event.position);
+            } else if (event.type == EventType::ACK && event.positionMask != 0) {
+                len = appendText(out, len, MAX_EVENT_LEN, " ");
+                len = appendPositionList(out, len, MAX_EVENT_LEN, event.positionMask);
             }
-            Serial.println();
             break;
             
         case EventType::ERR:
-            Serial.print("ERR ");
-            Serial.print(event.extra);
-            if (event.commandId != NO
\ No newline at end of file
+            len = appendText(out, len, MAX_EVENT_LEN, "ERR %s", event.reason);
+            break;
+            
+        case EventType::TOUCH_DOWN:
+            len = appendText(out, len, MAX_EVENT_LEN, "TOUCH_DOWN %c", event.position);
+            len = formatTouchTimes(event, out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::TOUCH_UP:
+            len = appendText(out, len, MAX_EVENT_LEN, "TOUCH_UP %c", event.position);
+            break;
+            
+        case EventType::TOUCHED_DOWN:
+            len = appendText(out, len, MAX_EVENT_LEN, "TOUCHED_DOWN %c", event.position);
+            len = formatTouchTimes(event, out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::TOUCHED_UP:
+            len = appendText(out, len, MAX_EVENT_LEN, "TOUCHED_UP %c", event.position);
+            break;
+            
+        case EventType::SCANNED:
+            len = appendText(out, len, MAX_EVENT_LEN, "SCANNED[");
+            len = appendPositionList(out, len, MAX_EVENT_LEN, event.sensorMask);
+            len = appendText(out, len, MAX_EVENT_LEN, "]");
+            break;
+            
+        case EventType::RECALIBRATED:
+            if (event.position != 0) {
+                len = appendText(out, len, MAX_EVENT_LEN, "RECALIBRATED %c", event.position);
+            } else {
+                len = appendText(out, len, MAX_EVENT_LEN, "RECALIBRATED ALL");
+            }
+            break;
+            
+        case EventType::SCAN_RESULT:
+            len = appendText(out, len, MAX_EVENT_LEN, "SCAN_RESULT 0x%02X", event.address);
+            break;
+            
+        case EventType::SCAN_DONE:
+            len = appendText(out, len, MAX_EVENT_LEN, "SCAN_DONE");
+            break;
+            
+        case EventType::INFO:
+            len = appendText(out, len, MAX_EVENT_LEN, "INFO ");
+            len = formatInfo(out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::STATS:
+            len = appendText(out, len, MAX_EVENT_LEN, "STATS ");
+            len = formatStats(out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::MEM:
+            len = appendText(out, len, MAX_EVENT_LEN, "MEM ");
+            len = formatMem(out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::PROFILE:
+            len = appendText(out, len, MAX_EVENT_LEN, "PROFILE ");
+            len = formatProfile(event.stage, out, len, MAX_EVENT_LEN);
+            break;
+            
+        case EventType::LATENCY: {
+            const LatencySlot& slot = m_latency[event.latency.slot];
+            len = appendText(out, len, MAX_EVENT_LEN, "LATENCY %c debounce=%lu queue=%lu reply=%lu total=%lu",
+                             event.position, (unsigned long)slot.debounceUs, (unsigned long)slot.queueUs,
+                             (unsigned long)event.latency.replyUs,
+                             (unsigned long)(slot.debounceUs + slot.queueUs + event.latency.replyUs));
+            break;
+        }
+            
+        case EventType::MODE:
+            len = appendText(out, len, MAX_EVENT_LEN, "ACK MODE %s", event.binary ? "BINARY" : "ASCII");
+            break;
+    }
+    
+    // Command ID (never set for spontaneous events), then line ending
+    if (event.commandId != NO_COMMAND_ID) {
+        len = appendText(out, len, MAX_EVENT_LEN, " #%lu", (unsigned long)event.commandId);
+    }
+    return appendText(out, len, MAX_EVENT_LEN, "\r\n");
+}
+
+size_t EventQueue::formatTouchTimes(const Event& event, char* out, size_t len, size_t size) const {
+    if (!m_latencyMode) {
+        return len;
+    }
+    return appendText(out, len, size, " edge=%lu sent=%lu",
+                      (unsigned long)event.touch.edgeUs, (unsigned long)m_flushUs);
+}
+
+size_t EventQueue::formatInfo(char* out, size_t len, size_t size) const {
+    len = appendText(out, len, size, "firmware=%s protocol=%s", FIRMWARE_VERSION, PROTOCOL_VERSION);
+    if (m_linkRate == 0) {
+        len = appendText(out, len, size, " link=usb");
+    } else {
+        len = appendText(out, len, size, " link=%lu", (unsigned long)m_linkRate);
+    }
+    len = appendText(out, len, size, " tx=%lu", (unsigned long)m_txRate);
+    if (m_infoDetails[0] != '\0') {
+        len = appendText(out, len, size, " %s", m_infoDetails);
+    }
+    return len;
+}
+
+size_t EventQueue::formatStats(char* out, size_t len, size_t size) const {
+    return appendText(out, len, size, "queue_hw=%u/%u tx_hw=%u/%u dropped=%lu coalesced=%lu rx_dropped=%lu",
+                      (unsigned)m_highWater, (unsigned)EVENT_QUEUE_SIZE,
+                      (unsigned)m_txHighWater, (unsigned)EVENT_TX_BUFFER_SIZE,
+                      (unsigned long)getDroppedCount(), (unsigned long)m_coalesced,
+                      (unsigned long)m_rxDropped);
+}
+
+size_t EventQueue::formatMem(char* out, size_t len, size_t size) const {
+    len = appendText(out, len, size, "stack=%lu stack_min=%lu heap=%lu",
+                     (unsigned long)MemoryReport::freeStack(),
+                     (unsigned long)MemoryReport::minFreeStack(),
+                     (unsigned long)MemoryReport::freeHeap());
+    
+    // Components not in this build (0 bytes) are left out
+    for (uint8_t i = 0; i < MEMORY_COMPONENT_COUNT; i++) {
+        MemoryComponent component = static_cast<MemoryComponent>(i);
+        uint32_t bytes = MemoryReport::componentBytes(component);
+        if (bytes != 0) {
+            len = appendText(out, len, size, " %s=%lu", MemoryReport::componentName(component),
+                             (unsigned long)bytes);
+        }
+    }
+    return len;
+}
+
+size_t EventQueue::formatProfile(uint8_t stage, char* out, size_t len, size_t size) const {
+#if ENABLE_PROFILER
+    ProfileStage id = static_cast<ProfileStage>(stage);
+    ProfileStat s = Profiler::peek(id);
+    len = appendText(out, len, size, "%s n=%lu min=%lu avg=%lu max=%lu", Profiler::stageName(id),
+                     (unsigned long)s.count, (unsigned long)s.minUs,
+                     (unsigned long)(s.count ? s.totalUs / s.count : 0), (unsigned long)s.maxUs);
+    if (id == ProfileStage::LOOP) {
+        len = appendText(out, len, size, " hz=%lu", (unsigned long)Profiler::loopRate());
+    }
+#else
+    (void)stage;
+    (void)out;
+    (void)size;
+#endif
+    return len;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file I2cEngine.cpp
+ * @brief Implementation of the time-sliced I2C transaction engine
+ */
+
+#include "I2cEngine.h"
+#include "Profiler.h"
+
+// ============================================================================
+// Constructor
+// ============================================================================
+
+I2cEngine::I2cEngine()
+    : m_pendingHead(0)
+    , m_pendingTail(0)
+    , m_pendingCount(0)
+    , m_completedHead(0)
+    , m_completedTail(0)
+    , m_completedCount(0)
+    , m_recentNext(0)
+    , m_clockHz(0)
+    , m_timeoutUs(I2C_TIMEOUT_US)
+    , m_lastError(I2cError::NONE)
+{
+    for (uint8_t i = 0; i < RECENT_TRANSFERS; i++) {
+        m_recentAddress[i] = 0xFF;  // Not a 7-bit address
+        m_recentUs[i] = 0;
+    }
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void I2cEngine::begin(uint32_t clockHz) {
+    Wire.begin();
+    setClock(clockHz);
+    setTimeout(m_timeoutUs);
+    reset();
+}
+
+void I2cEngine::reset() {
+    m_pendingHead = 0;
+    m_pendingTail = 0;
+    m_pendingCount = 0;
+    m_completedHead = 0;
+    m_completedTail = 0;
+    m_completedCount = 0;
+}
+
+void I2cEngine::setClock(uint32_t clockHz) {
+    m_clockHz = clockHz;
+    Wire.setClock(clockHz);
+}
+
+void I2cEngine::setTimeout(uint16_t timeoutUs) {
+    m_timeoutUs = timeoutUs;
+    // Reset the peripheral on a timeout so the next transfer starts clean
+    Wire.setWireTimeout(timeoutUs, true);
+}
+
+uint32_t I2cEngine::getClock() const {
+    return m_clockHz;
+}
+
+bool I2cEngine::submit(I2cOp op, uint8_t address, uint8_t reg, uint8_t value,
+                       uint8_t tag, uint8_t kind) {
+    if (m_pendingCount >= I2C_QUEUE_SIZE) {
+        return false;
+    }
+    
+    I2cTransaction& t = m_pending[m_pendingHead];
+    t.op = op;
+    t.address = address;
+    t.reg = reg;
+    t.value = value;
+    t.tag = tag;
+    t.kind = kind;
+    t.phase = 0;
+    t.ok = false;
+    t.error = I2cError::NONE;
+    
+    m_pendingHead = (m_pendingHead + 1) % I2C_QUEUE_SIZE;
+    m_pendingCount++;
+    return true;
+}
+
+void I2cEngine::run(uint32_t budgetUs) {
+    uint32_t start = micros();
+    
+    while (m_pendingCount > 0 && m_completedCount < I2C_QUEUE_SIZE) {
+        // Stop if the next transfer (including turnaround) might not fit
+        uint32_t used = micros() - start;
+        if (used + I2C_TURNAROUND_US >= budgetUs) {
+            break;
+        }
+        
+        I2cTransaction& t = m_pending[m_pendingTail];
+        waitTurnaround(t.address);
+        
+        if (!step(t)) {
+            continue;  // More transfers needed for this transaction
+        }
+        
+        // Move to completed queue
+        m_completed[m_completedHead] = t;
+        m_completedHead = (m_completedHead + 1) % I2C_QUEUE_SIZE;
+        m_completedCount++;
+        
+        m_pendingTail = (m_pendingTail + 1) % I2C_QUEUE_SIZE;
+        m_pendingCount--;
+    }
+}
+
+bool I2cEngine::takeCompleted(I2cTransaction& out) {
+    if (m_completedCount == 0) {
+        return false;
+    }
+    
+    out = m_completed[m_completedTail];
+    m_completedTail = (m_completedTail + 1) % I2C_QUEUE_SIZE;
+    m_completedCount--;
+    return true;
+}
+
+bool I2cEngine::isIdle() const {
+    return m_pendingCount == 0 && m_completedCount == 0;
+}
+
+uint8_t I2cEngine::freeSlots() const {
+    return I2C_QUEUE_SIZE - m_pendingCount;
+}
+
+bool I2cEngine::probe(uint8_t address) {
+    waitTurnaround(address);
+    m_lastError = transferProbe(address);
+    return m_lastError == I2cError::NONE;
+}
+
+bool I2cEngine::readRegister(uint8_t address, uint8_t reg, uint8_t& value) {
+    waitTurnaround(address);
+    m_lastError = transferRead(address, reg, value);
+    return m_lastError == I2cError::NONE;
+}
+
+bool I2cEngine::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+    waitTurnaround(address);
+    m_lastError = transferWrite(address, reg, value);
+    return m_lastError == I2cError::NONE;
+}
+
+I2cError I2cEngine::lastError() const {
+    return m_lastError;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+bool I2cEngine::step(I2cTransaction& t) {
+    PROFILE_SCOPE(I2C);
+    
+    switch (t.op) {
+        case I2cOp::PROBE:
+            t.error = transferProbe(t.address);
+            break;
+            
+        case I2cOp::READ:
+            t.error = transferRead(t.address, t.reg, t.value);
+            break;
+            
+        case I2cOp::WRITE:
+            t.error = transferWrite(t.address, t.reg, t.value);
+            break;
+            
+        case I2cOp::CLEAR_BITS: {
+            if (t.phase == 0) {
+                // Read current value; t.value holds the mask until phase 1
+                uint8_t current;
+                t.error = transferRead(t.address, t.reg, current);
+                if (t.error == I2cError::NONE && (current & t.value) != 0) {
+                    t.value = current & ~t.value;
+                    t.phase = 1;
+                    return false;
+                }
+                break;  // Failed, or nothing to clear
+            }
+            
+            // Phase 1: write back the cleared value
+            t.error = transferWrite(t.address, t.reg, t.value);
+            break;
+        }
+    }
+    
+    t.ok = t.error == I2cError::NONE;
+    return true;
+}
+
+void I2cEngine::waitTurnaround(uint8_t address) {
+    // Wait from the device's own last transfer. If it is not among the
+    // recent ones, it ended before the oldest of them did.
+    uint8_t slot = m_recentNext;
+    for (uint8_t i = 0; i < RECENT_TRANSFERS; i++) {
+        uint8_t index = (m_recentNext + i) % RECENT_TRANSFERS;
+        if (m_recentAddress[index] == address) {
+            slot = index;  // Keep the newest match
+        }
+    }
+    
+    while (micros() - m_recentUs[slot] < I2C_TURNAROUND_US) {
+        // Bounded by I2C_TURNAROUND_US
+    }
+}
+
+void I2cEngine::noteTransfer(uint8_t address) {
+    m_recentAddress[m_recentNext] = address;
+    m_recentUs[m_recentNext] = micros();
+    m_recentNext = (m_recentNext + 1) % RECENT_TRANSFERS;
+}
+
+I2cError I2cEngine::transferRead(uint8_t address, uint8_t reg, uint8_t& value) {
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    I2cError error = classify(Wire.endTransmission(false));
+    
+    if (error == I2cError::NONE) {
+        if (Wire.requestFrom(address, (uint8_t)1) == 1) {
+            value = Wire.read();
+        } else {
+            error = I2cError::NACK;
+        }
+    }
+    
+    noteTransfer(address);
+    return error;
+}
+
+I2cError I2cEngine::transferWrite(uint8_t address, uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    Wire.write(value);
+    I2cError error = classify(Wire.endTransmission());
+    
+    noteTransfer(address);
+    return error;
+}
+
+I2cError I2cEngine::transferProbe(uint8_t address) {
+    Wire.beginTransmission(address);
+    I2cError error = classify(Wire.endTransmission());
+    
+    noteTransfer(address);
+    return error;
+}
+
+I2cError I2cEngine::classify(uint8_t status) {
+    switch (status) {
+        case 0:
+            return I2cError::NONE;
+        case 2:     // NACK on address
+        case 3:     // NACK on data
+            return I2cError::NACK;
+        default:    // Timeout / other bus error
+            return I2cError::TIMEOUT;
+    }
+}
@@ -6,6 +6,8 @@
  */
 
 #include "LedController.h"
+#include "Effects.h"
+#include "Profiler.h"
 
 // ============================================================================
 // LED Position Mappings
@@ -64,6 +66,53 @@ static const LedMapping LED_MAPPINGS[NUM_POSITIONS] = {
     { StripId::STRIP2, 34 }
 };
 
+// ============================================================================
+// Output Backends
+// ============================================================================
+
+static_assert(!(STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC && STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC),
+              "Only one strip can use the SPI output");
+
+static NeoPixelOutput s_neoPixelOutput;
+
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC || STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC
+static SpiDtcOutput s_spiOutput;
+#endif
+
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC
+static LedOutput* const STRIP1_BACKEND = &s_spiOutput;
+#else
+static LedOutput* const STRIP1_BACKEND = &s_neoPixelOutput;
+#endif
+
+#if STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC
+static LedOutput* const STRIP2_BACKEND = &s_spiOutput;
+#else
+static LedOutput* const STRIP2_BACKEND = &s_neoPixelOutput;
+#endif
+
+// ============================================================================
+// Layer Colors
+// ============================================================================
+
+static const RgbColor COLOR_SHOW = { COLOR_SHOW_R, COLOR_SHOW_G, COLOR_SHOW_B };
+static const RgbColor COLOR_BLINK = { COLOR_BLINK_R, COLOR_BLINK_G, COLOR_BLINK_B };
+static const RgbColor COLOR_OFF = { COLOR_OFF_R, COLOR_OFF_G, COLOR_OFF_B };
+
+// Global brightness applied while composing (same scaling as
+// Adafruit_NeoPixel::setBrightness, which is not used on the strips)
+static uint8_t s_brightnessLut[256];
+
+// Layer colors with brightness applied (set in begin())
+static GrbColor s_showScaled;
+static GrbColor s_blinkScaled;
+static GrbColor s_offScaled;
+
+#if LED_FRAME_TIMER
+// Frame ticks counted by the frame timer interrupt
+static volatile uint32_t s_frameTicks = 0;
+#endif
+
 // ============================================================================
 // Constructor
 // ============================================================================
@@ -71,10 +120,23 @@ static const LedMapping LED_MAPPINGS[NUM_POSITIONS] = {
 LedController::LedController()
     : m_strip1(NUM_LEDS_STRIP1, STRIP1_PIN, NEO_GRB + NEO_KHZ800)
     , m_strip2(NUM_LEDS_STRIP2, STRIP2_PIN, NEO_GRB + NEO_KHZ800)
+    , m_outputs{STRIP1_BACKEND, STRIP2_BACKEND}
     , m_sequenceAnimActive(false)
-    , m_sequenceAnimStep(0)
-    , m_sequenceAnimLastTime(0)
-    , m_needsUpdate(false)
+    , m_overlayEffect(NO_EFFECT)
+    , m_overlayEffectStart(0)
+    , m_frame(0)
+    , m_blinkOn(true)
+#if LED_FRAME_TIMER
+    , m_frameTimerRunning(false)
+#endif
+    , m_overlayColor(COLOR_OFF)
+    , m_overlayScaled{0, 0, 0}
+    , m_streamActive(false)
+    , m_streamLit(0)
+    , m_overlayActive(false)
+    , m_frameDirty(false)
+    , m_framesHeld(false)
+    , m_dirtyLength{0, 0}
 {
 }
 
@@ -83,57 +145,92 @@ LedController::LedController()
 // ============================================================================
 
 void LedController::begin() {
-    // Initialize NeoPixel strips
+    // Initialize NeoPixel strips (pixel storage) and their outputs
     m_strip1.begin();
     m_strip2.begin();
+    m_outputs[0]->begin();
+    if (m_outputs[1] != m_outputs[0]) {
+        m_outputs[1]->begin();
+    }
     
-    // Set global brightness
-    m_strip1.setBrightness(LED_BRIGHTNESS);
-    m_strip2.setBrightness(LED_BRIGHTNESS);
+    // Brightness is applied when composing
+    for (uint16_t i = 0; i < 256; i++) {
+        s_brightnessLut[i] = (uint8_t)((i * (LED_BRIGHTNESS + 1)) >> 8);
+    }
+    s_showScaled = scaleColor(COLOR_SHOW);
+    s_blinkScaled = scaleColor(COLOR_BLINK);
+    s_offScaled = scaleColor(COLOR_OFF);
     
     // Clear all LEDs
     m_strip1.clear();
     m_strip2.clear();
-    m_strip1.show();
-    m_strip2.show();
+    m_outputs[0]->show(m_strip1, NUM_LEDS_STRIP1);
+    m_outputs[1]->show(m_strip2, NUM_LEDS_STRIP2);
     
     // Initialize position states
     for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
         m_positions[i].state = PositionState::OFF;
         m_positions[i].animationStep = 0;
-        m_positions[i].lastAnimationTime = 0;
-        m_positions[i].blinkOn = false;
+        m_positions[i].effect = NO_EFFECT;
+        m_positions[i].color = COLOR_OFF;
+        m_positions[i].scaled = s_offScaled;
+        m_positions[i].startFrame = 0;
     }
     
     // Initialize SEQUENCE_COMPLETED animation state
     m_sequenceAnimActive = false;
-    m_sequenceAnimStep = 0;
-    m_sequenceAnimLastTime = 0;
-    
-    m_needsUpdate = false;
+    m_overlayEffect = NO_EFFECT;
+    m_overlayEffectStart = 0;
+    
+    // Initialize framebuffer
+    fillPixels((uint8_t*)m_baseLayer, NUM_LEDS_TOTAL, s_offScaled);
+    memset(m_streamLayer, 0, sizeof(m_streamLayer));
+    m_overlayColor = COLOR_OFF;
+    m_overlayScaled = s_offScaled;
+    m_streamActive = false;
+    m_streamLit = 0;
+    m_overlayActive = false;
+    m_frameDirty = false;
+    m_dirtyLength[0] = 0;
+    m_dirtyLength[1] = 0;
+    
+    // Start the frame clock
+#if LED_FRAME_TIMER
+    m_frameTimerRunning = startFrameTimer();
+#endif
+    m_frame = currentFrame(millis());
+    m_blinkOn = true;
 }
 
 void LedController::update(uint32_t nowMillis) {
-    // Update all animating positions
+    // Nothing to do until the next frame tick
+    uint32_t frame = currentFrame(nowMillis);
+    if (frame == m_frame) {
+        return;
+    }
+    m_frame = frame;
+    
+    // Advance all timelines to this frame
     for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
         if (m_positions[i].state == PositionState::ANIMATING) {
-            updateAnimation(i, nowMillis);
+            updateAnimation(i);
         }
     }
     
-    // Update blinking positions
-    updateBlinking(nowMillis);
+    updateBlinking();
     
-    // Update SEQUENCE_COMPLETED animation if active
-    if (m_sequenceAnimActive) {
-        updateSequenceCompletedAnimation(nowMillis);
+    if (m_overlayEffect != NO_EFFECT) {
+        updateOverlayEffect();
     }
     
-    // Push updates to LEDs if needed
-    if (m_needsUpdate) {
-        m_strip1.show();
-        m_strip2.show();
-        m_needsUpdate = false;
+    // Compose and push everything that changed since the last tick
+    if (m_frameDirty && !m_framesHeld) {
+        m_frameDirty = false;
+        
+        rebuildBaseLayer();
+        composeStrip(StripId::STRIP1);
+        composeStrip(StripId::STRIP2);
+        pushDirtyStrips();
     }
 }
 
@@ -141,52 +238,70 @@ void LedController::tick() {
     update(millis());
 }
 
-bool LedController::show(uint8_t position) {
-    if (position >= NUM_POSITIONS) {
+void LedController::holdFrames(bool hold) {
+    m_framesHeld = hold;
+}
+
+bool LedController::writePixels(uint16_t offset, const uint8_t* rgb, uint16_t count) {
+    if (offset >= NUM_LEDS_TOTAL || count > NUM_LEDS_TOTAL - offset) {
         return false;
     }
     
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
-        return false;
+    // Count lit pixels so an all-black stream layer drops out of compose
+    const RgbColor* in = (const RgbColor*)rgb;
+    for (uint16_t i = 0; i < count; i++) {
+        const RgbColor& old = m_streamLayer[offset + i];
+        bool wasLit = (old.r | old.g | old.b) != 0;
+        bool isLit = (in[i].r | in[i].g | in[i].b) != 0;
+        m_streamLit += (uint16_t)isLit - (uint16_t)wasLit;
     }
     
-    // If currently expanded/animating, clear that region first
-    if (m_positions[position].state == PositionState::ANIMATING ||
-        m_positions[position].state == PositionState::EXPANDED) {
-        clearExpandedRegion(position, mapping);
+    memcpy(&m_streamLayer[offset], rgb, count * sizeof(RgbColor));
+    m_streamActive = m_streamLit != 0;
+    m_frameDirty = true;
+    
+    return true;
+}
+
+bool LedController::clearPixels(uint16_t offset) {
+    if (offset >= NUM_LEDS_TOTAL) {
+        return false;
     }
     
-    // Set to SHOWN state
-    m_positions[position].state = PositionState::SHOWN;
-    m_positions[position].animationStep = 0;
+    for (uint16_t i = offset; i < NUM_LEDS_TOTAL; i++) {
+        const RgbColor& old = m_streamLayer[i];
+        m_streamLit -= (old.r | old.g | old.b) != 0;
+    }
     
-    // Light the single LED in SHOW color (Blue)
-    setLed(mapping->strip, mapping->index, COLOR_SHOW_R, COLOR_SHOW_G, COLOR_SHOW_B);
-    m_needsUpdate = true;
+    memset(&m_streamLayer[offset], 0, (NUM_LEDS_TOTAL - offset) * sizeof(RgbColor));
+    m_streamActive = m_streamLit != 0;
+    m_frameDirty = true;
     
     return true;
 }
 
-bool LedController::hide(uint8_t position) {
+bool LedController::show(uint8_t position) {
     if (position >= NUM_POSITIONS) {
         return false;
     }
     
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
+    // Set to SHOWN state - single LED in SHOW color (Blue)
+    m_positions[position].state = PositionState::SHOWN;
+    m_positions[position].animationStep = 0;
+    m_frameDirty = true;
+    
+    return true;
+}
+
+bool LedController::hide(uint8_t position) {
+    if (position >= NUM_POSITIONS) {
         return false;
     }
     
-    // Clear expanded region (covers both single LED and expanded area)
-    clearExpandedRegion(position, mapping);
-    
-    // Reset state
+    // Reset state (covers both single LED and expanded area)
     m_positions[position].state = PositionState::OFF;
     m_positions[position].animationStep = 0;
-    m_positions[position].blinkOn = false;
-    
-    m_needsUpdate = true;
+    m_frameDirty = true;
     
     return true;
 }
@@ -196,26 +311,11 @@ bool LedController::blink(uint8_t position) {
         return false;
     }
     
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
-        return false;
-    }
-    
-    // If currently expanded/animating, clear that region first
-    if (m_positions[position].state == PositionState::ANIMATING ||
-        m_positions[position].state == PositionState::EXPANDED) {
-        clearExpandedRegion(position, mapping);
-    }
-    
-    // Set to BLINKING state
+    // Set to BLINKING state in BLINK color (orange) - signals "release me!"
+    // Joins the shared blink phase, so all blinking positions stay in step
     m_positions[position].state = PositionState::BLINKING;
     m_positions[position].animationStep = 0;
-    m_positions[position].lastAnimationTime = millis();
-    m_positions[position].blinkOn = true;  // Start with LED on
-    
-    // Light the LED in BLINK color (orange) - signals "release me!"
-    setLed(mapping->strip, mapping->index, COLOR_BLINK_R, COLOR_BLINK_G, COLOR_BLINK_B);
-    m_needsUpdate = true;
+    m_frameDirty = true;
     
     return true;
 }
@@ -230,20 +330,10 @@ bool LedController::stopBlink(uint8_t position) {
         return true; // Not an error, just no-op
     }
     
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
-        return false;
-    }
-    
-    // Turn off the LED
-    setLed(mapping->strip, mapping->index, COLOR_OFF_R, COLOR_OFF_G, COLOR_OFF_B);
-    
-    // Reset state
+    // Reset state (turns off the LED)
     m_positions[position].state = PositionState::OFF;
     m_positions[position].animationStep = 0;
-    m_positions[position].blinkOn = false;
-    
-    m_needsUpdate = true;
+    m_frameDirty = true;
     
     return true;
 }
@@ -256,34 +346,8 @@ bool LedController::isBlinking(uint8_t position) const {
 }
 
 bool LedController::success(uint8_t position) {
-    if (position >= NUM_POSITIONS) {
-        return false;
-    }
-    
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
-        return false;
-    }
-    
-    // If currently expanded/animating, clear that region first
-    if (m_positions[position].state == PositionState::ANIMATING ||
-        m_positions[position].state == PositionState::EXPANDED) {
-        clearExpandedRegion(position, mapping);
-    } else if (m_positions[position].state == PositionState::SHOWN) {
-        // Clear just the single LED if it was shown
-        setLed(mapping->strip, mapping->index, COLOR_OFF_R, COLOR_OFF_G, COLOR_OFF_B);
-    }
-    
-    // Start animation from center
-    m_positions[position].state = PositionState::ANIMATING;
-    m_positions[position].animationStep = 0;
-    m_positions[position].lastAnimationTime = millis();
-    
-    // Light the center LED immediately (Green)
-    setLed(mapping->strip, mapping->index, COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B);
-    m_needsUpdate = true;
-    
-    return true;
+    // Green expansion from the center, held when complete
+    return playEffect(EFFECT_SUCCESS, position);
 }
 
 bool LedController::isAnimationComplete(uint8_t position) const {
@@ -347,7 +411,7 @@ uint16_t LedController::getStripLength(StripId strip) const {
     }
 }
 
-Adafruit_NeoPixel* LedController::getStrip(StripId strip) {
+PrefixNeoPixel* LedController::getStrip(StripId strip) {
     switch (strip) {
         case StripId::STRIP1:
             return &m_strip1;
@@ -358,51 +422,89 @@ Adafruit_NeoPixel* LedController::getStrip(StripId strip) {
     }
 }
 
-void LedController::setLed(StripId strip, int16_t index, uint8_t r, uint8_t g, uint8_t b) {
-    if (index < 0) {
+uint16_t LedController::getStripOffset(StripId strip) const {
+    return strip == StripId::STRIP2 ? NUM_LEDS_STRIP1 : 0;
+}
+
+void LedController::setBasePixel(StripId strip, int16_t index, const GrbColor& color) {
+    if (index < 0 || index >= (int16_t)getStripLength(strip)) {
         return;
     }
-    
-    Adafruit_NeoPixel* stripPtr = getStrip(strip);
-    if (!stripPtr) {
-        return;
+    m_baseLayer[getStripOffset(strip) + index] = color;
+}
+
+void LedController::fillBase(StripId strip, int16_t first, int16_t last, const GrbColor& color) {
+    // Clip once instead of per pixel
+    int16_t length = (int16_t)getStripLength(strip);
+    if (first < 0) {
+        first = 0;
     }
-    
-    uint16_t stripLen = getStripLength(strip);
-    if (index < (int16_t)stripLen) {
-        stripPtr->setPixelColor(index, stripPtr->Color(r, g, b));
+    if (last >= length) {
+        last = length - 1;
+    }
+    if (first > last) {
+        return;
     }
+    fillPixels((uint8_t*)&m_baseLayer[getStripOffset(strip) + first], last - first + 1, color);
 }
 
-void LedController::clearExpandedRegion(uint8_t position, const LedMapping* mapping) {
-    if (!mapping) {
+GrbColor LedController::scaleColor(const RgbColor& color) {
+    return { s_brightnessLut[color.g], s_brightnessLut[color.r], s_brightnessLut[color.b] };
+}
+
+void LedController::fillPixels(uint8_t* pixels, uint16_t count, const GrbColor& color) {
+    if (count == 0) {
         return;
     }
     
-    uint16_t stripLen = getStripLength(mapping->strip);
-    int16_t center = mapping->index;
+    // Grey (including black) is the same byte throughout
+    if (color.g == color.r && color.g == color.b) {
+        memset(pixels, color.g, count * sizeof(GrbColor));
+        return;
+    }
     
-    // Clear center LED and expanded region
-    for (int16_t offset = -SUCCESS_EXPANSION_RADIUS; offset <= SUCCESS_EXPANSION_RADIUS; offset++) {
-        int16_t idx = center + offset;
-        if (idx >= 0 && idx < (int16_t)stripLen) {
-            setLed(mapping->strip, idx, COLOR_OFF_R, COLOR_OFF_G, COLOR_OFF_B);
-        }
+    // A few pixels one by one (a SUCCESS region is at most 11), then double
+    // the filled run until the range is covered
+    GrbColor* out = (GrbColor*)pixels;
+    uint16_t first = count < 8 ? count : 8;
+    for (uint16_t i = 0; i < first; i++) {
+        out[i] = color;
+    }
+    size_t filled = first * sizeof(GrbColor);
+    size_t total = count * sizeof(GrbColor);
+    while (filled < total) {
+        size_t n = filled < total - filled ? filled : total - filled;
+        memcpy(pixels + filled, pixels, n);
+        filled += n;
     }
 }
 
-void LedController::renderPosition(uint8_t position) {
-    if (position >= NUM_POSITIONS) {
-        return;
-    }
+void LedController::setOverlay(const RgbColor& color) {
+    m_overlayColor = color;
+    m_overlayScaled = scaleColor(color);
+    m_overlayActive = true;
+    m_frameDirty = true;
+}
+
+void LedController::rebuildBaseLayer() {
+    fillPixels((uint8_t*)m_baseLayer, NUM_LEDS_TOTAL, s_offScaled);
     
+    // SUCCESS regions first, so single LEDs always stay visible on top
+    for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
+        renderPosition(i, true);
+    }
+    for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
+        renderPosition(i, false);
+    }
+}
+
+void LedController::renderPosition(uint8_t position, bool expansions) {
     const LedMapping* mapping = getMapping(position);
     if (!mapping) {
         return;
     }
     
     PositionData& data = m_positions[position];
-    uint16_t stripLen = getStripLength(mapping->strip);
     int16_t center = mapping->index;
     
     switch (data.state) {
@@ -410,170 +512,302 @@ void LedController::renderPosition(uint8_t position) {
             break;
             
         case PositionState::SHOWN:
-            setLed(mapping->strip, center, COLOR_SHOW_R, COLOR_SHOW_G, COLOR_SHOW_B);
+            if (!expansions) {
+                setBasePixel(mapping->strip, center, s_showScaled);
+            }
             break;
             
         case PositionState::BLINKING:
             // Render based on current blink state - use orange to signal "release me!"
-            if (data.blinkOn) {
-                setLed(mapping->strip, center, COLOR_BLINK_R, COLOR_BLINK_G, COLOR_BLINK_B);
-            } else {
-                setLed(mapping->strip, center, COLOR_OFF_R, COLOR_OFF_G, COLOR_OFF_B);
+            if (!expansions && m_blinkOn) {
+                setBasePixel(mapping->strip, center, s_blinkScaled);
             }
             break;
             
         case PositionState::ANIMATING:
         case PositionState::EXPANDED: {
-            uint8_t radius = data.animationStep;
-            
-            // Center LED (Green)
-            setLed(mapping->strip, center, COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B);
-            
-            // Expanded LEDs (symmetric)
-            for (uint8_t r = 1; r <= radius; r++) {
-                int16_t leftIdx = center - r;
-                if (leftIdx >= 0) {
-                    setLed(mapping->strip, leftIdx, COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B);
-                }
-                
-                int16_t rightIdx = center + r;
-                if (rightIdx < (int16_t)stripLen) {
-                    setLed(mapping->strip, rightIdx, COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B);
-                }
+            if (!expansions) {
+                break;
             }
+            
+            // Center LED plus expanded LEDs (symmetric, clipped to the strip)
+            uint8_t radius = data.animationStep;
+            fillBase(mapping->strip, center - radius, center + radius, data.scaled);
             break;
         }
     }
 }
 
-void LedController::updateAnimation(uint8_t position, uint32_t nowMillis) {
-    PositionData& data = m_positions[position];
-    
-    // Check if enough time has passed
-    if (nowMillis - data.lastAnimationTime < ANIMATION_STEP_MS) {
+void LedController::composeStrip(StripId strip) {
+    PrefixNeoPixel* stripPtr = getStrip(strip);
+    if (!stripPtr) {
         return;
     }
     
-    const LedMapping* mapping = getMapping(position);
-    if (!mapping) {
-        return;
+    uint16_t offset = getStripOffset(strip);
+    uint16_t length = getStripLength(strip);
+    uint8_t* out = stripPtr->getPixels();
+    uint16_t dirty = 0;
+    bool overlayVisible = m_overlayActive &&
+                          (m_overlayColor.r | m_overlayColor.g | m_overlayColor.b) != 0;
+    
+    // Topmost non-black layer wins: overlay, stream, base
+    if (overlayVisible) {
+        // One color over the whole strip
+        const GrbColor& c = m_overlayScaled;
+        for (uint16_t i = length; i > 0; i--) {
+            const uint8_t* p = out + (i - 1) * sizeof(GrbColor);
+            if (p[0] != c.g || p[1] != c.r || p[2] != c.b) {
+                dirty = i;
+                break;
+            }
+        }
+        fillPixels(out, dirty, c);
+    } else if (!m_streamActive) {
+        // Base layer is already in strip format
+        const uint8_t* base = (const uint8_t*)&m_baseLayer[offset];
+        for (uint16_t i = length; i > 0; i--) {
+            if (memcmp(out + (i - 1) * sizeof(GrbColor), base + (i - 1) * sizeof(GrbColor),
+                       sizeof(GrbColor)) != 0) {
+                dirty = i;
+                break;
+            }
+        }
+        memcpy(out, base, dirty * sizeof(GrbColor));
+    } else {
+        for (uint16_t i = 0; i < length; i++) {
+            const GrbColor& base = m_baseLayer[offset + i];
+            const RgbColor& stream = m_streamLayer[offset + i];
+            uint8_t g = base.g;
+            uint8_t r = base.r;
+            uint8_t b = base.b;
+            if ((stream.r | stream.g | stream.b) != 0) {
+                g = s_brightnessLut[stream.g];
+                r = s_brightnessLut[stream.r];
+                b = s_brightnessLut[stream.b];
+            }
+            
+            if (out[0] != g || out[1] != r || out[2] != b) {
+                out[0] = g;
+                out[1] = r;
+                out[2] = b;
+                dirty = i + 1;
+            }
+            out += sizeof(GrbColor);
+        }
+    }
+    
+    uint8_t s = static_cast<uint8_t>(strip);
+    if (dirty > m_dirtyLength[s]) {
+        m_dirtyLength[s] = dirty;
+    }
+}
+
+void LedController::pushDirtyStrips() {
+    // Only changed strips, and only up to their last changed pixel
+    if (m_dirtyLength[0] > 0) {
+        PROFILE_CALL(STRIP_SHOW, m_outputs[0]->show(m_strip1, m_dirtyLength[0]));
+        m_dirtyLength[0] = 0;
+    }
+    if (m_dirtyLength[1] > 0) {
+        PROFILE_CALL(STRIP_SHOW, m_outputs[1]->show(m_strip2, m_dirtyLength[1]));
+        m_dirtyLength[1] = 0;
+    }
+}
+
+// ============================================================================
+// Frame Clock
+// ============================================================================
+
+#if LED_FRAME_TIMER
+bool LedController::startFrameTimer() {
+    // Prefer a GPT channel; fall back to an AGT one if all are taken
+    uint8_t type = GPT_TIMER;
+    int8_t channel = FspTimer::get_available_timer(type);
+    if (channel < 0) {
+        channel = FspTimer::get_available_timer(type, true);
+    }
+    if (channel < 0) {
+        return false;
     }
     
-    // Advance animation step
-    data.animationStep++;
-    data.lastAnimationTime = nowMillis;
+    if (!m_frameTimer.begin(TIMER_MODE_PERIODIC, type, channel, (float)LED_FRAME_RATE_HZ, 0.0f,
+                            &LedController::onFrameTimer)) {
+        return false;
+    }
     
-    // Check if animation is complete
-    if (data.animationStep >= SUCCESS_EXPANSION_RADIUS) {
-        data.animationStep = SUCCESS_EXPANSION_RADIUS;
-        data.state = PositionState::EXPANDED;
+    return m_frameTimer.setup_overflow_irq() && m_frameTimer.open() && m_frameTimer.start();
+}
+
+void LedController::onFrameTimer(timer_callback_args_t* args) {
+    (void)args;
+    s_frameTicks++;
+}
+#else
+bool LedController::startFrameTimer() {
+    return false;
+}
+#endif
+
+uint32_t LedController::currentFrame(uint32_t nowMillis) const {
+#if LED_FRAME_TIMER
+    if (m_frameTimerRunning) {
+        return s_frameTicks;
     }
+#endif
     
-    // Render
-    renderPosition(position);
-    m_needsUpdate = true;
+    // No timer: derive the same tick from millis()
+    return (uint32_t)((uint64_t)nowMillis * LED_FRAME_RATE_HZ / 1000);
 }
 
 // ============================================================================
-// SEQUENCE_COMPLETED Animation
+// Effects
 // ============================================================================
 
-// Animation phases for SEQUENCE_COMPLETED:
-// Phase 0: Quick flash all LEDs GREEN
-// Phase 1-3: Pulse effect (fade in/out)
-// Phase 4: Final solid green then off
-static const uint8_t SEQUENCE_ANIM_TOTAL_STEPS = 8;
-
-void LedController::startSequenceCompletedAnimation() {
-    m_sequenceAnimActive = true;
-    m_sequenceAnimStep = 0;
-    m_sequenceAnimLastTime = millis();
+bool LedController::playEffect(uint8_t effect, uint8_t position) {
+    const Effect* fx = Effects::get(effect);
+    if (!fx) {
+        return false;
+    }
+    
+    if (fx->target == EffectTarget::ALL) {
+        if (position != 255 || m_sequenceAnimActive) {
+            return false;
+        }
+        startOverlayEffect(effect, *fx);
+        return true;
+    }
     
-    // Initial state: all LEDs on GREEN
-    for (uint16_t i = 0; i < NUM_LEDS_STRIP1; i++) {
-        m_strip1.setPixelColor(i, m_strip1.Color(COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B));
+    if (position >= NUM_POSITIONS) {
+        return false;
     }
-    for (uint16_t i = 0; i < NUM_LEDS_STRIP2; i++) {
-        m_strip2.setPixelColor(i, m_strip2.Color(COLOR_SUCCESS_R, COLOR_SUCCESS_G, COLOR_SUCCESS_B));
+    
+    PositionData& data = m_positions[position];
+    EffectSample first = Effects::sample(*fx, 0);
+    data.state = PositionState::ANIMATING;
+    data.effect = effect;
+    data.startFrame = m_frame;
+    data.animationStep = first.radius;
+    data.color = first.color;
+    data.scaled = scaleColor(first.color);
+    m_frameDirty = true;
+    
+    return true;
+}
+
+void LedController::startOverlayEffect(uint8_t effect, const Effect& fx) {
+    m_overlayEffect = effect;
+    m_overlayEffectStart = m_frame;
+    setOverlay(Effects::sample(fx, 0).color);
+}
+
+bool LedController::isEffectPlaying(uint8_t position) const {
+    if (position == 255) {
+        return m_overlayEffect != NO_EFFECT;
     }
-    m_needsUpdate = true;
+    return position < NUM_POSITIONS && m_positions[position].state == PositionState::ANIMATING;
 }
 
-bool LedController::isSequenceCompletedAnimationComplete() const {
-    return !m_sequenceAnimActive;
+uint32_t LedController::memoryUsage() const {
+    uint32_t bytes = sizeof(*this) + sizeof(s_neoPixelOutput);
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC || STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC
+    bytes += sizeof(s_spiOutput);
+#endif
+    
+    // 3 bytes per pixel, allocated by begin()
+    return bytes + ((uint32_t)m_strip1.numPixels() + m_strip2.numPixels()) * 3;
 }
 
-void LedController::updateSequenceCompletedAnimation(uint32_t nowMillis) {
-    // Animation step duration (ms)
-    const uint16_t STEP_DURATION = 150;
+void LedController::updateAnimation(uint8_t position) {
+    PositionData& data = m_positions[position];
+    const Effect* fx = Effects::get(data.effect);
+    if (!fx) {
+        data.state = PositionState::OFF;
+        m_frameDirty = true;
+        return;
+    }
+    
+    EffectSample s = Effects::sample(*fx, m_frame - data.startFrame);
     
-    if (nowMillis - m_sequenceAnimLastTime < STEP_DURATION) {
+    // Finished: SUCCESS keeps its region lit, other effects clear it
+    if (s.done) {
+        data.state = fx->hold ? PositionState::EXPANDED : PositionState::OFF;
+        m_frameDirty = true;
+    }
+    
+    if (s.radius != data.animationStep || memcmp(&s.color, &data.color, sizeof(RgbColor)) != 0) {
+        data.animationStep = s.radius;
+        data.color = s.color;
+        data.scaled = scaleColor(s.color);
+        m_frameDirty = true;
+    }
+}
+
+void LedController::updateOverlayEffect() {
+    const Effect* fx = Effects::get(m_overlayEffect);
+    if (!fx) {
+        m_overlayEffect = NO_EFFECT;
         return;
     }
     
-    m_sequenceAnimStep++;
-    m_sequenceAnimLastTime = nowMillis;
+    EffectSample s = Effects::sample(*fx, m_frame - m_overlayEffectStart);
     
-    // Calculate brightness based on step (pulsing effect)
-    uint8_t brightness;
-    if (m_sequenceAnimStep < SEQUENCE_ANIM_TOTAL_STEPS) {
-        // Pulsing: alternate between full and half brightness
-        if (m_sequenceAnimStep % 2 == 0) {
-            brightness = 255;  // Full bright
-        } else {
-            brightness = 64;   // Dim
-        }
-        
-        // Apply color with calculated brightness
-        uint8_t r = (COLOR_SUCCESS_R * brightness) / 255;
-        uint8_t g = (COLOR_SUCCESS_G * brightness) / 255;
-        uint8_t b = (COLOR_SUCCESS_B * brightness) / 255;
-        
-        for (uint16_t i = 0; i < NUM_LEDS_STRIP1; i++) {
-            m_strip1.setPixelColor(i, m_strip1.Color(r, g, b));
-        }
-        for (uint16_t i = 0; i < NUM_LEDS_STRIP2; i++) {
-            m_strip2.setPixelColor(i, m_strip2.Color(r, g, b));
+    if (!s.done) {
+        if (memcmp(&s.color, &m_overlayColor, sizeof(RgbColor)) != 0) {
+            setOverlay(s.color);
         }
-        m_needsUpdate = true;
-    } else {
-        // Animation complete - turn off all LEDs
-        m_strip1.clear();
-        m_strip2.clear();
-        m_needsUpdate = true;
-        
-        // Reset all position states to OFF
+        return;
+    }
+    
+    // Effect complete - drop the overlay
+    m_overlayEffect = NO_EFFECT;
+    m_overlayActive = false;
+    m_frameDirty = true;
+    
+    // SEQUENCE_COMPLETED also ends the round: all positions off
+    if (m_sequenceAnimActive) {
         for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
             m_positions[i].state = PositionState::OFF;
             m_positions[i].animationStep = 0;
         }
-        
         m_sequenceAnimActive = false;
     }
 }
 
 // ============================================================================
-// Blink Animation
+// SEQUENCE_COMPLETED Animation
 // ============================================================================
 
-// Blink interval in milliseconds - fast blink to grab attention
-static const uint16_t BLINK_INTERVAL_MS = 150;
+// Green pulses on all LEDs (EFFECT_CELEBRATE, SEQUENCE_ANIM_STEPS fades of
+// SEQUENCE_STEP_FRAMES), then every position is turned off
+
+void LedController::startSequenceCompletedAnimation() {
+    // Restarts the celebration if it is already running
+    m_sequenceAnimActive = true;
+    startOverlayEffect(EFFECT_CELEBRATE, *Effects::get(EFFECT_CELEBRATE));
+}
 
-void LedController::updateBlinking(uint32_t nowMillis) {
-    // Update all blinking positions
+bool LedController::isSequenceCompletedAnimationComplete() const {
+    return !m_sequenceAnimActive;
+}
+
+// ============================================================================
+// Blink Animation
+// ============================================================================
+
+void LedController::updateBlinking() {
+    // One phase for all blinking positions, toggled every BLINK_FRAMES
+    bool on = ((m_frame / BLINK_FRAMES) & 1) == 0;
+    if (on == m_blinkOn) {
+        return;
+    }
+    m_blinkOn = on;
+    
+    // Only a visible change needs a new frame
     for (uint8_t i = 0; i < NUM_POSITIONS; i++) {
         if (m_positions[i].state == PositionState::BLINKING) {
-            PositionData& data = m_positions[i];
-            
-            // Check if enough time has passed to toggle
-            if (nowMillis - data.lastAnimationTime >= BLINK_INTERVAL_MS) {
-                data.blinkOn = !data.blinkOn;
-                data.lastAnimationTime = nowMillis;
-                
-                // Render the updated state
-                renderPosition(i);
-                m_needsUpdate = true;
-            }
+            m_frameDirty = true;
+            return;
         }
     }
 }
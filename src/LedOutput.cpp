@@ -0,0 +1,181 @@
+/**
+ * @file LedOutput.cpp
+ * @brief Implementation of the LED strip output backends
+ */
+
+#include "LedOutput.h"
+
+// ============================================================================
+// PrefixNeoPixel
+// ============================================================================
+
+void PrefixNeoPixel::showPrefix(uint16_t count) {
+    if (count >= numLEDs) {
+        show();
+        return;
+    }
+    
+    // show() clocks out numBytes - shorten it for this push only
+    uint16_t fullBytes = numBytes;
+    numBytes = count * bytesPerPixel();
+    show();
+    numBytes = fullBytes;
+}
+
+uint8_t PrefixNeoPixel::bytesPerPixel() const {
+    return numLEDs > 0 ? numBytes / numLEDs : 3;
+}
+
+// ============================================================================
+// NeoPixelOutput
+// ============================================================================
+
+void NeoPixelOutput::begin() {
+    // Pins are set up by Adafruit_NeoPixel::begin()
+}
+
+void NeoPixelOutput::show(PrefixNeoPixel& strip, uint16_t count) {
+    strip.showPrefix(count);
+}
+
+// ============================================================================
+// SpiDtcOutput
+// ============================================================================
+
+#if STRIP1_OUTPUT == LED_OUTPUT_SPI_DTC || STRIP2_OUTPUT == LED_OUTPUT_SPI_DTC
+
+#include "IRQManager.h"
+
+SpiDtcOutput::SpiDtcOutput()
+    : m_lengths{0, 0}
+    , m_transmitting(-1)
+    , m_queued(-1)
+{
+}
+
+void SpiDtcOutput::begin() {
+    // Route the MOSI pin to SPI0
+    R_IOPORT_PinCfg(&g_ioport_ctrl, digitalPinToBspPin(LED_SPI_MOSI_PIN),
+                    (uint32_t)(IOPORT_CFG_PERIPHERAL_PIN | IOPORT_PERIPHERAL_SPI));
+    
+    // DTC moves one byte into SPDR per transmit-buffer-empty interrupt
+    memset(&m_dtcInfo, 0, sizeof(m_dtcInfo));
+    m_dtcInfo.transfer_settings_word_b.dest_addr_mode = TRANSFER_ADDR_MODE_FIXED;
+    m_dtcInfo.transfer_settings_word_b.repeat_area = TRANSFER_REPEAT_AREA_SOURCE;
+    m_dtcInfo.transfer_settings_word_b.irq = TRANSFER_IRQ_END;
+    m_dtcInfo.transfer_settings_word_b.chain_mode = TRANSFER_CHAIN_MODE_DISABLED;
+    m_dtcInfo.transfer_settings_word_b.src_addr_mode = TRANSFER_ADDR_MODE_INCREMENTED;
+    m_dtcInfo.transfer_settings_word_b.size = TRANSFER_SIZE_1_BYTE;
+    m_dtcInfo.transfer_settings_word_b.mode = TRANSFER_MODE_NORMAL;
+    
+    m_dtcCfg.p_info = &m_dtcInfo;
+    m_dtcCfg.p_extend = &m_dtcExt;
+    m_dtc.p_ctrl = &m_dtcCtrl;
+    m_dtc.p_cfg = &m_dtcCfg;
+    m_dtc.p_api = &g_transfer_on_dtc;
+    
+    // Transmit-only master, MOSI held low between frames (= WS2812 reset)
+    memset(&m_spiExt, 0, sizeof(m_spiExt));
+    m_spiExt.spi_clksyn = SPI_SSL_MODE_CLK_SYN;
+    m_spiExt.spi_comm = SPI_COMMUNICATION_TRANSMIT_ONLY;
+    m_spiExt.ssl_polarity = SPI_SSLP_LOW;
+    m_spiExt.ssl_select = SPI_SSL_SELECT_SSL0;
+    m_spiExt.mosi_idle = SPI_MOSI_IDLE_VALUE_FIXING_LOW;
+    m_spiExt.parity = SPI_PARITY_MODE_DISABLE;
+    m_spiExt.byte_swap = SPI_BYTE_SWAP_DISABLE;
+    m_spiExt.spck_delay = SPI_DELAY_COUNT_1;
+    m_spiExt.ssl_negation_delay = SPI_DELAY_COUNT_1;
+    m_spiExt.next_access_delay = SPI_DELAY_COUNT_1;
+    R_SPI_CalculateBitrate(LED_SPI_CLOCK_HZ, &m_spiExt.spck_div);
+    
+    memset(&m_spiCfg, 0, sizeof(m_spiCfg));
+    m_spiCfg.channel = 0;
+    m_spiCfg.operating_mode = SPI_MODE_MASTER;
+    m_spiCfg.clk_phase = SPI_CLK_PHASE_EDGE_ODD;
+    m_spiCfg.clk_polarity = SPI_CLK_POLARITY_LOW;
+    m_spiCfg.mode_fault = SPI_MODE_FAULT_ERROR_DISABLE;
+    m_spiCfg.bit_order = SPI_BIT_ORDER_MSB_FIRST;
+    m_spiCfg.p_transfer_tx = &m_dtc;
+    m_spiCfg.p_transfer_rx = nullptr;
+    m_spiCfg.p_callback = &SpiDtcOutput::onSpiEvent;
+    m_spiCfg.p_context = this;
+    m_spiCfg.p_extend = &m_spiExt;
+    
+    // Allocate SPI interrupts, then trigger the DTC from transmit-empty
+    IRQManager::getInstance().addPeripheral(IRQ_SPI_MASTER, &m_spiCfg);
+    m_dtcExt.activation_source = m_spiCfg.txi_irq;
+    
+    R_SPI_Open(&m_spiCtrl, &m_spiCfg);
+}
+
+void SpiDtcOutput::show(PrefixNeoPixel& strip, uint16_t count) {
+    if (count > LED_SPI_STRIP_LEDS) {
+        count = LED_SPI_STRIP_LEDS;
+    }
+    
+    // Take the back buffer away from the ISR while it is rewritten
+    noInterrupts();
+    m_queued = -1;
+    int8_t back = (m_transmitting == 0) ? 1 : 0;
+    interrupts();
+    
+    m_lengths[back] = encode(strip.getPixels(), count * strip.bytesPerPixel(), m_buffers[back]);
+    
+    // Start now if idle, otherwise the completion callback picks it up
+    noInterrupts();
+    if (m_transmitting < 0) {
+        startTransfer(back);
+    } else {
+        m_queued = back;
+    }
+    interrupts();
+}
+
+bool SpiDtcOutput::isTransmitting() const {
+    return m_transmitting >= 0;
+}
+
+void SpiDtcOutput::startTransfer(int8_t buffer) {
+    m_transmitting = buffer;
+    if (R_SPI_Write(&m_spiCtrl, m_buffers[buffer], m_lengths[buffer], SPI_BIT_WIDTH_8_BITS) != FSP_SUCCESS) {
+        m_transmitting = -1;
+    }
+}
+
+uint16_t SpiDtcOutput::encode(const uint8_t* pixels, uint16_t numBytes, uint8_t* out) {
+    uint8_t* p = out;
+    
+    for (uint16_t i = 0; i < numBytes; i++) {
+        // 8 data bits -> 24 SPI bits, MSB first
+        uint32_t bits = 0;
+        for (uint8_t b = 0; b < 8; b++) {
+            bits = (bits << 3) | ((pixels[i] & (0x80 >> b)) ? 0x6 : 0x4);
+        }
+        *p++ = (uint8_t)(bits >> 16);
+        *p++ = (uint8_t)(bits >> 8);
+        *p++ = (uint8_t)bits;
+    }
+    
+    // Reset gap so a queued frame can follow back-to-back
+    memset(p, 0, LED_SPI_RESET_BYTES);
+    p += LED_SPI_RESET_BYTES;
+    
+    return (uint16_t)(p - out);
+}
+
+void SpiDtcOutput::onSpiEvent(spi_callback_args_t* args) {
+    if (args->event != SPI_EVENT_TRANSFER_COMPLETE) {
+        return;
+    }
+    
+    SpiDtcOutput* self = static_cast<SpiDtcOutput*>(const_cast<void*>(args->p_context));
+    int8_t next = self->m_queued;
+    self->m_queued = -1;
+    self->m_transmitting = -1;
+    
+    if (next >= 0) {
+        self->startTransfer(next);
+    }
+}
+
+#endif // LED_OUTPUT_SPI_DTC
@@ -0,0 +1,99 @@
+/**
+ * @file MemoryReport.cpp
+ * @brief Implementation of the RAM usage report
+ */
+
+#include "MemoryReport.h"
+
+#if defined(__arm__)
+#include <unistd.h>
+
+// Linker script symbols (FSP fsp.ld)
+extern "C" uint32_t __StackLimit;
+extern "C" uint32_t __StackTop;
+extern "C" char __HeapLimit;
+#define MEMORY_REPORT_TARGET 1
+#else
+#define MEMORY_REPORT_TARGET 0
+#endif
+
+// Written over the unused stack by begin()
+static constexpr uint32_t STACK_PAINT = 0xA5A5A5A5UL;
+
+static uint32_t s_componentBytes[MEMORY_COMPONENT_COUNT];
+
+static const char* const COMPONENT_NAMES[MEMORY_COMPONENT_COUNT] = {
+    "led", "touch", "cmd", "event", "store", "mockpi"
+};
+
+/**
+ * @brief Get the current stack pointer
+ * @return Address of the current frame
+ */
+static inline uintptr_t stackPointer() {
+    return (uintptr_t)__builtin_frame_address(0);
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void MemoryReport::begin() {
+#if MEMORY_REPORT_TARGET
+    uint32_t* word = &__StackLimit;
+    uint32_t* end = (uint32_t*)(stackPointer() - STACK_PAINT_MARGIN);
+    while (word < end) {
+        *word++ = STACK_PAINT;
+    }
+#endif
+}
+
+void MemoryReport::setComponent(MemoryComponent component, uint32_t bytes) {
+    uint8_t i = static_cast<uint8_t>(component);
+    if (i < MEMORY_COMPONENT_COUNT) {
+        s_componentBytes[i] = bytes;
+    }
+}
+
+uint32_t MemoryReport::componentBytes(MemoryComponent component) {
+    uint8_t i = static_cast<uint8_t>(component);
+    return i < MEMORY_COMPONENT_COUNT ? s_componentBytes[i] : 0;
+}
+
+const char* MemoryReport::componentName(MemoryComponent component) {
+    uint8_t i = static_cast<uint8_t>(component);
+    return i < MEMORY_COMPONENT_COUNT ? COMPONENT_NAMES[i] : "?";
+}
+
+uint32_t MemoryReport::freeStack() {
+#if MEMORY_REPORT_TARGET
+    uintptr_t limit = (uintptr_t)&__StackLimit;
+    uintptr_t sp = stackPointer();
+    return sp > limit ? (uint32_t)(sp - limit) : 0;
+#else
+    return 0;
+#endif
+}
+
+uint32_t MemoryReport::minFreeStack() {
+#if MEMORY_REPORT_TARGET
+    // The stack grows down, so untouched paint starts at the limit
+    const uint32_t* word = &__StackLimit;
+    const uint32_t* top = &__StackTop;
+    while (word < top && *word == STACK_PAINT) {
+        word++;
+    }
+    return (uint32_t)((uintptr_t)word - (uintptr_t)&__StackLimit);
+#else
+    return 0;
+#endif
+}
+
+uint32_t MemoryReport::freeHeap() {
+#if MEMORY_REPORT_TARGET
+    char* top = (char*)sbrk(0);
+    return top < &__HeapLimit ? (uint32_t)(&__HeapLimit - top) : 0;
+#else
+    return 0;
+#endif
+}
@@ -10,6 +10,7 @@
 #include "MockPiPrograms.h"
 #include "TouchController.h"
 #include "CommandController.h"
+#include "EventQueue.h"
 #include <stdarg.h>
 
 // ============================================================================
@@ -38,9 +39,21 @@ MockPiPrograms::MockPiPrograms()
     , m_twoHandCleanupIndex(0)
     , m_waitingForAck(false)
     , m_pendingCommands(0)
+    , m_eventQueue(nullptr)
+    , m_stressConfig(MOCK_PI_STRESS_DEFAULTS)
+    , m_stressRandom(1)
+    , m_stressStartTime(0)
+    , m_stressLastReport(0)
+    , m_stressNextCommandUs(0)
+    , m_stressNextTouchUs(0)
+    , m_stressDroppedBase(0)
+    , m_stressHeld(0)
+    , m_stressWindowMaxUs(0)
 {
     m_recordedSequence[0] = '\0';
     m_twoHandPositions[0] = '\0';
+    memset(&m_stressStats, 0, sizeof(m_stressStats));
+    memset(&m_stressReported, 0, sizeof(m_stressReported));
 }
 
 // ============================================================================
@@ -63,6 +76,12 @@ void MockPiPrograms::update() {
         return;
     }
     
+    // The stress program has its own loop and doesn't follow touches
+    if (m_program == MockPiProgram::STRESS) {
+        updateStress();
+        return;
+    }
+    
     // Poll touch state directly from TouchController (if available)
     pollTouchState();
     
@@ -75,17 +94,11 @@ void MockPiPrograms::pollTouchState() {
         return;
     }
     
-    // Build current touch mask by polling all sensors
-    uint32_t newTouched = 0;
-    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        if (m_touchController->isTouched(i)) {
-            newTouched |= (1UL << i);
-        }
-    }
-    
-    // Detect edges
-    uint32_t justPressed = newTouched & ~m_previousTouched;
-    uint32_t justReleased = m_previousTouched & ~newTouched;
+    // Take debounced state and edges since the last poll
+    uint32_t newTouched = m_touchController->getTouchedMask();
+    uint32_t justPressed;
+    uint32_t justReleased;
+    m_touchController->getEdgeMasks(justPressed, justReleased);
     
     // Process touch down events
     for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
@@ -273,7 +286,53 @@ void MockPiPrograms::startTwoHandSequence(const char* positions) {
     logf("MockPi: Starting two-hand sequence with %d positions", m_twoHandCount);
 }
 
+void MockPiPrograms::startStress(const MockPiStressConfig& config) {
+    if (!m_commandController) {
+        log("MockPi: Error - stress needs a command controller");
+        return;
+    }
+    
+    if (m_program == MockPiProgram::STRESS) {
+        endStress();
+    }
+    
+    m_stressConfig = config;
+    if (m_stressConfig.reportIntervalMs == 0) {
+        m_stressConfig.reportIntervalMs = MOCK_PI_STRESS_DEFAULTS.reportIntervalMs;
+    }
+    m_stressRandom = config.seed ? config.seed : 1;  // xorshift never leaves 0
+    
+    memset(&m_stressStats, 0, sizeof(m_stressStats));
+    memset(&m_stressReported, 0, sizeof(m_stressReported));
+    for (uint8_t i = 0; i < MOCK_PI_STRESS_TRACKED; i++) {
+        m_stressIds[i] = NO_COMMAND_ID;
+    }
+    m_stressHeld = 0;
+    m_stressWindowMaxUs = 0;
+    
+    uint32_t nowUs = micros();
+    m_stressStartTime = millis();
+    m_stressLastReport = m_stressStartTime;
+    m_stressNextCommandUs = nowUs;
+    m_stressNextTouchUs = nowUs;
+    
+    if (m_eventQueue) {
+        m_stressDroppedBase = m_eventQueue->getDroppedCount();
+        m_eventQueue->setMonitor(&MockPiPrograms::onEventLine, this);
+    }
+    
+    m_program = MockPiProgram::STRESS;
+    transitionTo(MockPiState::STRESS);
+    
+    logf("MockPi: Stress %u cmd/s (led %u, expect %u, ping %u), %u touches/s",
+         config.commandsPerSecond, config.ledWeight, config.expectWeight,
+         config.pingWeight, config.touchesPerSecond);
+}
+
 void MockPiPrograms::stop() {
+    if (m_program == MockPiProgram::STRESS) {
+        endStress();
+    }
     m_program = MockPiProgram::NONE;
     m_state = MockPiState::IDLE;
     m_stepTouchedMask = 0;
@@ -286,6 +345,266 @@ bool MockPiPrograms::isRunning() const {
     return m_program != MockPiProgram::NONE && m_state != MockPiState::IDLE;
 }
 
+// ============================================================================
+// Private Methods - Stress Program
+// ============================================================================
+
+void MockPiPrograms::updateStress() {
+    uint32_t now = millis();
+    uint32_t nowUs = micros();
+    
+    // Release simulated touches that were held long enough
+    uint32_t held = m_stressHeld;
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        if ((held & (1UL << i)) && (int32_t)(now - m_stressReleaseTime[i]) >= 0) {
+            held &= ~(1UL << i);
+        }
+    }
+    if (held != m_stressHeld) {
+        m_stressHeld = held;
+        if (m_touchController) {
+            m_touchController->setSimulatedTouches(held);
+        }
+    }
+    
+    // Commands on schedule; if the loop can't keep up, skip the missed slots
+    if (m_stressConfig.commandsPerSecond > 0) {
+        uint32_t intervalUs = 1000000UL / m_stressConfig.commandsPerSecond;
+        uint8_t burst = 0;
+        while ((int32_t)(nowUs - m_stressNextCommandUs) >= 0 && burst < MOCK_PI_STRESS_MAX_BURST) {
+            sendStressCommand(now);
+            m_stressNextCommandUs += intervalUs;
+            burst++;
+        }
+        if ((int32_t)(nowUs - m_stressNextCommandUs) >= 0) {
+            uint32_t missed = (nowUs - m_stressNextCommandUs) / intervalUs + 1;
+            m_stressStats.behind += missed;
+            m_stressNextCommandUs += missed * intervalUs;
+        }
+    }
+    
+    // Extra touches on their own schedule
+    if (m_stressConfig.touchesPerSecond > 0 && (int32_t)(nowUs - m_stressNextTouchUs) >= 0) {
+        startStressTouch(now, 255);
+        m_stressNextTouchUs = nowUs + 1000000UL / m_stressConfig.touchesPerSecond;
+    }
+    
+    if (now - m_stressLastReport >= m_stressConfig.reportIntervalMs) {
+        expireStressReplies(micros());  // After this update's commands were stamped
+        reportStress(false);
+    }
+    
+    if (m_stressConfig.durationMs > 0 && now - m_stressStartTime >= m_stressConfig.durationMs) {
+        endStress();
+        m_program = MockPiProgram::NONE;
+        transitionTo(MockPiState::IDLE);
+    }
+}
+
+void MockPiPrograms::sendStressCommand(uint32_t now) {
+    static const char* const LED_ACTIONS[] = { "SHOW", "HIDE", "BLINK", "STOP_BLINK" };
+    
+    uint16_t total = m_stressConfig.ledWeight + m_stressConfig.expectWeight + m_stressConfig.pingWeight;
+    if (total == 0) {
+        return;
+    }
+    
+    uint32_t id = m_commandId++;
+    uint16_t pick = nextStressRandom() % total;
+    uint8_t position = nextStressRandom() % NUM_TOUCH_SENSORS;
+    bool expect = false;
+    char buf[32];
+    
+    if (pick < m_stressConfig.ledWeight) {
+        snprintf(buf, sizeof(buf), "%s %c #%lu", LED_ACTIONS[nextStressRandom() % 4],
+                 indexToLetter(position), (unsigned long)id);
+    } else if (pick < m_stressConfig.ledWeight + m_stressConfig.expectWeight) {
+        snprintf(buf, sizeof(buf), "EXPECT_DOWN %c #%lu", indexToLetter(position), (unsigned long)id);
+        expect = true;
+    } else {
+        snprintf(buf, sizeof(buf), "PING #%lu", (unsigned long)id);
+    }
+    
+    m_commandController->injectCommand(buf);
+    m_stressStats.sent++;
+    
+    // The expectation is armed once injectCommand() returns, so touch it now
+    if (expect) {
+        startStressTouch(now, position);
+    }
+    
+    // Track the reply; an older command still in the slot never got one
+    uint8_t slot = id % MOCK_PI_STRESS_TRACKED;
+    if (m_stressIds[slot] != NO_COMMAND_ID) {
+        m_stressStats.lost++;
+    }
+    m_stressIds[slot] = id;
+    m_stressSentUs[slot] = micros();
+}
+
+bool MockPiPrograms::startStressTouch(uint32_t now, uint8_t preferred) {
+    if (!m_touchController) {
+        return false;
+    }
+    
+    uint32_t free = m_touchController->getActiveSensorMask() & ~m_stressHeld;
+    if (preferred != 255) {
+        free &= 1UL << preferred;
+    }
+    if (free == 0) {
+        return false;
+    }
+    
+    // Random free position: skip a random number of candidates
+    uint8_t candidates = 0;
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        if (free & (1UL << i)) {
+            candidates++;
+        }
+    }
+    uint8_t skip = nextStressRandom() % candidates;
+    uint8_t position = 0;
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        if ((free & (1UL << i)) && skip-- == 0) {
+            position = i;
+            break;
+        }
+    }
+    
+    m_stressHeld |= 1UL << position;
+    m_stressReleaseTime[position] = now + MOCK_PI_STRESS_HOLD_MS;
+    m_touchController->setSimulatedTouches(m_stressHeld);
+    m_stressStats.touches++;
+    return true;
+}
+
+void MockPiPrograms::onStressLine(const char* line) {
+    uint32_t nowUs = micros();
+    m_stressStats.lines++;
+    m_stressStats.bytes += strlen(line) + 2;
+    
+    if (strncmp(line, "ARDUINO> ", 9) == 0) {
+        line += 9;
+    }
+    
+    if (strncmp(line, "TOUCH", 5) == 0) {
+        m_stressStats.touchEvents++;  // TOUCH_DOWN/UP and TOUCHED_DOWN/UP
+    } else if (strncmp(line, "ERR ", 4) == 0) {
+        if (strncmp(line + 4, "busy", 4) == 0) {
+            m_stressStats.busy++;
+        } else {
+            m_stressStats.errors++;
+        }
+    }
+    
+    // First reply carrying a tracked ID
+    const char* hash = strrchr(line, '#');
+    if (!hash) {
+        return;
+    }
+    uint32_t id = strtoul(hash + 1, nullptr, 10);
+    uint8_t slot = id % MOCK_PI_STRESS_TRACKED;
+    if (m_stressIds[slot] != id) {
+        return;
+    }
+    m_stressIds[slot] = NO_COMMAND_ID;
+    
+    uint32_t latencyUs = nowUs - m_stressSentUs[slot];
+    m_stressStats.replies++;
+    m_stressStats.latencySumUs += latencyUs;
+    if (latencyUs > m_stressStats.latencyMaxUs) {
+        m_stressStats.latencyMaxUs = latencyUs;
+    }
+    if (latencyUs > m_stressWindowMaxUs) {
+        m_stressWindowMaxUs = latencyUs;
+    }
+}
+
+void MockPiPrograms::expireStressReplies(uint32_t nowUs) {
+    for (uint8_t i = 0; i < MOCK_PI_STRESS_TRACKED; i++) {
+        if (m_stressIds[i] != NO_COMMAND_ID &&
+            nowUs - m_stressSentUs[i] >= MOCK_PI_ACK_TIMEOUT_MS * 1000UL) {
+            m_stressIds[i] = NO_COMMAND_ID;
+            m_stressStats.lost++;
+        }
+    }
+}
+
+void MockPiPrograms::reportStress(bool final) {
+    uint32_t now = millis();
+    if (m_eventQueue) {
+        m_stressStats.dropped = m_eventQueue->getDroppedCount() - m_stressDroppedBase;
+    }
+    
+    // Rates over the window (whole run for the summary)
+    MockPiStressStats none;
+    memset(&none, 0, sizeof(none));
+    const MockPiStressStats& from = final ? none : m_stressReported;
+    uint32_t windowMs = final ? now - m_stressStartTime : now - m_stressLastReport;
+    if (windowMs == 0) {
+        windowMs = 1;
+    }
+    
+    uint32_t replies = m_stressStats.replies - from.replies;
+    uint32_t avgUs = replies ? (uint32_t)((m_stressStats.latencySumUs - from.latencySumUs) / replies) : 0;
+    uint32_t maxUs = final ? m_stressStats.latencyMaxUs : m_stressWindowMaxUs;
+    
+    char buf[200];
+    snprintf(buf, sizeof(buf),
+             "MockPi: STRESS%s t=%lus cmd/s=%lu reply/s=%lu event/s=%lu touch/s=%lu tx=%luB/s "
+             "reply_us avg=%lu max=%lu",
+             final ? " DONE" : "", (unsigned long)((now - m_stressStartTime) / 1000),
+             (unsigned long)((m_stressStats.sent - from.sent) * 1000UL / windowMs),
+             (unsigned long)(replies * 1000UL / windowMs),
+             (unsigned long)((m_stressStats.lines - from.lines) * 1000UL / windowMs),
+             (unsigned long)((m_stressStats.touchEvents - from.touchEvents) * 1000UL / windowMs),
+             (unsigned long)((m_stressStats.bytes - from.bytes) * 1000UL / windowMs),
+             (unsigned long)avgUs, (unsigned long)maxUs);
+    log(buf);
+    
+    snprintf(buf, sizeof(buf),
+             "MockPi: STRESS totals sent=%lu replies=%lu lost=%lu busy=%lu err=%lu dropped=%lu behind=%lu",
+             (unsigned long)m_stressStats.sent, (unsigned long)m_stressStats.replies,
+             (unsigned long)m_stressStats.lost, (unsigned long)m_stressStats.busy,
+             (unsigned long)m_stressStats.errors, (unsigned long)m_stressStats.dropped,
+             (unsigned long)m_stressStats.behind);
+    log(buf);
+    
+    m_stressReported = m_stressStats;
+    m_stressLastReport = now;
+    m_stressWindowMaxUs = 0;
+}
+
+void MockPiPrograms::endStress() {
+    expireStressReplies(micros());
+    reportStress(true);
+    
+    m_stressHeld = 0;
+    if (m_touchController) {
+        m_touchController->setSimulatedTouches(0);
+    }
+    if (m_eventQueue) {
+        m_eventQueue->setMonitor(nullptr, nullptr);
+    }
+}
+
+uint32_t MockPiPrograms::nextStressRandom() {
+    // xorshift32
+    uint32_t x = m_stressRandom;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_stressRandom = x;
+    return x;
+}
+
+void MockPiPrograms::onEventLine(const char* line, void* context) {
+    MockPiPrograms* self = static_cast<MockPiPrograms*>(context);
+    if (self->m_program == MockPiProgram::STRESS) {
+        self->onStressLine(line);
+    }
+}
+
 // ============================================================================
 // Private Methods - Touch Event Handlers
 // ============================================================================
@@ -363,8 +682,8 @@ void MockPiPrograms::onTouchUp(char position) {
 
 void MockPiPrograms::sendCommand(const char* cmd) {
     // Log the command for visibility in serial monitor
-    Serial.print("PI> ");
-    Serial.println(cmd);
+    PI_SERIAL.print("PI> ");
+    PI_SERIAL.println(cmd);
     
     // If we have a CommandController reference, use injectCommand for direct execution
     if (m_commandController) {
@@ -0,0 +1,71 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementation of the loop profiler (only built with ENABLE_PROFILER)
+ */
+
+#include "Profiler.h"
+
+#if ENABLE_PROFILER
+
+// Per-stage statistics since the last reset()
+static ProfileStat s_stats[PROFILE_STAGE_COUNT];
+
+// Loop rate measurement
+static constexpr uint16_t LOOP_RATE_WINDOW_MS = 1000;
+static uint32_t s_loopWindowStart = 0;
+static uint32_t s_loopWindowCount = 0;
+static uint32_t s_loopRate = 0;
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "loop", "serial", "lines", "commands", "touch", "leds", "flush", "i2c", "show", "touch_latency"
+};
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void Profiler::record(ProfileStage stage, uint32_t us) {
+    ProfileStat& s = s_stats[static_cast<uint8_t>(stage)];
+    
+    if (s.count == 0 || us < s.minUs) {
+        s.minUs = us;
+    }
+    if (us > s.maxUs) {
+        s.maxUs = us;
+    }
+    s.totalUs += us;
+    s.count++;
+    
+    if (stage == ProfileStage::LOOP) {
+        s_loopWindowCount++;
+        uint32_t now = millis();
+        if (now - s_loopWindowStart >= LOOP_RATE_WINDOW_MS) {
+            s_loopRate = s_loopWindowCount * 1000UL / (now - s_loopWindowStart);
+            s_loopWindowStart = now;
+            s_loopWindowCount = 0;
+        }
+    }
+}
+
+ProfileStat Profiler::peek(ProfileStage stage) {
+    return s_stats[static_cast<uint8_t>(stage)];
+}
+
+void Profiler::reset(ProfileStage stage) {
+    s_stats[static_cast<uint8_t>(stage)] = ProfileStat{0, 0, 0, 0};
+}
+
+uint32_t Profiler::loopRate() {
+    return s_loopRate;
+}
+
+const char* Profiler::stageName(ProfileStage stage) {
+    uint8_t i = static_cast<uint8_t>(stage);
+    return i < PROFILE_STAGE_COUNT ? STAGE_NAMES[i] : "?";
+}
+
+void Profiler::touchSent(uint32_t edgeUs) {
+    record(ProfileStage::TOUCH_LATENCY, micros() - edgeUs);
+}
+
+#endif // ENABLE_PROFILER
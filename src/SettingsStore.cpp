@@ -0,0 +1,150 @@
+/**
+ * @file SettingsStore.cpp
+ * @brief Implementation of the settings record in EEPROM
+ */
+
+#include "SettingsStore.h"
+#include <EEPROM.h>
+
+// Record header
+static constexpr uint8_t SETTINGS_MAGIC0 = 'L';
+static constexpr uint8_t SETTINGS_MAGIC1 = 'T';
+static constexpr uint8_t SETTINGS_VERSION = 2;
+static constexpr uint8_t SETTINGS_HEADER_LEN = 4;   // Magic (2), version, payload length
+
+static_assert(sizeof(StoredSettings) <= 255, "Payload length is stored in one byte");
+
+// ============================================================================
+// Constructor
+// ============================================================================
+
+SettingsStore::SettingsStore()
+    : m_loaded(false)
+    , m_dirty(false)
+    , m_dirtyTime(0)
+{
+    setDefaults();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool SettingsStore::begin() {
+    setDefaults();
+    m_loaded = false;
+    m_dirty = false;
+
+    uint16_t address = SETTINGS_EEPROM_ADDRESS;
+    uint8_t header[SETTINGS_HEADER_LEN];
+    for (uint8_t i = 0; i < SETTINGS_HEADER_LEN; i++) {
+        header[i] = EEPROM.read(address++);
+    }
+
+    if (header[0] != SETTINGS_MAGIC0 || header[1] != SETTINGS_MAGIC1 ||
+        header[2] != SETTINGS_VERSION || header[3] != sizeof(StoredSettings)) {
+        return false;
+    }
+
+    StoredSettings stored;
+    uint8_t* bytes = (uint8_t*)&stored;
+    for (uint8_t i = 0; i < sizeof(StoredSettings); i++) {
+        bytes[i] = EEPROM.read(address++);
+    }
+
+    uint8_t crc = checksum(header, sizeof(header));
+    crc = checksum(bytes, sizeof(StoredSettings), crc);
+    if (EEPROM.read(address) != crc) {
+        return false;
+    }
+
+    m_settings = stored;
+    m_loaded = true;
+    return true;
+}
+
+bool SettingsStore::isLoaded() const {
+    return m_loaded;
+}
+
+StoredSettings& SettingsStore::settings() {
+    return m_settings;
+}
+
+const StoredSettings& SettingsStore::settings() const {
+    return m_settings;
+}
+
+uint16_t SettingsStore::commit() {
+    const uint8_t header[SETTINGS_HEADER_LEN] = {
+        SETTINGS_MAGIC0, SETTINGS_MAGIC1, SETTINGS_VERSION, (uint8_t)sizeof(StoredSettings)
+    };
+    const uint8_t* bytes = (const uint8_t*)&m_settings;
+
+    uint8_t crc = checksum(header, sizeof(header));
+    crc = checksum(bytes, sizeof(StoredSettings), crc);
+
+    uint16_t address = SETTINGS_EEPROM_ADDRESS;
+    uint16_t written = 0;
+
+    // Write the payload before the header so a reset mid-way leaves a bad checksum
+    for (uint8_t i = 0; i < sizeof(StoredSettings); i++) {
+        uint16_t at = address + SETTINGS_HEADER_LEN + i;
+        if (EEPROM.read(at) != bytes[i]) {
+            EEPROM.write(at, bytes[i]);
+            written++;
+        }
+    }
+
+    uint16_t crcAddress = address + SETTINGS_HEADER_LEN + sizeof(StoredSettings);
+    if (EEPROM.read(crcAddress) != crc) {
+        EEPROM.write(crcAddress, crc);
+        written++;
+    }
+
+    for (uint8_t i = 0; i < SETTINGS_HEADER_LEN; i++) {
+        if (EEPROM.read(address + i) != header[i]) {
+            EEPROM.write(address + i, header[i]);
+            written++;
+        }
+    }
+
+    m_loaded = true;
+    m_dirty = false;
+    return written;
+}
+
+void SettingsStore::markDirty() {
+    m_dirty = true;
+    m_dirtyTime = millis();
+}
+
+bool SettingsStore::isDirty() const {
+    return m_dirty;
+}
+
+bool SettingsStore::isCommitDue(uint32_t now) const {
+    return m_dirty && now - m_dirtyTime >= SETTINGS_COMMIT_DELAY_MS;
+}
+
+uint8_t SettingsStore::checksum(const uint8_t* data, size_t length, uint8_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void SettingsStore::setDefaults() {
+    memset(&m_settings, 0, sizeof(m_settings));
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        m_settings.sensitivity[i] = DEFAULT_SENSITIVITY;
+        m_settings.threshold[i] = DEFAULT_TOUCH_THRESHOLD;
+    }
+}
@@ -4,10 +4,111 @@
  * 
  * Protocol v2: Always polls sensors, emits TOUCH_DOWN/TOUCH_UP events
  * with debouncing for reliable detection.
+ * 
+ * Debounce uses 2-bit vertical counters: bit i of m_debounceCount0/1 form
+ * the counter of sensor i. A counter runs while the raw state differs from
+ * the debounced state and resets as soon as they agree, so a change is
+ * accepted on the DEBOUNCE_SAMPLES-th consecutive sample.
+ * 
+ * With TOUCH_DEBOUNCE_ADAPTIVE a change on a settled sensor is accepted
+ * on its first sample instead, and the sensor then ignores further changes
+ * for a lockout window. Bounces (raw flips during a lockout, or a raw
+ * change that goes back before it was accepted) raise the sensor's noise
+ * estimate, which lengthens its lockout and eventually makes it wait for
+ * the counters again. Lockouts without a bounce lower it.
  */
 
 #include "TouchController.h"
 #include "EventQueue.h"
+#include "SettingsStore.h"
+
+static_assert(TOUCH_ALERT_GROUP_COUNT <= 4, "At most 4 ALERT groups are supported");
+static_assert(NUM_TOUCH_SENSORS <= 32, "Sweep masks are 32 bits wide");
+static_assert(DEBOUNCE_SAMPLES == 4, "Vertical debounce counters are 2 bits wide");
+
+// Least time between two debounce steps of a sensor (us). Below
+// TOUCH_POLL_INTERVAL_MS so idle sensors, read once per interval, step on
+// every read despite millis() jitter.
+static constexpr uint32_t DEBOUNCE_STEP_US = TOUCH_POLL_INTERVAL_MS * 1000UL - TOUCH_HOT_POLL_INTERVAL_MS * 500UL;
+
+// Index of the lowest set bit (mask must be non-zero)
+static uint8_t lowestBit(uint32_t mask) {
+    uint8_t i = 0;
+    while (!(mask & (1UL << i))) {
+        i++;
+    }
+    return i;
+}
+
+// Sensitivity register value for a level: DELTA_SENSE in bits 6:4, base shift 0
+static uint8_t sensitivityRegister(uint8_t level) {
+    return (level & 0x07) << 4;
+}
+
+// Lockout length for a noise estimate (DEBOUNCE_LOCKOUT_MIN..MAX_SAMPLES)
+static uint8_t lockoutSamples(uint8_t noise) {
+    return DEBOUNCE_LOCKOUT_MIN_SAMPLES +
+           (uint16_t)noise * (DEBOUNCE_LOCKOUT_MAX_SAMPLES - DEBOUNCE_LOCKOUT_MIN_SAMPLES) / DEBOUNCE_NOISE_MAX;
+}
+
+// Kinds of queued I2C transactions (I2cTransaction::kind)
+enum TouchI2cKind : uint8_t {
+    KIND_STATUS = 0,    // Sensor input status read
+    KIND_CLEAR_INT,     // INT bit clear in main control
+    KIND_RECALIBRATE,   // Calibration trigger write
+    KIND_CAL_STATUS,    // Calibration active read (bits clear when done)
+    KIND_INIT,          // Chip init register access (boot)
+    KIND_CONFIG         // Sensitivity / threshold write
+};
+
+// Where a chip init step takes the value it writes from
+enum ChipInitValue : uint8_t {
+    INIT_FIXED = 0,     // ChipInitStep::value
+    INIT_INPUTS,        // The chip's inputMask
+    INIT_SENSITIVITY,   // Sensitivity register for the chip's setting
+    INIT_THRESHOLD      // Per-input threshold (one write per mapped input)
+};
+
+// One register of the chip init, applied to every chip before the next
+struct ChipInitStep {
+    I2cOp op;
+    uint8_t reg;
+    uint8_t value;        // WRITE: value, CLEAR_BITS: mask
+    ChipInitValue source; // Where the written value comes from
+    bool alertOnly;       // Only with TOUCH_ALERT_ENABLED
+    bool required;        // A chip that fails this step is not used
+};
+
+static const ChipInitStep CHIP_INIT_STEPS[] = {
+    // Enable only the inputs that are mapped to positions (a missing chip NACKs here)
+    { I2cOp::WRITE, CAP1188_REG_SENSOR_INPUT_ENABLE, 0, INIT_INPUTS, false, true },
+    
+    // Default config blocks more than one simultaneous touch per chip
+    { I2cOp::WRITE, CAP1188_REG_MULTIPLE_TOUCH_CONFIG, 0x00, INIT_FIXED, false, true },
+    
+    // Raise ALERT for mapped inputs, once per touch/release (no repeat while held)
+    { I2cOp::WRITE, CAP1188_REG_INTERRUPT_ENABLE, 0, INIT_INPUTS, true, true },
+    { I2cOp::WRITE, CAP1188_REG_REPEAT_RATE_ENABLE, 0x00, INIT_FIXED, true, true },
+    
+    // Stored (or default) sensitivity and thresholds
+    { I2cOp::WRITE, CAP1188_REG_SENSITIVITY_CONTROL, 0, INIT_SENSITIVITY, false, true },
+    { I2cOp::WRITE, CAP1188_REG_SENSOR_THRESHOLD_1, 0, INIT_THRESHOLD, false, true },
+    
+    // Clear any pending interrupts, then the INT flag in main control
+    { I2cOp::READ, CAP1188_REG_SENSOR_INPUT_STATUS, 0, INIT_FIXED, false, false },
+    { I2cOp::CLEAR_BITS, CAP1188_REG_MAIN_CONTROL, CAP1188_MAIN_CONTROL_INT, INIT_FIXED, false, false }
+};
+
+// ============================================================================
+// ALERT Interrupt Handlers
+// ============================================================================
+
+volatile uint8_t TouchController::s_pendingAlertGroups = 0;
+
+template <uint8_t Group>
+void TouchController::onAlert() {
+    s_pendingAlertGroups |= (1 << Group);
+}
 
 // ============================================================================
 // Constructor
@@ -15,16 +116,64 @@
 
 TouchController::TouchController()
     : m_eventQueue(nullptr)
+    , m_eventSource(EventSource::LOOP)
+    , m_settings(nullptr)
+    , m_activeMask(0)
+    , m_rawMask(0)
+    , m_debouncedMask(0)
+    , m_reportedMask(0)
+    , m_simulatedMask(0)
+    , m_debounceCount0(0)
+    , m_debounceCount1(0)
+    , m_lastRawMask(0)
+    , m_settledMask(0xFFFFFFFFUL)
+    , m_lockedMask(0)
+    , m_bouncedMask(0)
+    , m_noisyMask(0)
+    , m_pressedEdges(0)
+    , m_releasedEdges(0)
+    , m_chipCount(0)
     , m_lastPollTime(0)
+    , m_lastSweepTime(0)
+    , m_sweepPending(0)
+    , m_sweepPositions(0)
+    , m_readsPerPoll(2)
+    , m_hotCursor(0)
+    , m_idleCursor(0)
+    , m_sweepActive(false)
+    , m_sweepStartUs(0)
     , m_activeSensorCount(0)
+    , m_clockStep(I2C_CLOCK_STEP_COUNT - 1)
+    , m_bootClockStep(I2C_CLOCK_STEP_COUNT - 1)
+    , m_windowErrors(0)
+    , m_windowStart(0)
+    , m_cleanWindows(0)
+    , m_lastRecovery(0)
+    , m_recoveryBackoff(I2C_RECOVERY_BACKOFF_MS)
+    , m_offlineChips(0)
+    , m_lastReprobe(0)
+    , m_reprobeCursor(0)
+    , m_calWrites(0)
+    , m_calPending(0)
+    , m_calPolls(0)
+    , m_calInFlight(0)
+    , m_calStale(0)
+    , m_calFailed(0)
+    , m_lastCalPoll(0)
 {
     // Initialize all sensor states
     for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        m_sensors[i].active = false;
-        m_sensors[i].currentTouched = false;
-        m_sensors[i].debouncedTouched = false;
-        m_sensors[i].lastReportedTouched = false;
-        m_sensors[i].lastChangeTime = 0;
+        m_sensorChip[i] = 0;
+        
+        m_busHealth[i].nackCount = 0;
+        m_busHealth[i].timeoutCount = 0;
+        m_busHealth[i].nackRun = 0;
+        m_edgeUs[i] = 0;
+        m_lockLeft[i] = 0;
+        m_noise[i] = 0;
+        m_stepUs[i] = 0;
+        m_calInputs[i] = 0;
+        m_calDeadline[i] = 0;
         
         // Initialize expectation states
         m_expectDown[i].active = false;
@@ -42,35 +191,110 @@ void TouchController::setEventQueue(EventQueue* eventQueue) {
     m_eventQueue = eventQueue;
 }
 
+void TouchController::setSettingsStore(SettingsStore* settings) {
+    m_settings = settings;
+}
+
 bool TouchController::begin() {
-    // Initialize I2C
-    Wire.begin();
-    Wire.setClock(I2C_CLOCK_SPEED);
+    // Initialize I2C. A bus held low fails the probe quickly instead of
+    // stalling setup()
+    m_i2c.setTimeout(I2C_BOOT_TIMEOUT_US);
+    m_i2c.begin(I2C_CLOCK_SPEED);
     
-    // Small delay after I2C init
-    delay(100);
+    if (FAST_BOOT_ENABLED) {
+        // Wait only for what is left of the sensors' power-up time
+        uint32_t now = millis();
+        if (now < TOUCH_POWER_UP_MS) {
+            delay(TOUCH_POWER_UP_MS - now);
+        }
+    } else {
+        // Small delay after I2C init
+        delay(100);
+    }
     
     // Try to recover I2C bus if stuck
-    recoverI2CBus();
+    recoverI2CBus(I2C_CLOCK_SPEED, FAST_BOOT_ENABLED ? 0 : I2C_RECOVERY_SETTLE_MS);
     
     m_activeSensorCount = 0;
     
-    // Initialize each sensor
+    // Initialize each chip once, however many positions it serves
+    buildChipTable();
+    uint32_t activeChips = FAST_BOOT_ENABLED ? initFromStoredMap() : 0;
+    bool fromStoredMap = activeChips != 0;
+    if (!fromStoredMap) {
+        m_i2c.setClock(I2C_CLOCK_SPEED);
+        activeChips = initChips((1UL << m_chipCount) - 1);
+    }
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        m_chips[c].active = (activeChips & (1UL << c)) != 0;
+    }
+    
+    m_activeMask = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_chips[c].active) {
+            m_activeMask |= m_chips[c].positions;
+        }
+    }
+    
     for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        uint8_t address = SENSOR_I2C_ADDRESSES[i];
-        
-        if (initSensor(address)) {
-            m_sensors[i].active = true;
+        if (m_activeMask & (1UL << i)) {
             m_activeSensorCount++;
-        } else {
-            m_sensors[i].active = false;
         }
-        
-        // Reset state
-        m_sensors[i].currentTouched = false;
-        m_sensors[i].debouncedTouched = false;
-        m_sensors[i].lastReportedTouched = false;
-        m_sensors[i].lastChangeTime = 0;
+    }
+    
+    // Spread one read of every chip per TOUCH_POLL_INTERVAL_MS over the polls
+    uint8_t activeChipCount = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        activeChipCount += m_chips[c].active;
+    }
+    m_readsPerPoll = (activeChipCount * TOUCH_HOT_POLL_INTERVAL_MS + TOUCH_POLL_INTERVAL_MS - 1) / TOUCH_POLL_INTERVAL_MS;
+    if (m_readsPerPoll < 2) {
+        m_readsPerPoll = 2;
+    }
+    m_hotCursor = 0;
+    m_idleCursor = 0;
+    
+    // Reset state
+    m_rawMask = 0;
+    m_debouncedMask = 0;
+    m_reportedMask = 0;
+    m_debounceCount0 = 0;
+    m_debounceCount1 = 0;
+    m_lastRawMask = 0;
+    m_settledMask = 0xFFFFFFFFUL;
+    m_lockedMask = 0;
+    m_bouncedMask = 0;
+    m_noisyMask = 0;
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        m_lockLeft[i] = 0;
+        m_noise[i] = 0;
+        m_stepUs[i] = 0;
+    }
+    m_pressedEdges = 0;
+    m_releasedEdges = 0;
+    
+    m_sweepPending = 0;
+    m_sweepPositions = 0;
+    m_sweepActive = false;
+    
+    // Run sweeps at the fastest speed the bus supports (the stored map
+    // already holds the one found at an earlier boot)
+    if (!fromStoredMap) {
+        selectBusClock();
+    }
+    storeSensorMap();
+    m_i2c.setTimeout(I2C_TIMEOUT_US);
+    m_bootClockStep = m_clockStep;
+    m_windowErrors = 0;
+    m_windowStart = millis();
+    m_cleanWindows = 0;
+    m_recoveryBackoff = I2C_RECOVERY_BACKOFF_MS;
+    m_lastRecovery = m_windowStart - I2C_RECOVERY_BACKOFF_MS;
+    m_offlineChips = 0;
+    m_lastReprobe = m_windowStart;
+    
+    if (TOUCH_ALERT_ENABLED) {
+        beginAlertInterrupts();
     }
     
     return m_activeSensorCount > 0;
@@ -79,40 +303,141 @@ bool TouchController::begin() {
 void TouchController::tick() {
     uint32_t now = millis();
     
-    // Rate limit sensor polling
-    if (now - m_lastPollTime < TOUCH_POLL_INTERVAL_MS) {
-        return;
+    // Start a new sweep once per poll interval, after the last one drained
+    if (!m_sweepActive && now - m_lastPollTime >= TOUCH_HOT_POLL_INTERVAL_MS) {
+        m_lastPollTime = now;
+        startSweep(now);
     }
-    m_lastPollTime = now;
     
-    // Poll all sensors
-    pollSensors();
+    // Advance queued transfers within a bounded time slice
+    scheduleCalibration(now);
+    scheduleSweepReads();
+    m_i2c.run(TOUCH_I2C_BUDGET_US);
+    
+    I2cTransaction t;
+    while (m_i2c.takeCompleted(t)) {
+        handleTransaction(t);
+    }
     
-    // Process debouncing and emit events
-    processDebounce();
+    // Sweep finished - process debouncing and emit events
+    if (m_sweepActive && m_sweepPending == 0 && m_i2c.isIdle()) {
+        m_sweepActive = false;
+        processDebounce();
+        checkBusHealth(now);
+        
+        // Write tuning changes once they settle, while the bus is idle and
+        // no touch can be delayed by the blocking flash write
+        if (m_settings && m_settings->isCommitDue(now) && collectHotChips() == 0) {
+            m_settings->commit();
+        }
+    }
 }
 
-bool TouchController::recalibrate(uint8_t sensorIndex) {
-    if (sensorIndex >= NUM_TOUCH_SENSORS) {
+bool TouchController::startRecalibration(uint32_t sensorMask) {
+    sensorMask &= m_activeMask;
+    if (sensorMask == 0) {
         return false;
     }
     
-    if (!m_sensors[sensorIndex].active) {
-        return false;
+    // One trigger write per chip, for all requested inputs on it
+    uint32_t positions = sensorMask;
+    while (positions != 0) {
+        uint8_t i = lowestBit(positions);
+        positions &= ~(1UL << i);
+        
+        uint8_t c = m_sensorChip[i];
+        uint32_t bit = 1UL << c;
+        m_calInputs[c] |= 1 << SENSOR_INPUT_CHANNELS[i];
+        
+        // A status read already on the bus predates this trigger
+        if (m_calInFlight & bit) {
+            m_calStale |= bit;
+        }
+        m_calWrites |= bit;
+        m_calPending |= bit;
     }
     
-    uint8_t address = SENSOR_I2C_ADDRESSES[sensorIndex];
+    m_calFailed &= ~sensorMask;
     
-    // Write to trigger recalibration of CS1
-    return writeRegister(address, CAP1188_REG_CALIBRATION_ACTIVE, CS1_BIT_MASK);
+    m_lastCalPoll = millis();
+    return true;
 }
 
-void TouchController::recalibrateAll() {
-    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        if (m_sensors[i].active) {
-            recalibrate(i);
+bool TouchController::isRecalibrating(uint32_t sensorMask) const {
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if ((m_calPending & (1UL << c)) && (m_chips[c].positions & sensorMask)) {
+            return true;
         }
     }
+    return false;
+}
+
+uint32_t TouchController::getRecalibrationFailures(uint32_t sensorMask) const {
+    return m_calFailed & sensorMask;
+}
+
+bool TouchController::setSensitivity(uint8_t sensorIndex, uint8_t level) {
+    if (sensorIndex >= NUM_TOUCH_SENSORS || level > MAX_SENSITIVITY) {
+        return false;
+    }
+    
+    if (!(m_activeMask & (1UL << sensorIndex))) {
+        return false;
+    }
+    
+    uint8_t c = m_sensorChip[sensorIndex];
+    if (!m_i2c.submit(I2cOp::WRITE, m_chips[c].address, CAP1188_REG_SENSITIVITY_CONTROL,
+                      sensitivityRegister(level), c, KIND_CONFIG)) {
+        return false;
+    }
+    
+    // The register is per chip - every position on it gets the level
+    if (m_settings) {
+        uint32_t positions = m_chips[c].positions;
+        while (positions != 0) {
+            uint8_t i = lowestBit(positions);
+            positions &= ~(1UL << i);
+            m_settings->settings().sensitivity[i] = level;
+        }
+        m_settings->markDirty();
+    }
+    return true;
+}
+
+bool TouchController::setThreshold(uint8_t sensorIndex, uint8_t threshold) {
+    if (sensorIndex >= NUM_TOUCH_SENSORS || threshold > MAX_TOUCH_THRESHOLD) {
+        return false;
+    }
+    
+    if (!(m_activeMask & (1UL << sensorIndex))) {
+        return false;
+    }
+    
+    uint8_t c = m_sensorChip[sensorIndex];
+    uint8_t reg = CAP1188_REG_SENSOR_THRESHOLD_1 + SENSOR_INPUT_CHANNELS[sensorIndex];
+    if (!m_i2c.submit(I2cOp::WRITE, m_chips[c].address, reg, threshold, c, KIND_CONFIG)) {
+        return false;
+    }
+    
+    if (m_settings) {
+        m_settings->settings().threshold[sensorIndex] = threshold;
+        m_settings->markDirty();
+    }
+    return true;
+}
+
+uint8_t TouchController::getSensitivity(uint8_t sensorIndex) const {
+    if (!m_settings || sensorIndex >= NUM_TOUCH_SENSORS) {
+        return DEFAULT_SENSITIVITY;
+    }
+    return m_settings->settings().sensitivity[sensorIndex] & MAX_SENSITIVITY;
+}
+
+uint8_t TouchController::getThreshold(uint8_t sensorIndex) const {
+    if (!m_settings || sensorIndex >= NUM_TOUCH_SENSORS) {
+        return DEFAULT_TOUCH_THRESHOLD;
+    }
+    return m_settings->settings().threshold[sensorIndex] & MAX_TOUCH_THRESHOLD;
 }
 
 void TouchController::setExpectDown(uint8_t sensorIndex, uint32_t commandId) {
@@ -157,7 +482,7 @@ void TouchController::buildActiveSensorList(char* buffer, size_t bufferSize) con
     bool first = true;
     
     for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        if (m_sensors[i].active) {
+        if (m_activeMask & (1UL << i)) {
             // Need room for comma (if not first) + letter + null terminator
             size_t needed = first ? 2 : 3;
             if (pos + needed > bufferSize) {
@@ -178,20 +503,85 @@ bool TouchController::isSensorActive(uint8_t sensorIndex) const {
     if (sensorIndex >= NUM_TOUCH_SENSORS) {
         return false;
     }
-    return m_sensors[sensorIndex].active;
+    return (m_activeMask & (1UL << sensorIndex)) != 0;
 }
 
 bool TouchController::isTouched(uint8_t sensorIndex) const {
     if (sensorIndex >= NUM_TOUCH_SENSORS) {
         return false;
     }
-    return m_sensors[sensorIndex].debouncedTouched;
+    return (m_debouncedMask & (1UL << sensorIndex)) != 0;
 }
 
 uint8_t TouchController::getActiveSensorCount() const {
     return m_activeSensorCount;
 }
 
+uint32_t TouchController::getActiveSensorMask() const {
+    return m_activeMask;
+}
+
+uint32_t TouchController::getTouchedMask() const {
+    return m_debouncedMask;
+}
+
+void TouchController::getEdgeMasks(uint32_t& pressed, uint32_t& released) {
+    pressed = m_pressedEdges;
+    released = m_releasedEdges;
+    m_pressedEdges = 0;
+    m_releasedEdges = 0;
+}
+
+void TouchController::setSimulatedTouches(uint32_t mask) {
+    m_simulatedMask = mask;
+}
+
+uint32_t TouchController::getSimulatedTouches() const {
+    return m_simulatedMask;
+}
+
+void TouchController::setEventSource(EventSource source) {
+    m_eventSource = source;
+}
+
+uint32_t TouchController::getBusClock() const {
+    return m_i2c.getClock();
+}
+
+void TouchController::buildBusInfo(char* buffer, size_t bufferSize) const {
+    if (bufferSize == 0) {
+        return;
+    }
+    
+    uint32_t nacks = 0;
+    uint32_t timeouts = 0;
+    uint32_t worstCount = 0;
+    uint8_t worstIndex = 255;
+    
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        uint32_t errors = (uint32_t)m_busHealth[c].nackCount + m_busHealth[c].timeoutCount;
+        nacks += m_busHealth[c].nackCount;
+        timeouts += m_busHealth[c].timeoutCount;
+        
+        // Chips are reported by their first position
+        if (errors > worstCount) {
+            worstCount = errors;
+            worstIndex = lowestBit(m_chips[c].positions);
+        }
+    }
+    
+    if (worstIndex == 255) {
+        snprintf(buffer, bufferSize, "i2c=%lu nack=%lu timeout=%lu worst=-",
+                 (unsigned long)m_i2c.getClock(), (unsigned long)nacks,
+                 (unsigned long)timeouts);
+    } else {
+        snprintf(buffer, bufferSize, "i2c=%lu nack=%lu timeout=%lu worst=%c:%lu",
+                 (unsigned long)m_i2c.getClock(), (unsigned long)nacks,
+                 (unsigned long)timeouts, indexToLetter(worstIndex),
+                 (unsigned long)worstCount);
+    }
+}
+
 // ============================================================================
 // Static Utility Methods
 // ============================================================================
@@ -229,90 +619,153 @@ uint8_t TouchController::addressToIndex(uint8_t address) {
 // Private Methods
 // ============================================================================
 
-bool TouchController::initSensor(uint8_t address) {
-    // Check if sensor responds
-    Wire.beginTransmission(address);
-    if (Wire.endTransmission() != 0) {
-        return false;
-    }
+void TouchController::buildChipTable() {
+    m_chipCount = 0;
     
-    // Enable only CS1 input (bit 0)
-    if (!writeRegister(address, CAP1188_REG_SENSOR_INPUT_ENABLE, CS1_BIT_MASK)) {
-        return false;
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        uint8_t address = SENSOR_I2C_ADDRESSES[i];
+        
+        // Find the chip for this address, or add it
+        uint8_t c = 0;
+        while (c < m_chipCount && m_chips[c].address != address) {
+            c++;
+        }
+        
+        if (c == m_chipCount) {
+            m_chips[c].address = address;
+            m_chips[c].inputMask = 0;
+            m_chips[c].alertGroup = SENSOR_ALERT_GROUPS[i];
+            m_chips[c].active = false;
+            m_chips[c].positions = 0;
+            m_chipCount++;
+        }
+        
+        m_chips[c].inputMask |= 1 << SENSOR_INPUT_CHANNELS[i];
+        m_chips[c].positions |= (1UL << i);
+        m_sensorChip[i] = c;
     }
-    
-    // Set default sensitivity
-    // Sensitivity register 0x1F: bits 6:4 = sensitivity (0-7)
-    uint8_t sensitivityValue = 0x20 | (DEFAULT_SENSITIVITY << 4);
-    if (!writeRegister(address, CAP1188_REG_SENSITIVITY_CONTROL, sensitivityValue)) {
-        return false;
+}
+
+uint32_t TouchController::initChips(uint32_t chips) {
+    for (const ChipInitStep& step : CHIP_INIT_STEPS) {
+        if (step.alertOnly && !TOUCH_ALERT_ENABLED) {
+            continue;
+        }
+        
+        // Threshold registers are one per input, the others one per chip
+        uint8_t channels = step.source == INIT_THRESHOLD ? CAP1188_INPUT_COUNT : 1;
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            uint32_t unsent = 0;
+            for (uint8_t c = 0; c < m_chipCount; c++) {
+                if ((chips & (1UL << c)) &&
+                    (step.source != INIT_THRESHOLD || (m_chips[c].inputMask & (1 << ch)))) {
+                    unsent |= (1UL << c);
+                }
+            }
+            
+            // Keep the queue full, so transfers to different chips go back to back
+            while (unsent != 0 || !m_i2c.isIdle()) {
+                while (unsent != 0 && m_i2c.freeSlots() > 0) {
+                    uint8_t c = lowestBit(unsent);
+                    unsent &= ~(1UL << c);
+                    m_i2c.submit(step.op, m_chips[c].address, step.reg + ch,
+                                 chipInitValue(step.source, step.value, c, ch), c, KIND_INIT);
+                }
+                
+                m_i2c.run(TOUCH_I2C_BUDGET_US);
+                
+                I2cTransaction t;
+                while (m_i2c.takeCompleted(t)) {
+                    if (!t.ok && step.required) {
+                        chips &= ~(1UL << t.tag);
+                    }
+                }
+            }
+        }
     }
     
-    // Clear any pending interrupts
-    uint8_t dummy;
-    readRegister(address, CAP1188_REG_SENSOR_INPUT_STATUS, dummy);
+    return chips;
+}
+
+uint8_t TouchController::chipInitValue(uint8_t source, uint8_t value, uint8_t chipIndex, uint8_t channel) const {
+    const TouchChip& chip = m_chips[chipIndex];
     
-    // Clear interrupt flag in main control register
-    uint8_t mainControl;
-    if (readRegister(address, CAP1188_REG_MAIN_CONTROL, mainControl)) {
-        mainControl &= ~0x01;  // Clear INT bit
-        writeRegister(address, CAP1188_REG_MAIN_CONTROL, mainControl);
+    switch (source) {
+        case INIT_INPUTS:
+            return chip.inputMask;
+        case INIT_SENSITIVITY:
+            return sensitivityRegister(getSensitivity(lowestBit(chip.positions)));
+        case INIT_THRESHOLD: {
+            // The position wired to this input
+            uint32_t positions = chip.positions;
+            while (positions != 0) {
+                uint8_t i = lowestBit(positions);
+                positions &= ~(1UL << i);
+                if (SENSOR_INPUT_CHANNELS[i] == channel) {
+                    return getThreshold(i);
+                }
+            }
+            return DEFAULT_TOUCH_THRESHOLD;
+        }
+        default:
+            return value;
     }
-    
-    return true;
 }
 
-bool TouchController::readRegister(uint8_t address, uint8_t reg, uint8_t& value) {
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    if (Wire.endTransmission(false) != 0) {
-        delayMicroseconds(50);
-        return false;
+uint32_t TouchController::initFromStoredMap() {
+    if (!m_settings || !m_settings->isLoaded()) {
+        return 0;
+    }
+    
+    const StoredSettings& stored = m_settings->settings();
+    if (stored.chipCount != m_chipCount || stored.layoutChecksum != chipTableChecksum() ||
+        stored.clockStep >= I2C_CLOCK_STEP_COUNT || stored.activeChips == 0) {
+        return 0;
     }
     
-    delayMicroseconds(50);
+    // Chips missing from the map cost one NACKed write each, so a chip
+    // plugged in since the last boot is still picked up
+    m_i2c.setClock(I2C_CLOCK_STEPS[stored.clockStep]);
+    uint32_t chips = initChips((1UL << m_chipCount) - 1);
     
-    if (Wire.requestFrom(address, (uint8_t)1) != 1) {
-        return false;
+    if ((chips & stored.activeChips) != stored.activeChips) {
+        return 0;  // A stored chip did not answer (at this speed)
     }
     
-    value = Wire.read();
-    return true;
+    m_clockStep = stored.clockStep;
+    return chips;
 }
 
-bool TouchController::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    Wire.write(value);
-    uint8_t result = Wire.endTransmission();
-    delayMicroseconds(50);
-    return result == 0;
-}
-
-bool TouchController::readRawTouch(uint8_t address) {
-    uint8_t status;
-    
-    // Read sensor input status register
-    if (!readRegister(address, CAP1188_REG_SENSOR_INPUT_STATUS, status)) {
-        return false;
+void TouchController::storeSensorMap() {
+    if (!m_settings) {
+        return;
     }
     
-    // Check if CS1 is touched (bit 0)
-    bool touched = (status & CS1_BIT_MASK) != 0;
-    
-    if (touched) {
-        // Clear the interrupt flag
-        uint8_t mainControl;
-        if (readRegister(address, CAP1188_REG_MAIN_CONTROL, mainControl)) {
-            mainControl &= ~0x01;
-            writeRegister(address, CAP1188_REG_MAIN_CONTROL, mainControl);
+    uint32_t activeChips = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_chips[c].active) {
+            activeChips |= (1UL << c);
         }
     }
     
-    return touched;
+    StoredSettings& stored = m_settings->settings();
+    stored.chipCount = m_chipCount;
+    stored.layoutChecksum = chipTableChecksum();
+    stored.clockStep = m_clockStep;
+    stored.activeChips = activeChips;
+    m_settings->commit();
+}
+
+uint8_t TouchController::chipTableChecksum() const {
+    uint8_t crc = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        uint8_t entry[2] = { m_chips[c].address, m_chips[c].inputMask };
+        crc = SettingsStore::checksum(entry, sizeof(entry), crc);
+    }
+    return crc;
 }
 
-void TouchController::recoverI2CBus() {
+void TouchController::recoverI2CBus(uint32_t clockHz, uint16_t settleMs) {
     Wire.end();
     
     // On Arduino UNO R4 WiFi, SDA = A4 (pin 18), SCL = A5 (pin 19)
@@ -337,85 +790,553 @@ void TouchController::recoverI2CBus() {
     delayMicroseconds(5);
     
     // Reinitialize I2C
-    Wire.begin();
-    Wire.setClock(I2C_CLOCK_SPEED);
-    delay(10);
+    m_i2c.begin(clockHz);
+    delay(settleMs);
 }
 
-void TouchController::pollSensors() {
-    uint32_t now = millis();
+void TouchController::selectBusClock() {
+    uint8_t step = 0;
     
-    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        if (!m_sensors[i].active) {
-            continue;
+    for (; step < I2C_CLOCK_STEP_COUNT - 1; step++) {
+        m_i2c.setClock(I2C_CLOCK_STEPS[step]);
+        
+        // Every active chip must answer a status read at this speed
+        bool allOk = true;
+        for (uint8_t c = 0; c < m_chipCount && allOk; c++) {
+            uint8_t status;
+            if (m_chips[c].active &&
+                !m_i2c.readRegister(m_chips[c].address, CAP1188_REG_SENSOR_INPUT_STATUS, status)) {
+                allOk = false;
+            }
         }
         
-        uint8_t address = SENSOR_I2C_ADDRESSES[i];
-        bool touched = readRawTouch(address);
+        if (allOk) {
+            break;
+        }
+    }
+    
+    // Falls through to the slowest step if no faster one worked
+    m_clockStep = step;
+    m_i2c.setClock(I2C_CLOCK_STEPS[step]);
+}
+
+void TouchController::recordBusError(uint8_t chipIndex, I2cError error) {
+    if (chipIndex >= m_chipCount || error == I2cError::NONE) {
+        return;
+    }
+    
+    SensorBusHealth& health = m_busHealth[chipIndex];
+    if (error == I2cError::NACK) {
+        // A chip that doesn't answer says nothing about the bus
+        if (health.nackCount < UINT16_MAX) {
+            health.nackCount++;
+        }
+        if (health.nackRun < UINT8_MAX) {
+            health.nackRun++;
+        }
+        return;
+    }
+    
+    if (health.timeoutCount < UINT16_MAX) {
+        health.timeoutCount++;
+    }
+    if (m_windowErrors < UINT8_MAX) {
+        m_windowErrors++;
+    }
+}
+
+void TouchController::checkBusHealth(uint32_t now) {
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_chips[c].active && m_busHealth[c].nackRun >= I2C_CHIP_NACK_LIMIT) {
+            takeChipOffline(c);
+        }
+    }
+    
+    if (m_windowErrors >= I2C_ERROR_THRESHOLD) {
+        // Too many bus errors - slow down (if possible) and unstick the bus,
+        // backing off while recoveries don't help
+        if (now - m_lastRecovery >= m_recoveryBackoff) {
+            if (m_clockStep < I2C_CLOCK_STEP_COUNT - 1) {
+                m_clockStep++;
+            }
+            recoverI2CBus(I2C_CLOCK_STEPS[m_clockStep], I2C_RECOVERY_SETTLE_MS);
+            
+            m_lastRecovery = now;
+            m_recoveryBackoff = m_recoveryBackoff * 2 < I2C_RECOVERY_BACKOFF_MAX_MS
+                ? m_recoveryBackoff * 2 : I2C_RECOVERY_BACKOFF_MAX_MS;
+        }
         
-        // Check if raw state changed
-        if (touched != m_sensors[i].currentTouched) {
-            m_sensors[i].currentTouched = touched;
-            m_sensors[i].lastChangeTime = now;
+        m_cleanWindows = 0;
+        m_windowErrors = 0;
+        m_windowStart = now;
+        return;
+    }
+    
+    if (now - m_windowStart >= I2C_HEALTH_WINDOW_MS) {
+        if (m_windowErrors == 0) {
+            m_recoveryBackoff = I2C_RECOVERY_BACKOFF_MS;
+            if (m_cleanWindows < UINT8_MAX) {
+                m_cleanWindows++;
+            }
+            
+            // Clean for long enough - try the next faster step again
+            if (m_cleanWindows >= I2C_CLOCK_RESTORE_WINDOWS && m_clockStep > m_bootClockStep) {
+                m_clockStep--;
+                m_i2c.setClock(I2C_CLOCK_STEPS[m_clockStep]);
+                m_cleanWindows = 0;
+            }
+        } else {
+            m_cleanWindows = 0;
         }
+        
+        m_windowErrors = 0;
+        m_windowStart = now;
+    }
+    
+    if (m_offlineChips != 0 && now - m_lastReprobe >= I2C_CHIP_REPROBE_MS) {
+        m_lastReprobe = now;
+        reprobeOfflineChip();
     }
 }
 
-void TouchController::processDebounce() {
-    uint32_t now = millis();
+void TouchController::takeChipOffline(uint8_t chipIndex) {
+    TouchChip& chip = m_chips[chipIndex];
+    chip.active = false;
+    m_offlineChips |= 1UL << chipIndex;
+    
+    // Its positions read as released from now on
+    for (uint32_t positions = chip.positions & m_activeMask; positions != 0; positions &= positions - 1) {
+        m_activeSensorCount--;
+    }
+    m_activeMask &= ~chip.positions;
+    m_rawMask &= ~chip.positions;
+}
+
+void TouchController::reprobeOfflineChip() {
+    // Next offline chip after the one probed last
+    uint8_t c = m_reprobeCursor;
+    for (uint8_t n = 0; n < m_chipCount; n++) {
+        c = (c + 1) % m_chipCount;
+        if (m_offlineChips & (1UL << c)) {
+            break;
+        }
+    }
+    m_reprobeCursor = c;
+    
+    TouchChip& chip = m_chips[c];
+    uint8_t status;
+    if (!m_i2c.readRegister(chip.address, CAP1188_REG_SENSOR_INPUT_STATUS, status)) {
+        return;
+    }
     
+    // It may have been power cycled - configure it again
+    if (initChips(1UL << c) == 0) {
+        return;
+    }
+    
+    chip.active = true;
+    m_offlineChips &= ~(1UL << c);
+    m_busHealth[c].nackRun = 0;
+    for (uint32_t positions = chip.positions & ~m_activeMask; positions != 0; positions &= positions - 1) {
+        m_activeSensorCount++;
+    }
+    m_activeMask |= chip.positions;
+}
+
+void TouchController::startSweep(uint32_t now) {
+    uint32_t activeMask = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_chips[c].active) {
+            activeMask |= (1UL << c);
+        }
+    }
+    
+    uint32_t hotMask = collectHotChips() & activeMask;
+    
+    if (!TOUCH_ALERT_ENABLED) {
+        // Hot chips every poll, idle ones in turn
+        m_sweepPending = pickPollChips(activeMask, hotMask);
+    } else if (now - m_lastSweepTime < TOUCH_BACKGROUND_SWEEP_MS) {
+        // Only read chips that raised ALERT, and hot ones
+        m_sweepPending = (collectAlertedChips() | hotMask) & activeMask;
+    } else {
+        // Background sweep: read all chips
+        m_lastSweepTime = now;
+        m_sweepPending = activeMask;
+    }
+    
+    m_sweepPositions = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_sweepPending & (1UL << c)) {
+            m_sweepPositions |= m_chips[c].positions;
+        }
+    }
+    
+    m_sweepActive = true;
+    m_sweepStartUs = micros();
+}
+
+uint32_t TouchController::collectHotChips() const {
+    // Simulated touches count as hot so they are read at the hot rate
+    uint32_t hot = m_rawMask | m_debouncedMask | m_lockedMask | m_simulatedMask;
     for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
-        if (!m_sensors[i].active) {
-            continue;
+        if (m_expectDown[i].active || m_expectUp[i].active) {
+            hot |= (1UL << i);
+        }
+    }
+    
+    uint32_t mask = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        if (m_chips[c].positions & hot) {
+            mask |= (1UL << c);
+        }
+    }
+    return mask;
+}
+
+uint32_t TouchController::pickPollChips(uint32_t activeMask, uint32_t hotMask) {
+    uint32_t idleMask = activeMask & ~hotMask;
+    
+    uint8_t hotReads = idleMask != 0 ? m_readsPerPoll - 1 : m_readsPerPoll;
+    uint32_t picked = takeRoundRobin(hotMask, hotReads, m_hotCursor);
+    
+    uint8_t taken = 0;
+    for (uint32_t p = picked; p != 0; p &= p - 1) {
+        taken++;
+    }
+    return picked | takeRoundRobin(idleMask, m_readsPerPoll - taken, m_idleCursor);
+}
+
+uint32_t TouchController::takeRoundRobin(uint32_t mask, uint8_t count, uint8_t& cursor) const {
+    uint32_t taken = 0;
+    uint8_t start = cursor;
+    
+    for (uint8_t n = 0; n < m_chipCount && count > 0; n++) {
+        uint8_t c = (start + n) % m_chipCount;
+        if (mask & (1UL << c)) {
+            taken |= (1UL << c);
+            count--;
+            cursor = (c + 1) % m_chipCount;
+        }
+    }
+    return taken;
+}
+
+void TouchController::scheduleSweepReads() {
+    // Keep half the queue free for INT clears and recalibration writes
+    while (m_sweepPending != 0 && m_i2c.freeSlots() > I2C_QUEUE_SIZE / 2) {
+        uint8_t c = lowestBit(m_sweepPending);
+        
+        m_i2c.submit(I2cOp::READ, m_chips[c].address,
+                     CAP1188_REG_SENSOR_INPUT_STATUS, 0, c, KIND_STATUS);
+        m_sweepPending &= ~(1UL << c);
+    }
+}
+
+void TouchController::scheduleCalibration(uint32_t now) {
+    // Keep a quarter of the queue free for INT clears
+    const uint8_t RESERVED_SLOTS = I2C_QUEUE_SIZE / 4;
+    
+    // All trigger writes back to back. Each chip's timeout runs from its
+    // own trigger, so a later RECALIBRATE doesn't extend earlier ones.
+    while (m_calWrites != 0 && m_i2c.freeSlots() > RESERVED_SLOTS) {
+        uint8_t c = lowestBit(m_calWrites);
+        m_i2c.submit(I2cOp::WRITE, m_chips[c].address, CAP1188_REG_CALIBRATION_ACTIVE,
+                     m_calInputs[c], c, KIND_RECALIBRATE);
+        m_calWrites &= ~(1UL << c);
+        m_calDeadline[c] = now + CALIBRATION_TIMEOUT_MS;
+    }
+    
+    // Then one status read of every calibrating chip per poll
+    if (m_calPending != 0 && m_calWrites == 0 && m_calPolls == 0 && m_calInFlight == 0 &&
+        now - m_lastCalPoll >= CALIBRATION_POLL_MS) {
+        m_lastCalPoll = now;
+        
+        for (uint8_t c = 0; c < m_chipCount; c++) {
+            uint32_t bit = 1UL << c;
+            if ((m_calPending & bit) && (int32_t)(now - m_calDeadline[c]) >= 0) {
+                // Not confirmed in time
+                m_calFailed |= m_chips[c].positions;
+                m_calInputs[c] = 0;
+                m_calPending &= ~bit;
+            }
+        }
+        m_calPolls = m_calPending;
+    }
+    
+    while (m_calPolls != 0 && m_i2c.freeSlots() > RESERVED_SLOTS) {
+        uint8_t c = lowestBit(m_calPolls);
+        m_i2c.submit(I2cOp::READ, m_chips[c].address, CAP1188_REG_CALIBRATION_ACTIVE,
+                     0, c, KIND_CAL_STATUS);
+        m_calPolls &= ~(1UL << c);
+        m_calInFlight |= (1UL << c);
+    }
+}
+
+void TouchController::handleCalibration(const I2cTransaction& t) {
+    uint8_t c = t.tag;
+    uint32_t bit = 1UL << c;
+    
+    if (t.kind == KIND_RECALIBRATE) {
+        if (!t.ok) {
+            // Trigger not delivered - nothing to wait for
+            m_calPending &= ~bit;
+            m_calFailed |= m_chips[c].positions;
+            m_calInputs[c] = 0;
+        }
+        return;
+    }
+    
+    m_calInFlight &= ~bit;
+    if (m_calStale & bit) {
+        m_calStale &= ~bit;
+        return;
+    }
+    
+    // The chip clears an input's bit once its calibration finished.
+    // A failed read is retried on the next poll.
+    if (t.ok && (m_calPending & bit) && (t.value & m_calInputs[c]) == 0) {
+        m_calPending &= ~bit;
+        m_calInputs[c] = 0;
+    }
+}
+
+void TouchController::handleTransaction(const I2cTransaction& t) {
+    if (!t.ok) {
+        recordBusError(t.tag, t.error);
+    } else if (t.tag < m_chipCount) {
+        m_busHealth[t.tag].nackRun = 0;
+    }
+    
+    if (t.kind == KIND_RECALIBRATE || t.kind == KIND_CAL_STATUS) {
+        handleCalibration(t);
+        return;
+    }
+    
+    if (t.kind != KIND_STATUS) {
+        return;  // Fire-and-forget writes
+    }
+    
+    uint8_t c = t.tag;
+    
+    // One status byte covers every position on the chip.
+    // A failed read counts as not touched.
+    uint32_t positions = m_chips[c].positions;
+    uint32_t touchedMask = 0;
+    while (t.ok && positions != 0) {
+        uint8_t i = lowestBit(positions);
+        positions &= ~(1UL << i);
+        
+        if (t.value & (1 << SENSOR_INPUT_CHANNELS[i])) {
+            touchedMask |= (1UL << i);
+        }
+    }
+    uint32_t simulated = m_simulatedMask & m_chips[c].positions;
+    
+    m_rawMask = (m_rawMask & ~m_chips[c].positions) | touchedMask | (t.ok ? simulated : 0);
+    bool anyTouched = touchedMask != 0;
+    
+    // Clear the interrupt flag. In ALERT mode releases raise INT too, and
+    // ALERT stays asserted until it is cleared.
+    if (anyTouched || (TOUCH_ALERT_ENABLED && t.ok)) {
+        m_i2c.submit(I2cOp::CLEAR_BITS, t.address, CAP1188_REG_MAIN_CONTROL,
+                     CAP1188_MAIN_CONTROL_INT, c, KIND_CLEAR_INT);
+    }
+}
+
+// ============================================================================
+// ALERT Mode
+// ============================================================================
+
+void TouchController::beginAlertInterrupts() {
+    // One handler per group - attachInterrupt() takes a plain function pointer
+    static void (* const handlers[4])() = {
+        &TouchController::onAlert<0>,
+        &TouchController::onAlert<1>,
+        &TouchController::onAlert<2>,
+        &TouchController::onAlert<3>
+    };
+    
+    s_pendingAlertGroups = 0;
+    
+    for (uint8_t g = 0; g < TOUCH_ALERT_GROUP_COUNT; g++) {
+        // ALERT outputs are open-drain, active low
+        pinMode(TOUCH_ALERT_PINS[g], INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(TOUCH_ALERT_PINS[g]), handlers[g], FALLING);
+        
+        // Lines already low at boot would never produce an edge
+        s_pendingAlertGroups |= (1 << g);
+    }
+}
+
+uint32_t TouchController::collectAlertedChips() {
+    noInterrupts();
+    uint8_t pending = s_pendingAlertGroups;
+    s_pendingAlertGroups = 0;
+    interrupts();
+    
+    // A shared line only produces one edge while any sensor holds it low,
+    // so a group that is still asserted stays pending
+    for (uint8_t g = 0; g < TOUCH_ALERT_GROUP_COUNT; g++) {
+        if (digitalRead(TOUCH_ALERT_PINS[g]) == LOW) {
+            pending |= (1 << g);
+        }
+    }
+    
+    uint32_t mask = 0;
+    for (uint8_t c = 0; c < m_chipCount; c++) {
+        // Chips with touched positions are always read so releases are never missed
+        bool alerted = (pending & (1 << m_chips[c].alertGroup)) != 0;
+        if (alerted || (m_rawMask & m_chips[c].positions)) {
+            mask |= (1UL << c);
         }
+    }
+    
+    return mask;
+}
+
+void TouchController::processDebounce() {
+    // Count samples where raw differs from debounced; agreeing bits reset.
+    // Sensors not read by this sweep keep their counters.
+    uint32_t sampled = m_sweepPositions & m_activeMask;
+    uint32_t delta = (m_rawMask ^ m_debouncedMask) & sampled;
+    uint32_t fresh = delta & ~(m_debounceCount0 | m_debounceCount1);
+    
+    // A change seen for the first time is its raw edge (latency start)
+    for (uint32_t pending = fresh; pending != 0; pending &= pending - 1) {
+        m_edgeUs[lowestBit(pending)] = m_sweepStartUs;
+    }
+    
+    // Hot sensors are read more often than once per TOUCH_POLL_INTERVAL_MS;
+    // their counters still step at that rate, so debounce spans the same time
+    uint32_t due = collectDueSteps((delta | m_lockedMask) & sampled, fresh);
+    uint32_t step = delta & due;
+    uint32_t hold = (delta & ~due) | ~sampled;
+    
+    m_debounceCount1 = ((m_debounceCount1 ^ m_debounceCount0) & step) | (m_debounceCount1 & hold);
+    m_debounceCount0 = (~m_debounceCount0 & step) | (m_debounceCount0 & hold);
+    
+    // Counters that wrapped to zero while still differing have been stable
+    // for DEBOUNCE_SAMPLES samples
+    uint32_t toggled = step & ~(m_debounceCount0 | m_debounceCount1);
+    if (TOUCH_DEBOUNCE_ADAPTIVE) {
+        toggled = adaptDebounce(delta, toggled, due);
+    }
+    m_debouncedMask ^= toggled;
+    
+    uint32_t changed = m_debouncedMask ^ m_reportedMask;
+    if (changed == 0) {
+        return;
+    }
+    
+    uint32_t pressed = changed & m_debouncedMask;
+    uint32_t released = changed & ~m_debouncedMask;
+    m_pressedEdges |= pressed;
+    m_releasedEdges |= released;
+    m_reportedMask = m_debouncedMask;
+    
+    if (!m_eventQueue) {
+        return;
+    }
+    
+    while (changed != 0) {
+        uint8_t i = lowestBit(changed);
+        changed &= ~(1UL << i);
         
-        TouchSensorState& sensor = m_sensors[i];
+        char letter = indexToLetter(i);
         
-        // Check if state has been stable long enough
-        uint32_t elapsed = now - sensor.lastChangeTime;
+        if (pressed & (1UL << i)) {
+            // Touch down detected
+            // Check if we have an expectation for this
+            if (m_expectDown[i].active) {
+                // Expected touch - emit TOUCHED_DOWN with command ID
+                m_eventQueue->queueTouchedDown(letter, m_expectDown[i].commandId, m_edgeUs[i], m_eventSource);
+                // Clear the expectation (one-shot)
+                m_expectDown[i].active = false;
+                m_expectDown[i].commandId = NO_COMMAND_ID;
+            } else {
+                // Spontaneous touch - emit TOUCH_DOWN
+                m_eventQueue->queueTouchDown(letter, m_edgeUs[i], m_eventSource);
+            }
+        } else {
+            // Touch up detected
+            // Check if we have an expectation for this
+            if (m_expectUp[i].active) {
+                // Expected release - emit TOUCHED_UP with command ID
+                m_eventQueue->queueTouchedUp(letter, m_expectUp[i].commandId, m_edgeUs[i], m_eventSource);
+                // Clear the expectation (one-shot)
+                m_expectUp[i].active = false;
+                m_expectUp[i].commandId = NO_COMMAND_ID;
+            } else {
+                // Spontaneous release - emit TOUCH_UP
+                m_eventQueue->queueTouchUp(letter, m_edgeUs[i], m_eventSource);
+            }
+        }
+    }
+}
+
+uint32_t TouchController::collectDueSteps(uint32_t candidates, uint32_t fresh) {
+    uint32_t due = 0;
+    
+    for (uint32_t pending = candidates; pending != 0; pending &= pending - 1) {
+        uint8_t i = lowestBit(pending);
+        if ((fresh & (1UL << i)) || m_sweepStartUs - m_stepUs[i] >= DEBOUNCE_STEP_US) {
+            due |= (1UL << i);
+            m_stepUs[i] = m_sweepStartUs;
+        }
+    }
+    return due;
+}
+
+uint32_t TouchController::adaptDebounce(uint32_t delta, uint32_t counted, uint32_t due) {
+    // A raw flip is a bounce if it happens during a lockout, or if it goes
+    // back to the debounced state before the change was accepted
+    uint32_t flips = (m_rawMask ^ m_lastRawMask) & m_activeMask;
+    uint32_t bounced = flips & (m_lockedMask | ~delta);
+    uint32_t held = m_lockedMask;
+    m_lastRawMask = m_rawMask;
+    
+    // Bounces count on every read, lockouts at the debounce step rate
+    for (uint32_t pending = bounced | (m_lockedMask & due); pending != 0; pending &= pending - 1) {
+        uint8_t i = lowestBit(pending);
+        uint32_t bit = 1UL << i;
         
-        if (elapsed >= DEBOUNCE_MS) {
-            // State is stable - update debounced state
-            if (sensor.currentTouched != sensor.debouncedTouched) {
-                sensor.debouncedTouched = sensor.currentTouched;
-                
-                // Emit event if state changed from last reported
-                if (sensor.debouncedTouched != sensor.lastReportedTouched) {
-                    sensor.lastReportedTouched = sensor.debouncedTouched;
-                    
-                    if (m_eventQueue) {
-                        char letter = indexToLetter(i);
-                        
-                        if (sensor.debouncedTouched) {
-                            // Touch down detected
-                            // Check if we have an expectation for this
-                            if (m_expectDown[i].active) {
-                                // Expected touch - emit TOUCHED_DOWN with command ID
-                                m_eventQueue->queueTouchedDown(letter, m_expectDown[i].commandId);
-                                // Clear the expectation (one-shot)
-                                m_expectDown[i].active = false;
-                                m_expectDown[i].commandId = NO_COMMAND_ID;
-                            } else {
-                                // Spontaneous touch - emit TOUCH_DOWN
-                                m_eventQueue->queueTouchDown(letter);
-                            }
-                        } else {
-                            // Touch up detected
-                            // Check if we have an expectation for this
-                            if (m_expectUp[i].active) {
-                                // Expected release - emit TOUCHED_UP with command ID
-                                m_eventQueue->queueTouchedUp(letter, m_expectUp[i].commandId);
-                                // Clear the expectation (one-shot)
-                                m_expectUp[i].active = false;
-                                m_expectUp[i].commandId = NO_COMMAND_ID;
-                            } else {
-                                // Spontaneous release - emit TOUCH_UP
-                                m_eventQueue->queueTouchUp(letter);
-                            }
-                        }
-                    }
-                }
+        if (bounced & bit) {
+            m_noise[i] = m_noise[i] + DEBOUNCE_NOISE_STEP < DEBOUNCE_NOISE_MAX
+                ? m_noise[i] + DEBOUNCE_NOISE_STEP : DEBOUNCE_NOISE_MAX;
+            m_bouncedMask |= bit;
+        }
+        
+        if ((m_lockedMask & due & bit) && --m_lockLeft[i] == 0) {
+            m_lockedMask &= ~bit;
+            if (!(m_bouncedMask & bit) && m_noise[i] > 0) {
+                m_noise[i]--;
             }
         }
+        if (!(m_lockedMask & bit)) {
+            m_bouncedMask &= ~bit;
+        }
+        
+        if (m_noise[i] >= DEBOUNCE_NOISY_LEVEL) {
+            m_noisyMask |= bit;
+        } else {
+            m_noisyMask &= ~bit;
+        }
     }
+    
+    // Settled, quiet sensors report the leading edge right away; nothing
+    // changes while a sensor holds its lockout
+    uint32_t toggled = (counted | (delta & m_settledMask & ~m_noisyMask)) & ~held;
+    
+    // Accepted changes restart their counters and open a lockout
+    m_debounceCount0 &= ~toggled;
+    m_debounceCount1 &= ~toggled;
+    for (uint32_t pending = toggled; pending != 0; pending &= pending - 1) {
+        uint8_t i = lowestBit(pending);
+        m_lockLeft[i] = lockoutSamples(m_noise[i]);
+        m_lockedMask |= 1UL << i;
+    }
+    
+    m_settledMask = ~(m_rawMask ^ m_debouncedMask ^ toggled) & ~m_lockedMask;
+    return toggled;
 }
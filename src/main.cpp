@@ -28,10 +28,22 @@
  *   EXPECT_UP <pos> [#id]    Wait for release, emit TOUCHED_UP
  *   RECALIBRATE <pos> [#id]  Recalibrate touch sensor
  *   RECALIBRATE_ALL [#id]    Recalibrate all sensors
+ *   SENSITIVITY <pos> <0-7> [#id] Set chip sensitivity (stored across resets)
+ *   THRESHOLD <pos> <0-127> [#id] Set touch threshold (stored across resets)
  *   SEQUENCE_COMPLETED [#id] Play celebration animation
  *   SCAN [#id]               Scan I2C bus for devices
  *   INFO [#id]               Return firmware info
  *   PING [#id]               Health check
+ *   BAUD <rate> [#id]        Switch UART rate (confirmed by the next command)
+ *   MODE <BINARY|ASCII> [#id] Switch serial framing
+ *   BATCH [#id] ... END      Apply enclosed LED commands in one frame
+ *   FRAME <offset> <base64> [#id] Upload raw RGB pixels (Pi-rendered effects)
+ *   PLAY <effect> [pos] [#id] Play a built-in keyframed effect
+ *   STATS [#id]              Queue statistics (+ loop profile with ENABLE_PROFILER)
+ *   LATENCY <ON|OFF> [#id]   Timestamp touch-downs, time the LED reply round trip
+ *   MEM [#id]                Free stack/heap and RAM used per component
+ * 
+ * SHOW/HIDE/BLINK/STOP_BLINK also accept a position list (SHOW A,C,F).
  * 
  * Responses (Arduino -> Pi):
  *   ACK <action> [<pos>] [#id]   Command accepted
@@ -42,8 +54,10 @@
  *   TOUCHED_DOWN <pos> [#id]     Expected touch detected
  *   TOUCHED_UP <pos> [#id]       Expected release detected
  *   SCANNED[A,B,C,...] [#id]     Active sensors list
- *   RECALIBRATED <pos|ALL> [#id] Recalibration complete
- *   INFO version=... [#id]       Firmware information
+ *   RECALIBRATED <pos|ALL> [#id] Recalibration confirmed by the sensor chips
+ *   INFO firmware=... link=... tx=... i2c=... [#id] Firmware, link and I2C bus information
+ *   LATENCY <pos> debounce=... queue=... reply=... total=... [#id] Touch round trip
+ *   MEM stack=... stack_min=... heap=... led=... ... [#id] RAM usage (bytes)
  * 
  * HARDWARE
  * --------
@@ -51,12 +65,16 @@
  *   LED Strip 1: D5 (190 LEDs)
  *   LED Strip 2: D10 (190 LEDs)
  *   Touch:      25x CAP1188 sensors via I2C
- *   Baud:       115200
+ *   Baud:       115200 at boot, up to 2000000 via BAUD
+ *               (or native USB CDC with -D SERIAL_USB_CDC=1)
  * 
  * MOCK PI TESTING
  * ---------------
  *   Define ENABLE_MOCK_PI to enable on-device testing without a real Pi.
- *   Select program with MOCK_PI_PROGRAM (1, 2, or 3).
+ *   Select program with MOCK_PI_PROGRAM (1-5). Program 5 is a load
+ *   generator: it injects commands at MOCK_PI_STRESS_RATE per second plus
+ *   simulated touches, and logs "MockPi: STRESS ..." reports with command,
+ *   reply and event rates, reply latency, and lost/busy/dropped counts.
  * 
  * =============================================================================
  */
@@ -67,6 +85,9 @@
 #include "TouchController.h"
 #include "CommandController.h"
 #include "EventQueue.h"
+#include "SettingsStore.h"
+#include "MemoryReport.h"
+#include "Profiler.h"
 
 // ============================================================================
 // Mock Pi Configuration
@@ -74,11 +95,12 @@
 // Uncomment to enable Mock Pi testing (simulates Pi commands on-device)
 #define ENABLE_MOCK_PI 1
 
-// Select which program to run (1, 2, 3, or 4)
+// Select which program to run (1-5)
 // 1 = Simple sequence (positions: ABCDE)
 // 2 = Simultaneous sequence (spec: "A,B,(C+D),(E+F)")  
 // 3 = Record then playback mode
 // 4 = Two-hand overlapping sequence (positions: ABCDEFG)
+// 5 = Stress / soak test (MOCK_PI_STRESS_RATE commands per second)
 #define MOCK_PI_PROGRAM 4
 
 // Sequence for Program 1 (simple sequential)
@@ -90,6 +112,9 @@
 // Sequence for Program 4 (two-hand overlapping)
 #define MOCK_PI_TWO_HAND_SEQUENCE "ABCDEFG"
 
+// Command rate for Program 5 (mix and touch rate: MOCK_PI_STRESS_DEFAULTS)
+#define MOCK_PI_STRESS_RATE 200
+
 #ifdef ENABLE_MOCK_PI
 #include "MockPiPrograms.h"
 #endif
@@ -107,25 +132,43 @@ LedController ledController;
 // Touch controller manages CAP1188 touch sensors
 TouchController touchController;
 
+// Settings kept across resets (sensor map, sensor tuning)
+SettingsStore settingsStore;
+
 // Command controller handles serial protocol
 CommandController commandController(ledController, &touchController, eventQueue);
 
 #ifdef ENABLE_MOCK_PI
 // Mock Pi for on-device testing
 MockPiPrograms mockPi;
+constexpr uint32_t MOCK_PI_RAM_BYTES = sizeof(MockPiPrograms);
+#else
+constexpr uint32_t MOCK_PI_RAM_BYTES = 0;
 #endif
 
+// Build-time RAM check: the objects above plus the strips' pixel buffers
+// (heap). The linker's region summary (--print-memory-usage) shows the rest.
+constexpr uint32_t CONTROLLER_RAM_BYTES =
+    sizeof(EventQueue) + sizeof(LedController) + sizeof(TouchController) +
+    sizeof(SettingsStore) + sizeof(CommandController) + MOCK_PI_RAM_BYTES +
+    (uint32_t)NUM_LEDS_TOTAL * 3;
+static_assert(CONTROLLER_RAM_BYTES <= RAM_BUDGET_BYTES,
+              "Controllers exceed RAM_BUDGET_BYTES - reduce NUM_LEDS_STRIP1/2 or the queue sizes, or drop ENABLE_MOCK_PI");
+
 // ============================================================================
 // Arduino Setup
 // ============================================================================
 
 void setup() {
+    // Mark the unused stack for MEM (before anything else runs deep)
+    MemoryReport::begin();
+    
     // Initialize serial communication
-    Serial.begin(SERIAL_BAUD_RATE);
+    PI_SERIAL.begin(SERIAL_BAUD_RATE);
     
-    // Wait for serial port to connect (timeout after 3 seconds)
+    // Wait for serial port to connect (no wait with FAST_BOOT_ENABLED)
     uint32_t startTime = millis();
-    while (!Serial && (millis() - startTime < 3000)) {
+    while (!PI_SERIAL && (millis() - startTime < SERIAL_CONNECT_WAIT_MS)) {
         // Wait
     }
     
@@ -135,42 +178,66 @@ void setup() {
     // Initialize LED controller
     ledController.begin();
     
+    // Load stored settings
+    settingsStore.begin();
+    
     // Initialize touch controller
     touchController.setEventQueue(&eventQueue);
+    touchController.setSettingsStore(&settingsStore);
     touchController.begin();
     
     // Initialize command controller
     commandController.begin();
     
-    // Signal ready - send INFO automatically
-    eventQueue.queueInfo(NO_COMMAND_ID);
-    eventQueue.flush(1);
+    // RAM per component for MEM
+    MemoryReport::setComponent(MemoryComponent::LEDS, ledController.memoryUsage());
+    MemoryReport::setComponent(MemoryComponent::TOUCH, sizeof(touchController));
+    MemoryReport::setComponent(MemoryComponent::COMMANDS, sizeof(commandController));
+    MemoryReport::setComponent(MemoryComponent::EVENTS, sizeof(eventQueue));
+    MemoryReport::setComponent(MemoryComponent::SETTINGS, sizeof(settingsStore));
+#ifdef ENABLE_MOCK_PI
+    MemoryReport::setComponent(MemoryComponent::MOCK_PI, sizeof(mockPi));
+#endif
+    
+    // Signal ready - send INFO automatically (with selected bus speed)
+    char busInfo[52];
+    touchController.buildBusInfo(busInfo, sizeof(busInfo));
+    eventQueue.queueInfo(NO_COMMAND_ID, busInfo);
+    eventQueue.flush();
     
 #ifdef ENABLE_MOCK_PI
     // Initialize Mock Pi
     mockPi.begin();
     mockPi.setTouchController(&touchController);
     mockPi.setCommandController(&commandController);
+    mockPi.setEventQueue(&eventQueue);
     mockPi.setVerbose(true);
     
     // Small delay to let serial settle
-    delay(500);
+    if (!FAST_BOOT_ENABLED) {
+        delay(500);
+    }
     
     // Start the selected program
     #if MOCK_PI_PROGRAM == 1
-        Serial.println("MockPi: Starting Program 1 - Simple Sequence");
+        PI_SERIAL.println("MockPi: Starting Program 1 - Simple Sequence");
         mockPi.startSequenceSimple(MOCK_PI_SIMPLE_SEQUENCE);
     #elif MOCK_PI_PROGRAM == 2
-        Serial.println("MockPi: Starting Program 2 - Simultaneous Sequence");
+        PI_SERIAL.println("MockPi: Starting Program 2 - Simultaneous Sequence");
         mockPi.startSequenceSimultaneous(MOCK_PI_SIMULTANEOUS_SPEC);
     #elif MOCK_PI_PROGRAM == 3
-        Serial.println("MockPi: Starting Program 3 - Record & Playback");
+        PI_SERIAL.println("MockPi: Starting Program 3 - Record & Playback");
         mockPi.startRecordPlayback();
     #elif MOCK_PI_PROGRAM == 4
-        Serial.println("MockPi: Starting Program 4 - Two-Hand Sequence");
+        PI_SERIAL.println("MockPi: Starting Program 4 - Two-Hand Sequence");
         mockPi.startTwoHandSequence(MOCK_PI_TWO_HAND_SEQUENCE);
+    #elif MOCK_PI_PROGRAM == 5
+        PI_SERIAL.println("MockPi: Starting Program 5 - Stress");
+        MockPiStressConfig stress = MOCK_PI_STRESS_DEFAULTS;
+        stress.commandsPerSecond = MOCK_PI_STRESS_RATE;
+        mockPi.startStress(stress);
     #else
-        Serial.println("MockPi: No program selected (set MOCK_PI_PROGRAM to 1, 2, 3, or 4)");
+        PI_SERIAL.println("MockPi: No program selected (set MOCK_PI_PROGRAM to 1-5)");
     #endif
 #endif
 }
@@ -180,23 +247,26 @@ void setup() {
 // ============================================================================
 
 void loop() {
+    // Stage timings for STATS when built with ENABLE_PROFILER
+    PROFILE_SCOPE(LOOP);
+    
     // 1. Poll serial for incoming data (non-blocking)
-    commandController.pollSerial();
+    PROFILE_CALL(POLL_SERIAL, commandController.pollSerial());
     
     // 2. Process any complete command lines
-    commandController.processCompletedLines();
+    PROFILE_CALL(PROCESS_LINES, commandController.processCompletedLines());
     
     // 3. Tick command executor for long-running commands
-    commandController.tick();
+    PROFILE_CALL(COMMAND_TICK, commandController.tick());
     
     // 4. Tick touch controller (poll sensors, debounce, emit events)
-    touchController.tick();
+    PROFILE_CALL(TOUCH_TICK, touchController.tick());
     
     // 5. Tick LED controller (update animations)
-    ledController.tick();
+    PROFILE_CALL(LED_TICK, ledController.tick());
     
     // 6. Flush pending events to serial
-    eventQueue.flush(3);  // Send up to 3 events per loop
+    PROFILE_CALL(EVENT_FLUSH, eventQueue.flush());  // Writes only what fits in the TX buffer
     
 #ifdef ENABLE_MOCK_PI
     // 7. Update Mock Pi state machine
@@ -0,0 +1,55 @@
+/**
+ * @file Adafruit_NeoPixel.cpp
+ * @brief Implementation of the NeoPixel fake
+ */
+
+#include "Adafruit_NeoPixel.h"
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType type)
+    : begun(false)
+    , numLEDs(n)
+    , numBytes(n * 3)
+    , pin(p)
+    , pixels(new uint8_t[n * 3]())
+    , m_showCount(0)
+    , m_pushedBytes(0)
+{
+    (void)type;
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+    delete[] pixels;
+}
+
+void Adafruit_NeoPixel::begin() {
+    begun = true;
+}
+
+void Adafruit_NeoPixel::show() {
+    m_showCount++;
+    m_pushedBytes += numBytes;
+}
+
+void Adafruit_NeoPixel::clear() {
+    memset(pixels, 0, numBytes);
+}
+
+bool Adafruit_NeoPixel::canShow() const {
+    return true;
+}
+
+uint8_t* Adafruit_NeoPixel::getPixels() const {
+    return pixels;
+}
+
+uint16_t Adafruit_NeoPixel::numPixels() const {
+    return numLEDs;
+}
+
+uint32_t Adafruit_NeoPixel::showCount() const {
+    return m_showCount;
+}
+
+uint32_t Adafruit_NeoPixel::pushedBytes() const {
+    return m_pushedBytes;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file Adafruit_NeoPixel.h
+ * @brief NeoPixel fake for the native test environment
+ *
+ * Keeps the pixel buffer like the real library (GRB, 3 bytes per pixel)
+ * and counts pushes instead of clocking bits out. show() pushes numBytes,
+ * so prefix refreshes (PrefixNeoPixel) are counted correctly.
+ */
+
+#ifndef ADAFRUIT_NEOPIXEL_FAKE_H
+#define ADAFRUIT_NEOPIXEL_FAKE_H
+
+#include <Arduino.h>
+
+typedef uint16_t neoPixelType;
+
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+    ~Adafruit_NeoPixel();
+
+    Adafruit_NeoPixel(const Adafruit_NeoPixel&) = delete;
+    Adafruit_NeoPixel& operator=(const Adafruit_NeoPixel&) = delete;
+
+    void begin();
+    void show();
+    void clear();
+    bool canShow() const;
+    uint8_t* getPixels() const;
+    uint16_t numPixels() const;
+
+    // === Test Hooks ===
+
+    /**
+     * @brief Get number of show() calls
+     * @return Push count
+     */
+    uint32_t showCount() const;
+
+    /**
+     * @brief Get number of pixel bytes pushed by all show() calls
+     * @return Byte count
+     */
+    uint32_t pushedBytes() const;
+
+protected:
+    bool begun;
+    uint16_t numLEDs;
+    uint16_t numBytes;
+    int16_t pin;
+    uint8_t* pixels;
+
+private:
+    uint32_t m_showCount;
+    uint32_t m_pushedBytes;
+};
+
+#endif // ADAFRUIT_NEOPIXEL_FAKE_H
@@ -0,0 +1,353 @@
+/**
+ * @file Arduino.cpp
+ * @brief Implementation of the native Arduino core fake
+ */
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+HardwareSerial SerialUSB;
+
+// Virtual time (us since boot)
+static uint64_t s_nowUs = 0;
+
+// Levels returned by digitalRead() (pull-ups idle high)
+static uint8_t s_pinLevels[32];
+static bool s_pinsInitialized = false;
+
+static uint8_t& pinLevel(uint8_t pin) {
+    if (!s_pinsInitialized) {
+        memset(s_pinLevels, HIGH, sizeof(s_pinLevels));
+        s_pinsInitialized = true;
+    }
+    return s_pinLevels[pin % sizeof(s_pinLevels)];
+}
+
+// Handlers registered by attachInterrupt(), indexed like s_pinLevels
+static void (*s_pinHandlers[32])() = {};
+static int s_pinModes[32];
+
+/**
+ * @brief Change a pin level and run its interrupt handler on a matching edge
+ * @param pin Pin number
+ * @param value LOW or HIGH
+ */
+static void drivePin(uint8_t pin, uint8_t value) {
+    uint8_t& level = pinLevel(pin);
+    uint8_t previous = level;
+    level = value;
+    
+    uint8_t slot = pin % sizeof(s_pinLevels);
+    void (*handler)() = s_pinHandlers[slot];
+    if (!handler || previous == value) {
+        return;
+    }
+    int mode = s_pinModes[slot];
+    if (mode == CHANGE ||
+        (mode == FALLING && value == LOW) ||
+        (mode == RISING && value == HIGH)) {
+        handler();
+    }
+}
+
+// ============================================================================
+// Pins
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    drivePin(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return pinLevel(pin);
+}
+
+int digitalPinToInterrupt(int pin) {
+    return pin;
+}
+
+void attachInterrupt(int interrupt, void (*handler)(), int mode) {
+    // digitalPinToInterrupt() maps pins 1:1
+    uint8_t slot = (uint8_t)interrupt % sizeof(s_pinLevels);
+    s_pinHandlers[slot] = handler;
+    s_pinModes[slot] = mode;
+}
+
+void detachInterrupt(int interrupt) {
+    s_pinHandlers[(uint8_t)interrupt % sizeof(s_pinLevels)] = nullptr;
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+// ============================================================================
+// Time
+// ============================================================================
+
+uint32_t millis() {
+    return (uint32_t)(s_nowUs / 1000);
+}
+
+uint32_t micros() {
+    // Reading the clock takes time, so spin loops on micros() end
+    return (uint32_t)(s_nowUs++);
+}
+
+void delay(uint32_t ms) {
+    s_nowUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+    s_nowUs += us;
+}
+
+namespace fake {
+
+void advanceMicros(uint32_t us) {
+    s_nowUs += us;
+}
+
+void advanceMillis(uint32_t ms) {
+    s_nowUs += (uint64_t)ms * 1000;
+}
+
+void setPin(uint8_t pin, uint8_t value) {
+    drivePin(pin, value);
+}
+
+} // namespace fake
+
+// ============================================================================
+// Print
+// ============================================================================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && write(buffer[n])) {
+        n++;
+    }
+    return n;
+}
+
+size_t Print::write(const char* buffer, size_t size) {
+    return write((const uint8_t*)buffer, size);
+}
+
+int Print::availableForWrite() {
+    return 0;
+}
+
+void Print::flush() {
+}
+
+size_t Print::print(const char* str) {
+    return write(str, strlen(str));
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(int value, int base) {
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+    if (value < 0 && base == DEC) {
+        return printNumber((unsigned long)-value, base, true);
+    }
+    return printNumber((unsigned long)value, base, false);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return printNumber(value, base, false);
+}
+
+size_t Print::println() {
+    return write("\r\n", 2);
+}
+
+size_t Print::println(const char* str) {
+    return print(str) + println();
+}
+
+size_t Print::println(char c) {
+    return print(c) + println();
+}
+
+size_t Print::println(int value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::printNumber(unsigned long value, int base, bool negative) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%s%lX" : "%s%lu", negative ? "-" : "", value);
+    return print(buffer);
+}
+
+// ============================================================================
+// Stream
+// ============================================================================
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    return readBytes((uint8_t*)buffer, length);
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    // No timeout - the fake never waits for data
+    size_t n = 0;
+    while (n < length && available() > 0) {
+        buffer[n++] = (uint8_t)read();
+    }
+    return n;
+}
+
+void Stream::setTimeout(unsigned long timeout) {
+    (void)timeout;
+}
+
+// ============================================================================
+// HardwareSerial
+// ============================================================================
+
+HardwareSerial::HardwareSerial()
+    : m_rxPos(0)
+    , m_txBytes(0)
+    , m_txLines(0)
+    , m_txRoom(-1)
+    , m_baud(0)
+{
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    m_baud = baud;
+}
+
+void HardwareSerial::end() {
+}
+
+HardwareSerial::operator bool() const {
+    return true;
+}
+
+int HardwareSerial::available() {
+    size_t pending = m_rx.size() - m_rxPos;
+    return (int)(pending < RX_BUFFER_BYTES ? pending : RX_BUFFER_BYTES);
+}
+
+int HardwareSerial::read() {
+    if (m_rxPos >= m_rx.size()) {
+        return -1;
+    }
+    
+    int c = (uint8_t)m_rx[m_rxPos++];
+    
+    // Drop consumed input once everything was read
+    if (m_rxPos == m_rx.size()) {
+        m_rx.clear();
+        m_rxPos = 0;
+    }
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return m_rxPos < m_rx.size() ? (uint8_t)m_rx[m_rxPos] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (m_txRoom >= 0 && size > (size_t)m_txRoom) {
+        size = (size_t)m_txRoom;
+    }
+    
+    for (size_t i = 0; i < size; i++) {
+        if (buffer[i] == '\n') {
+            m_txLines++;
+        }
+    }
+    m_txBytes += size;
+    
+    if (m_output.size() < MAX_OUTPUT) {
+        m_output.append((const char*)buffer, size);
+    }
+    return size;
+}
+
+int HardwareSerial::availableForWrite() {
+    // Plenty of room unless a test limits it
+    if (m_txRoom == TX_ROOM_UNREPORTED) {
+        return 0;
+    }
+    return m_txRoom >= 0 ? m_txRoom : 4096;
+}
+
+void HardwareSerial::flush() {
+}
+
+void HardwareSerial::inject(const uint8_t* data, size_t length) {
+    m_rx.append((const char*)data, length);
+}
+
+void HardwareSerial::inject(const char* str) {
+    m_rx.append(str);
+}
+
+void HardwareSerial::setTxRoom(int room) {
+    m_txRoom = room;
+}
+
+void HardwareSerial::reset() {
+    m_rx.clear();
+    m_rxPos = 0;
+    m_output.clear();
+    m_txBytes = 0;
+    m_txLines = 0;
+    m_txRoom = -1;
+}
+
+const std::string& HardwareSerial::output() const {
+    return m_output;
+}
+
+void HardwareSerial::clearOutput() {
+    m_output.clear();
+}
+
+uint32_t HardwareSerial::txBytes() const {
+    return m_txBytes;
+}
+
+uint32_t HardwareSerial::txLines() const {
+    return m_txLines;
+}
+
+unsigned long HardwareSerial::baud() const {
+    return m_baud;
+}
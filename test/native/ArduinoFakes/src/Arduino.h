@@ -0,0 +1,234 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core for the native (host) test environment
+ *
+ * Only what the firmware sources use. Time is virtual: millis()/micros()
+ * only move when the test advances them, when delay() is called, or when
+ * a fake bus transfer takes time. Every micros() read also advances the
+ * clock by 1us so busy-wait loops (I2C turnaround guard) terminate.
+ *
+ * Serial keeps an RX buffer the test fills with inject() and counts the
+ * bytes and lines written to it. Like the core's driver buffer, at most
+ * RX_BUFFER_BYTES of the injected data are available at a time; the rest
+ * is still "on the wire". Output is kept up to a limit so tests can look
+ * at replies.
+ */
+
+#ifndef ARDUINO_FAKE_H
+#define ARDUINO_FAKE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// ============================================================================
+// Pins
+// ============================================================================
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+
+#define A4 18
+#define A5 19
+
+#define DEC 10
+#define HEX 16
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int interrupt, void (*handler)(), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+// ============================================================================
+// Time
+// ============================================================================
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+namespace fake {
+
+/**
+ * @brief Move the virtual clock forward
+ * @param us Microseconds
+ */
+void advanceMicros(uint32_t us);
+
+/**
+ * @brief Move the virtual clock forward
+ * @param ms Milliseconds
+ */
+void advanceMillis(uint32_t ms);
+
+/**
+ * @brief Set a pin level as seen by digitalRead()
+ *
+ * A handler attached with attachInterrupt() runs right away when the
+ * change matches its edge, like an ISR preempting the caller.
+ *
+ * @param pin Pin number
+ * @param value LOW or HIGH
+ */
+void setPin(uint8_t pin, uint8_t value);
+
+} // namespace fake
+
+// ============================================================================
+// Serial
+// ============================================================================
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* buffer, size_t size);
+    virtual int availableForWrite();
+    virtual void flush();
+
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+
+    size_t println();
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+
+private:
+    size_t printNumber(unsigned long value, int base, bool negative);
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length);
+    void setTimeout(unsigned long timeout);
+};
+
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial();
+
+    void begin(unsigned long baud);
+    void end();
+    operator bool() const;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;
+
+    // === Test Hooks ===
+
+    /**
+     * @brief Append bytes to the receive buffer
+     * @param data Bytes the Pi sent
+     * @param length Number of bytes
+     */
+    void inject(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Append a string to the receive buffer
+     * @param str Text the Pi sent (include the '\n')
+     */
+    void inject(const char* str);
+
+    /**
+     * @brief Limit what write() accepts, like a full TX FIFO
+     * @param room Bytes availableForWrite() reports (-1 = unlimited,
+     *             TX_ROOM_UNREPORTED = report 0 but accept everything)
+     */
+    void setTxRoom(int room);
+
+    /**
+     * @brief Drop received and sent data and reset the counters
+     */
+    void reset();
+
+    /**
+     * @brief Get the kept output (up to MAX_OUTPUT bytes since the last reset)
+     * @return Output
+     */
+    const std::string& output() const;
+
+    /**
+     * @brief Drop the kept output
+     */
+    void clearOutput();
+
+    /**
+     * @brief Get number of bytes written since the last reset
+     * @return Byte count
+     */
+    uint32_t txBytes() const;
+
+    /**
+     * @brief Get number of '\n' written since the last reset
+     * @return Line count
+     */
+    uint32_t txLines() const;
+
+    /**
+     * @brief Get the baud rate of the last begin()
+     * @return Baud rate
+     */
+    unsigned long baud() const;
+
+    // UNO R4 core serial RX buffer
+    static constexpr size_t RX_BUFFER_BYTES = 512;
+
+    // setTxRoom(): like the UNO R4 UART, which doesn't implement
+    // availableForWrite() (Print's default of 0)
+    static constexpr int TX_ROOM_UNREPORTED = -2;
+
+    static constexpr size_t MAX_OUTPUT = 256 * 1024;
+
+private:
+    std::string m_rx;
+    size_t m_rxPos;
+    std::string m_output;
+    uint32_t m_txBytes;
+    uint32_t m_txLines;
+    int m_txRoom;
+    unsigned long m_baud;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial SerialUSB;
+
+#endif // ARDUINO_FAKE_H
@@ -0,0 +1,42 @@
+/**
+ * @file EEPROM.cpp
+ * @brief Implementation of the EEPROM fake
+ */
+
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+    erase();
+}
+
+uint8_t EEPROMClass::read(int index) {
+    return (index >= 0 && index < SIZE) ? m_data[index] : 0xFF;
+}
+
+void EEPROMClass::write(int index, uint8_t value) {
+    if (index >= 0 && index < SIZE) {
+        m_data[index] = value;
+        m_writes++;
+    }
+}
+
+void EEPROMClass::update(int index, uint8_t value) {
+    if (read(index) != value) {
+        write(index, value);
+    }
+}
+
+uint16_t EEPROMClass::length() {
+    return SIZE;
+}
+
+void EEPROMClass::erase() {
+    memset(m_data, 0xFF, sizeof(m_data));
+    m_writes = 0;
+}
+
+uint32_t EEPROMClass::writeCount() const {
+    return m_writes;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file EEPROM.h
+ * @brief EEPROM fake for the native test environment
+ *
+ * An 8 KB byte array like the UNO R4's data flash, erased to 0xFF. It
+ * keeps its contents across TouchController / SettingsStore instances, so
+ * a test can boot twice and see what the first boot stored.
+ */
+
+#ifndef EEPROM_FAKE_H
+#define EEPROM_FAKE_H
+
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    EEPROMClass();
+
+    uint8_t read(int index);
+    void write(int index, uint8_t value);
+    void update(int index, uint8_t value);
+    uint16_t length();
+
+    // === Test Hooks ===
+
+    /**
+     * @brief Erase every byte to 0xFF and reset the write counter
+     */
+    void erase();
+
+    /**
+     * @brief Get number of bytes written since the last erase
+     * @return Write count
+     */
+    uint32_t writeCount() const;
+
+    static constexpr uint16_t SIZE = 8192;
+
+private:
+    uint8_t m_data[SIZE];
+    uint32_t m_writes;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_FAKE_H
@@ -0,0 +1,208 @@
+/**
+ * @file Wire.cpp
+ * @brief Implementation of the I2C fake
+ */
+
+#include "Wire.h"
+
+TwoWire Wire;
+
+// endTransmission() status codes (same as the Arduino core)
+static constexpr uint8_t WIRE_OK = 0;
+static constexpr uint8_t WIRE_NACK_ADDRESS = 2;
+
+// CAP1188 registers the device model reacts to
+static constexpr uint8_t REG_MAIN_CONTROL = 0x00;
+static constexpr uint8_t REG_INPUT_STATUS = 0x03;
+static constexpr uint8_t MAIN_CONTROL_INT = 0x01;
+
+TwoWire::TwoWire()
+    : m_deviceCount(0)
+    , m_clockHz(100000)
+    , m_timeoutUs(25000)
+    , m_transfers(0)
+    , m_txAddress(0)
+    , m_txLength(0)
+    , m_rxLength(0)
+    , m_rxIndex(0)
+{
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::end() {
+}
+
+void TwoWire::setClock(uint32_t clockHz) {
+    m_clockHz = clockHz;
+}
+
+void TwoWire::setWireTimeout(unsigned int timeoutUs, bool resetWithTimeout) {
+    (void)resetWithTimeout;
+    m_timeoutUs = timeoutUs;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    m_txAddress = address;
+    m_txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t value) {
+    if (m_txLength >= sizeof(m_txData)) {
+        return 0;
+    }
+    m_txData[m_txLength++] = value;
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    m_transfers++;
+    busTime(1 + m_txLength);
+    
+    Device* device = find(m_txAddress);
+    if (!device) {
+        return WIRE_NACK_ADDRESS;
+    }
+    
+    // First byte sets the register pointer, the rest are written from there
+    if (m_txLength > 0) {
+        device->pointer = m_txData[0];
+        for (uint8_t i = 1; i < m_txLength; i++) {
+            device->regs[device->pointer++] = m_txData[i];
+        }
+        updateAlerts();
+    }
+    return WIRE_OK;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+    (void)sendStop;
+    m_transfers++;
+    m_rxLength = 0;
+    m_rxIndex = 0;
+    
+    Device* device = find(address);
+    if (!device) {
+        busTime(1);
+        return 0;
+    }
+    
+    if (quantity > sizeof(m_rxData)) {
+        quantity = sizeof(m_rxData);
+    }
+    for (uint8_t i = 0; i < quantity; i++) {
+        m_rxData[m_rxLength++] = device->regs[device->pointer++];
+    }
+    
+    busTime(1 + quantity);
+    return m_rxLength;
+}
+
+int TwoWire::available() {
+    return m_rxLength - m_rxIndex;
+}
+
+int TwoWire::read() {
+    return m_rxIndex < m_rxLength ? m_rxData[m_rxIndex++] : -1;
+}
+
+void TwoWire::attach(uint8_t address) {
+    if (find(address) || m_deviceCount >= MAX_DEVICES) {
+        return;
+    }
+    
+    Device& device = m_devices[m_deviceCount++];
+    device.address = address;
+    device.pointer = 0;
+    memset(device.regs, 0, sizeof(device.regs));
+    device.alertPin = NO_ALERT_PIN;
+}
+
+void TwoWire::reset() {
+    // Release the ALERT lines before the devices go away
+    for (uint8_t i = 0; i < m_deviceCount; i++) {
+        if (m_devices[i].alertPin != NO_ALERT_PIN) {
+            fake::setPin(m_devices[i].alertPin, HIGH);
+        }
+    }
+    m_deviceCount = 0;
+    m_transfers = 0;
+    m_txLength = 0;
+    m_rxLength = 0;
+    m_rxIndex = 0;
+}
+
+void TwoWire::setRegister(uint8_t address, uint8_t reg, uint8_t value) {
+    Device* device = find(address);
+    if (!device) {
+        return;
+    }
+    if (reg == REG_INPUT_STATUS && device->regs[reg] != value) {
+        device->regs[REG_MAIN_CONTROL] |= MAIN_CONTROL_INT;
+    }
+    device->regs[reg] = value;
+    updateAlerts();
+}
+
+uint8_t TwoWire::getRegister(uint8_t address, uint8_t reg) const {
+    for (uint8_t i = 0; i < m_deviceCount; i++) {
+        if (m_devices[i].address == address) {
+            return m_devices[i].regs[reg];
+        }
+    }
+    return 0;
+}
+
+void TwoWire::setAlertPin(uint8_t address, uint8_t pin) {
+    Device* device = find(address);
+    if (device) {
+        device->alertPin = pin;
+        updateAlerts();
+    }
+}
+
+uint32_t TwoWire::wireTimeout() const {
+    return m_timeoutUs;
+}
+
+uint32_t TwoWire::transferCount() const {
+    return m_transfers;
+}
+
+TwoWire::Device* TwoWire::find(uint8_t address) {
+    for (uint8_t i = 0; i < m_deviceCount; i++) {
+        if (m_devices[i].address == address) {
+            return &m_devices[i];
+        }
+    }
+    return nullptr;
+}
+
+void TwoWire::busTime(uint8_t bytes) {
+    // 9 clocks per byte (8 data + ACK), plus start/stop
+    uint32_t clocks = (uint32_t)bytes * 9 + 2;
+    fake::advanceMicros((uint32_t)((uint64_t)clocks * 1000000 / m_clockHz));
+}
+
+void TwoWire::updateAlerts() {
+    for (uint8_t i = 0; i < m_deviceCount; i++) {
+        uint8_t pin = m_devices[i].alertPin;
+        if (pin == NO_ALERT_PIN) {
+            continue;
+        }
+        
+        bool asserted = false;
+        for (uint8_t j = 0; j < m_deviceCount; j++) {
+            if (m_devices[j].alertPin == pin &&
+                (m_devices[j].regs[REG_MAIN_CONTROL] & MAIN_CONTROL_INT)) {
+                asserted = true;
+                break;
+            }
+        }
+        if (digitalRead(pin) != (asserted ? LOW : HIGH)) {
+            fake::setPin(pin, asserted ? LOW : HIGH);
+        }
+    }
+}
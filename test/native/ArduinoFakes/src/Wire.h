@@ -0,0 +1,139 @@
+/**
+ * @file Wire.h
+ * @brief I2C fake for the native test environment
+ *
+ * Attached devices behave like a CAP1188: a 256-byte register file that
+ * is read and written through the usual register-pointer transfers. A test
+ * sets the touch status with setRegister(address, 0x03, bits).
+ *
+ * A status change sets the INT bit (0x00 bit 0) like the chip does. A
+ * device given an ALERT pin with setAlertPin() holds that pin low while
+ * INT is set (open drain, shared with the other devices on the pin), so
+ * an interrupt handler attached to it runs on the falling edge.
+ *
+ * Transfers to unattached addresses NACK. Each transfer advances the
+ * virtual clock by its time on the wire at the current bus clock, so
+ * time-sliced bus code sees realistic budgets.
+ */
+
+#ifndef WIRE_FAKE_H
+#define WIRE_FAKE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    TwoWire();
+
+    void begin();
+    void end();
+    void setClock(uint32_t clockHz);
+    void setWireTimeout(unsigned int timeoutUs = 25000, bool resetWithTimeout = false);
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    int available();
+    int read();
+
+    // === Test Hooks ===
+
+    /**
+     * @brief Add a device that ACKs its address
+     * @param address I2C address
+     */
+    void attach(uint8_t address);
+
+    /**
+     * @brief Remove all devices and reset the counters
+     */
+    void reset();
+
+    /**
+     * @brief Set a device register
+     * @param address I2C address
+     * @param reg Register address
+     * @param value Value
+     */
+    void setRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Get a device register
+     * @param address I2C address
+     * @param reg Register address
+     * @return Value (0 if no such device)
+     */
+    uint8_t getRegister(uint8_t address, uint8_t reg) const;
+
+    /**
+     * @brief Wire a device's ALERT output to a pin
+     * @param address I2C address
+     * @param pin Pin driven low while INT is set
+     */
+    void setAlertPin(uint8_t address, uint8_t pin);
+
+    /**
+     * @brief Get the timeout set with setWireTimeout()
+     * @return Timeout (us)
+     */
+    uint32_t wireTimeout() const;
+
+    /**
+     * @brief Get number of transfers since the last reset
+     * @return Transfer count
+     */
+    uint32_t transferCount() const;
+
+private:
+    static constexpr uint8_t MAX_DEVICES = 32;
+    static constexpr uint8_t NO_ALERT_PIN = 0xFF;
+
+    struct Device {
+        uint8_t address;
+        uint8_t pointer;        // Register pointer
+        uint8_t regs[256];
+        uint8_t alertPin;       // NO_ALERT_PIN if not wired
+    };
+
+    Device m_devices[MAX_DEVICES];
+    uint8_t m_deviceCount;
+
+    uint32_t m_clockHz;
+    uint32_t m_timeoutUs;
+    uint32_t m_transfers;
+
+    // Transfer being built by beginTransmission()/write()
+    uint8_t m_txAddress;
+    uint8_t m_txData[8];
+    uint8_t m_txLength;
+
+    // Bytes returned by requestFrom()
+    uint8_t m_rxData[8];
+    uint8_t m_rxLength;
+    uint8_t m_rxIndex;
+
+    /**
+     * @brief Find an attached device
+     * @param address I2C address
+     * @return Device, or nullptr if none answers at that address
+     */
+    Device* find(uint8_t address);
+
+    /**
+     * @brief Advance the virtual clock by the time a transfer takes
+     * @param bytes Bytes on the wire, including the address byte
+     */
+    void busTime(uint8_t bytes);
+
+    /**
+     * @brief Drive every wired ALERT pin from the INT bits
+     *
+     * A pin is low while any device on it has INT set.
+     */
+    void updateAlerts();
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_FAKE_H
@@ -0,0 +1,514 @@
+/**
+ * @file test_main.cpp
+ * @brief Host benchmarks for the hot paths of the firmware
+ *
+ * Run with: pio test -e native -v
+ *
+ * Each benchmark drives the real firmware classes through their public
+ * API against the fakes in test/native/ArduinoFakes, under a scripted
+ * load, and prints the best of BENCH_ROUNDS rounds in ns per operation.
+ * A benchmark fails when it is slower than its budget.
+ *
+ * Budgets are host numbers, set well above what a desktop machine needs
+ * so only real regressions fail. Compare the printed numbers before and
+ * after a change for anything finer. Slow machines or sanitizer builds
+ * can scale all budgets with -D BENCH_BUDGET_SCALE=<n>.
+ *
+ * Time seen by the firmware is virtual (see the Arduino.h fake); the
+ * harness measures wall time with std::chrono.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <EEPROM.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "Config.h"
+#include "CommandController.h"
+#include "EventQueue.h"
+#include "LedController.h"
+#include "SettingsStore.h"
+#include "TouchController.h"
+
+// ============================================================================
+// Benchmark Configuration
+// ============================================================================
+
+#ifndef BENCH_BUDGET_SCALE
+#define BENCH_BUDGET_SCALE 1
+#endif
+
+// Rounds per benchmark; the fastest one is reported
+constexpr uint8_t BENCH_ROUNDS = 5;
+
+// Budgets (ns per operation)
+constexpr double BUDGET_COMMAND_LINE_NS = 20000.0 * BENCH_BUDGET_SCALE;
+constexpr double BUDGET_EVENT_NS = 5000.0 * BENCH_BUDGET_SCALE;
+constexpr double BUDGET_TOUCH_TICK_NS = 10000.0 * BENCH_BUDGET_SCALE;
+constexpr double BUDGET_TOUCH_BOOT_NS = 500000.0 * BENCH_BUDGET_SCALE;
+constexpr double BUDGET_LED_FRAME_NS = 50000.0 * BENCH_BUDGET_SCALE;
+
+// Frame tick spacing for LedController::update() (ms)
+constexpr uint32_t FRAME_STEP_MS = 1000 / LED_FRAME_RATE_HZ + 1;
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+/**
+ * @brief Run a benchmark and check it against its budget
+ * @param name Name printed with the result
+ * @param ops Operations per round
+ * @param budgetNs Budget (ns per operation)
+ * @param setup Called before each round (not timed)
+ * @param round One round of ops operations
+ */
+template <typename Setup, typename Round>
+static void runBenchmark(const char* name, uint32_t ops, double budgetNs, Setup setup, Round round) {
+    double best = 0;
+    
+    for (uint8_t r = 0; r < BENCH_ROUNDS; r++) {
+        setup();
+        
+        auto start = std::chrono::steady_clock::now();
+        round();
+        auto end = std::chrono::steady_clock::now();
+        
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+        if (r == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    
+    char message[128];
+    snprintf(message, sizeof(message), "%-28s %10.0f ns/op  (budget %.0f, %lu ops)",
+             name, best, budgetNs, (unsigned long)ops);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(best <= budgetNs, message);
+}
+
+/**
+ * @brief Count occurrences of a string in the fake serial output
+ * @param needle String to count
+ * @return Number of occurrences
+ */
+static uint32_t countOutput(const char* needle) {
+    const std::string& out = Serial.output();
+    uint32_t n = 0;
+    
+    for (size_t pos = out.find(needle); pos != std::string::npos; pos = out.find(needle, pos + 1)) {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Attach a fake CAP1188 at every sensor address, with its ALERT
+ * output on the pin of its group
+ */
+static void attachSensors() {
+    Wire.reset();
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        Wire.attach(SENSOR_I2C_ADDRESSES[i]);
+        Wire.setAlertPin(SENSOR_I2C_ADDRESSES[i], TOUCH_ALERT_PINS[SENSOR_ALERT_GROUPS[i]]);
+    }
+}
+
+/**
+ * @brief Set the raw touch state of all positions on the fake sensors
+ * @param touched Bitmask (bit 0 = A)
+ */
+static void setTouched(uint32_t touched) {
+    // Clear first - several positions can share a chip
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        Wire.setRegister(SENSOR_I2C_ADDRESSES[i], CAP1188_REG_SENSOR_INPUT_STATUS, 0);
+    }
+    for (uint8_t i = 0; i < NUM_TOUCH_SENSORS; i++) {
+        if (touched & (1UL << i)) {
+            uint8_t status = Wire.getRegister(SENSOR_I2C_ADDRESSES[i], CAP1188_REG_SENSOR_INPUT_STATUS);
+            status |= 1 << SENSOR_INPUT_CHANNELS[i];
+            Wire.setRegister(SENSOR_I2C_ADDRESSES[i], CAP1188_REG_SENSOR_INPUT_STATUS, status);
+        }
+    }
+}
+
+// ============================================================================
+// CommandController
+// ============================================================================
+
+// Immediate commands, one ACK each
+static const char* const COMMAND_MIX[] = {
+    "SHOW A #1\n",
+    "HIDE A #2\n",
+    "BLINK C #3\n",
+    "STOP_BLINK C #4\n",
+    "SHOW A,C,F,K,P,U #5\n",
+    "PING #6\n",
+    "HIDE A,C,F,K,P,U #7\n",
+    "show y #4294967294\n"
+};
+constexpr uint8_t COMMAND_MIX_COUNT = sizeof(COMMAND_MIX) / sizeof(COMMAND_MIX[0]);
+
+/**
+ * @brief Burst of ASCII commands: serial poll, line split, parse, execute, ACK
+ */
+static void test_command_burst() {
+    constexpr uint32_t LINES = 512;
+    
+    // Lines arriving per loop iteration (a fast link that keeps the RX busy)
+    constexpr uint8_t LINES_PER_LOOP = 4;
+    
+    EventQueue eventQueue;
+    LedController ledController;
+    CommandController commandController(ledController, nullptr, eventQueue);
+    
+    auto setup = [&]() {
+        Serial.reset();
+        eventQueue.begin();
+        ledController.begin();
+        commandController.begin();
+    };
+    
+    auto round = [&]() {
+        uint32_t sent = 0;
+        
+        // Every line ends in exactly one ACK line
+        for (uint32_t guard = 0; Serial.txLines() < LINES && guard < LINES * 8; guard++) {
+            for (uint8_t i = 0; i < LINES_PER_LOOP && sent < LINES; i++, sent++) {
+                Serial.inject(COMMAND_MIX[sent % COMMAND_MIX_COUNT]);
+            }
+            
+            commandController.pollSerial();
+            commandController.processCompletedLines();
+            commandController.tick();
+            eventQueue.flush();
+        }
+    };
+    
+    runBenchmark("command burst (per line)", LINES, BUDGET_COMMAND_LINE_NS, setup, round);
+    TEST_ASSERT_EQUAL_UINT32(LINES, countOutput("ACK "));
+    TEST_ASSERT_EQUAL_UINT32(0, countOutput("ERR"));
+}
+
+// ============================================================================
+// EventQueue
+// ============================================================================
+
+/**
+ * @brief Queue, format and write touch events
+ * @param binary true to format binary frames, false for ASCII lines
+ */
+static void benchmarkEvents(const char* name, bool binary) {
+    constexpr uint32_t EVENTS = 4096;
+    
+    EventQueue eventQueue;
+    
+    auto setup = [&]() {
+        Serial.reset();
+        eventQueue.begin();
+        if (binary) {
+            eventQueue.queueMode(true);
+            eventQueue.flush();
+        }
+    };
+    
+    auto round = [&]() {
+        for (uint32_t i = 0; i < EVENTS; i++) {
+            char letter = 'A' + (i % NUM_TOUCH_SENSORS);
+            bool queued = (i & 1) ? eventQueue.queueTouchUp(letter)
+                                  : eventQueue.queueAck(CommandAction::SHOW, letter, i);
+            if (!queued || eventQueue.isFull()) {
+                eventQueue.flush();
+            }
+        }
+        while (!eventQueue.isIdle()) {
+            eventQueue.flush();
+        }
+    };
+    
+    runBenchmark(name, EVENTS, BUDGET_EVENT_NS, setup, round);
+}
+
+static void test_event_queue_ascii() {
+    benchmarkEvents("events ascii (per event)", false);
+    TEST_ASSERT_EQUAL_UINT32(4096 / 2, countOutput("TOUCH_UP "));
+}
+
+static void test_event_queue_binary() {
+    benchmarkEvents("events binary (per event)", true);
+    TEST_ASSERT_EQUAL_UINT32(0, countOutput("TOUCH_UP "));
+}
+
+static void test_event_queue_unreported_room() {
+    // Like the UNO R4 UART: availableForWrite() is always 0
+    constexpr uint32_t EVENTS = 200;
+    
+    EventQueue eventQueue;
+    Serial.reset();
+    Serial.setTxRoom(HardwareSerial::TX_ROOM_UNREPORTED);
+    eventQueue.begin();
+    
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        while (!eventQueue.queueAck(CommandAction::PING, 0, i)) {
+            eventQueue.flush();
+        }
+        eventQueue.flush();
+    }
+    for (uint32_t spins = 0; !eventQueue.isIdle() && spins < 1000000; spins++) {
+        eventQueue.flush();
+    }
+    uint32_t elapsed = micros() - start;
+    uint32_t bytes = Serial.txBytes();
+    uint32_t lines = Serial.txLines();
+    Serial.reset();
+    
+    char message[96];
+    snprintf(message, sizeof(message), "  %lu bytes in %lu us without a reported TX room",
+             (unsigned long)bytes, (unsigned long)elapsed);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(eventQueue.isIdle());
+    TEST_ASSERT_EQUAL_UINT32(EVENTS, lines);
+    
+    // Paced to the link rate (10 bits per byte), one fallback chunk ahead at most
+    uint64_t linkUs = (uint64_t)bytes * 10000000ULL / SERIAL_BAUD_RATE;
+    TEST_ASSERT_TRUE(elapsed + SERIAL_TX_FALLBACK_CHUNK * 10000000ULL / SERIAL_BAUD_RATE >= linkUs);
+}
+
+// ============================================================================
+// TouchController
+// ============================================================================
+
+/**
+ * @brief Sensor sweeps and debounce with all 25 positions toggling together
+ */
+static void test_touch_all_toggling() {
+    constexpr uint32_t TICKS = 20000;
+    
+    // Loop iteration time besides the touch tick (virtual us)
+    constexpr uint32_t LOOP_US = 200;
+    
+    // All positions change together this often (virtual ms)
+    constexpr uint32_t TOGGLE_MS = 100;
+    
+    EventQueue eventQueue;
+    TouchController touchController;
+    
+    auto setup = [&]() {
+        Serial.reset();
+        attachSensors();
+        setTouched(0);
+        eventQueue.begin();
+        touchController.setEventQueue(&eventQueue);
+        TEST_ASSERT_TRUE(touchController.begin());
+    };
+    
+    uint32_t presses = 0;
+    uint32_t droppedBefore = 0;
+    
+    auto round = [&]() {
+        uint32_t start = millis();
+        bool touched = false;
+        presses = 0;
+        droppedBefore = eventQueue.getDroppedCount();
+        
+        for (uint32_t i = 0; i < TICKS; i++) {
+            bool shouldTouch = ((millis() - start) / TOGGLE_MS) & 1;
+            if (shouldTouch != touched) {
+                touched = shouldTouch;
+                presses += touched;
+                setTouched(touched ? (1UL << NUM_TOUCH_SENSORS) - 1 : 0);
+            }
+            
+            touchController.tick();
+            eventQueue.flush();
+            fake::advanceMicros(LOOP_US);
+        }
+    };
+    
+    runBenchmark("touch tick, 25 toggling", TICKS, BUDGET_TOUCH_TICK_NS, setup, round);
+    
+    // Release everything and let the last release debounce
+    setTouched(0);
+    for (uint32_t i = 0; i < TICKS / 10; i++) {
+        touchController.tick();
+        eventQueue.flush();
+        fake::advanceMicros(LOOP_US);
+    }
+    
+    // All 25 edges of a sweep are queued at once, so with EVENT_QUEUE_SIZE
+    // below 25 some are dropped - report how many got through
+    uint32_t downs = countOutput("TOUCH_DOWN ");
+    uint32_t ups = countOutput("TOUCH_UP ");
+    uint32_t expected = presses * NUM_TOUCH_SENSORS * 2;
+    uint32_t dropped = eventQueue.getDroppedCount() - droppedBefore;
+    char message[96];
+    snprintf(message, sizeof(message), "touch events delivered: %lu of %lu (%lu dropped)",
+             (unsigned long)(downs + ups), (unsigned long)expected, (unsigned long)dropped);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_TRUE(presses > 0);
+    TEST_ASSERT_TRUE(downs >= presses);
+    
+    if (TOUCH_ALERT_ENABLED) {
+        // ALERT reads every chip in the sweep after the edge, so the presses
+        // overflow the queue and lose downs. The releases drain behind them
+        // and get through; every missing event must show up as dropped.
+        TEST_ASSERT_TRUE(ups >= downs);
+        TEST_ASSERT_TRUE(downs + ups + dropped >= expected);
+    } else {
+        TEST_ASSERT_EQUAL_UINT32(downs, ups);
+    }
+}
+
+/**
+ * @brief TouchController::begin() from the stored sensor map, against a
+ * full probe with nothing stored
+ */
+static void test_touch_boot() {
+    constexpr uint32_t BOOTS = 20;
+    
+    SettingsStore settings;
+    TouchController touchController;
+    touchController.setSettingsStore(&settings);
+    
+    // Virtual boot time (us) with nothing stored
+    attachSensors();
+    EEPROM.erase();
+    settings.begin();
+    uint32_t start = micros();
+    TEST_ASSERT_TRUE(touchController.begin());
+    uint32_t fullUs = micros() - start;
+    
+    uint32_t storedUs = 0;
+    
+    auto setup = [&]() {
+        attachSensors();
+        TEST_ASSERT_TRUE(settings.begin());
+    };
+    
+    auto round = [&]() {
+        for (uint32_t i = 0; i < BOOTS; i++) {
+            uint32_t bootStart = micros();
+            touchController.begin();
+            storedUs = micros() - bootStart;
+        }
+    };
+    
+    runBenchmark("touch boot, stored map", BOOTS, BUDGET_TOUCH_BOOT_NS, setup, round);
+    
+    char message[96];
+    snprintf(message, sizeof(message), "touch boot (virtual): %lu us full, %lu us stored map",
+             (unsigned long)fullUs, (unsigned long)storedUs);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_EQUAL_UINT32((1UL << NUM_TOUCH_SENSORS) - 1, touchController.getActiveSensorMask());
+    // The short boot probe timeout is not kept for the sweeps
+    TEST_ASSERT_EQUAL_UINT32(I2C_TIMEOUT_US, Wire.wireTimeout());
+    if (FAST_BOOT_ENABLED) {
+        TEST_ASSERT_TRUE(storedUs < fullUs);
+    }
+}
+
+// ============================================================================
+// LedController
+// ============================================================================
+
+/**
+ * @brief Render frames of a scripted LED load
+ * @param name Name printed with the result
+ * @param restartFrames Restart the load this often (0 = start once)
+ * @param start Starts (or restarts) the load; called inside the timed loop
+ */
+template <typename Start>
+static void benchmarkFrames(const char* name, uint32_t restartFrames, Start start) {
+    constexpr uint32_t FRAMES = 600;
+    
+    LedController ledController;
+    uint32_t now = 0;
+    
+    auto setup = [&]() {
+        ledController.begin();
+        now = millis();
+    };
+    
+    auto round = [&]() {
+        for (uint32_t i = 0; i < FRAMES; i++) {
+            if (i == 0 || (restartFrames > 0 && i % restartFrames == 0)) {
+                start(ledController);
+            }
+            now += FRAME_STEP_MS;
+            ledController.update(now);
+        }
+    };
+    
+    runBenchmark(name, FRAMES, BUDGET_LED_FRAME_NS, setup, round);
+}
+
+static void test_led_25_blinks() {
+    // Blink phase flips every BLINK_FRAMES frames; the frames between are idle
+    benchmarkFrames("led frame, 25 blinks", 0, [](LedController& led) {
+        for (uint8_t p = 0; p < NUM_POSITIONS; p++) {
+            led.blink(p);
+        }
+    });
+}
+
+static void test_led_25_success() {
+    benchmarkFrames("led frame, 25 success", SUCCESS_ANIMATION_MS / FRAME_STEP_MS, [](LedController& led) {
+        for (uint8_t p = 0; p < NUM_POSITIONS; p++) {
+            led.show(p);
+            led.success(p);
+        }
+    });
+}
+
+static void test_led_celebration() {
+    benchmarkFrames("led frame, celebration", SEQUENCE_ANIMATION_MS / FRAME_STEP_MS, [](LedController& led) {
+        for (uint8_t p = 0; p < NUM_POSITIONS; p += 2) {
+            led.blink(p);
+        }
+        led.startSequenceCompletedAnimation();
+    });
+}
+
+static void test_led_stream() {
+    // Pi-rendered animation: the whole framebuffer changes every frame
+    static uint8_t pixels[NUM_LEDS_TOTAL * 3];
+    static uint8_t shade = 0;
+    
+    benchmarkFrames("led frame, full FRAME stream", 1, [](LedController& led) {
+        memset(pixels, shade++, sizeof(pixels));
+        led.writePixels(0, pixels, NUM_LEDS_TOTAL);
+    });
+}
+
+// ============================================================================
+// Unity
+// ============================================================================
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    
+    UNITY_BEGIN();
+    RUN_TEST(test_command_burst);
+    RUN_TEST(test_event_queue_ascii);
+    RUN_TEST(test_event_queue_binary);
+    RUN_TEST(test_event_queue_unreported_room);
+    RUN_TEST(test_touch_all_toggling);
+    RUN_TEST(test_touch_boot);
+    RUN_TEST(test_led_25_blinks);
+    RUN_TEST(test_led_25_success);
+    RUN_TEST(test_led_celebration);
+    RUN_TEST(test_led_stream);
+    return UNITY_END();
+}